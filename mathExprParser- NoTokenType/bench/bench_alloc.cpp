@@ -0,0 +1,159 @@
+// Allocation check for the steady state parse path: a reused Lexer, tokens in
+// a ParseArena rewound per input, a reused LL1PushParser and LL1Engine.
+// counts what goes through a TrackingResource per phase and every global
+// operator new (bench_util.h), first on a cold pass over the inputs, then
+// on warm passes. exits 1 if a warm pass hits the heap.
+//
+// g++ -O2 -pthread -I include bench/bench_alloc.cpp -o bench_alloc
+// ./bench_alloc [--inputs N] [--passes N] [--json alloc.json]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "bench_util.h"
+#include "../include/lexer.h"
+#include "../include/LL1_push_parser.h"
+#include "../include/parse_table_gen.h"
+#include "../include/ll1_engine.h"
+#include "../include/alloc_tracking.h"
+
+// a mix of short declarations and a few long ones (the long ones size the arena)
+std::vector<std::string> makeInputs(size_t n) {
+  static const char* types[] = { "int", "float", "char" };
+  std::vector<std::string> inputs;
+  uint64_t x = 88172645463325252ull;
+  for (size_t i = 0; i < n; ++i) {
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    if (i % 50 == 0) {
+      inputs.push_back(makeDeclInput(4096));
+      continue;
+    }
+    std::string s = std::string(types[x % 3]) + " v" + std::to_string(i);
+    for (size_t k = 0; k < x % 8; ++k) s += " , w" + std::to_string(k);
+    inputs.push_back(s + " ;");
+  }
+  return inputs;
+}
+
+struct PassResult {
+  uint64_t heapAllocs = 0;   // every operator new in the pass
+  uint64_t heapBytes = 0;
+  bool allAccepted = true;
+};
+
+int main(int argc, char* argv[]) {
+  size_t inputCount = 10000, passes = 5;
+  std::string jsonOut;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i], val = argv[i + 1];
+    if (key == "--inputs") inputCount = std::stoul(val);
+    else if (key == "--passes") passes = std::stoul(val);
+    else if (key == "--json") jsonOut = val;
+    else std::cerr << "Ignoring unknown option " << key << "\n";
+  }
+
+  std::string grammarFile = "Outputs/bench_decl_grammar.txt";
+  writeFile(grammarFile, "Decl : datatype id L ;\nL : , id L\nL : epsilon\n"
+                         "datatype : int\ndatatype : float\ndatatype : char\n");
+
+  TrackingResource tracker(std::pmr::new_delete_resource());
+
+  ParseTable table;
+  std::set<std::string> terms, nonterms;
+  std::string start;
+  {
+    TrackingResource::Phase phase(tracker, "generate");
+    ParseTableGenerator gen(&tracker);
+    QuietCout quiet;
+    gen.loadGrammar(grammarFile);
+    gen.generateTable();
+    table = gen.getParseTable();
+    terms = gen.getTerminals();
+    nonterms = gen.getNonTerminals();
+    start = gen.getStartSymbol();
+  }
+
+  std::vector<std::string> inputs = makeInputs(inputCount);
+  ParseArena arena(64 << 10, &tracker);
+  Lexer lexer("");
+  LL1PushParser push(table, terms, nonterms, start, &tracker);
+  push.setErrorStream(nullptr);
+  StringLL1Engine engine(table, terms, nonterms, start, RuntimeTokenPolicy::defaults());
+  engine.setErrorStream(nullptr);
+
+  auto runPass = [&](const char* lexPhase, const char* parsePhase) {
+    PassResult r;
+    uint64_t a0 = g_allocCount.load(), b0 = g_allocBytes.load();
+    for (const std::string& text : inputs) {
+      {
+        lexer.reset(text);
+        std::pmr::vector<Token> tokens(arena.resource()); // same resource, so the move below is free
+        {
+          TrackingResource::Phase phase(tracker, lexPhase);
+          tokens = lexer.tokenize(arena.resource());
+        }
+        TrackingResource::Phase phase(tracker, parsePhase);
+        push.reset();
+        for (const Token& t : tokens) {
+          if (!push.feed(t)) break;
+        }
+        r.allAccepted &= push.isAccepted();
+        r.allAccepted &= engine.parse(tokens.data(), tokens.size());
+      } // tokens gone before the rewind
+      arena.rewind();
+    }
+    r.heapAllocs = g_allocCount.load() - a0;
+    r.heapBytes = g_allocBytes.load() - b0;
+    return r;
+  };
+
+  PassResult cold = runPass("lex/cold", "parse/cold");
+  tracker.addPhase("lex/warm");
+  tracker.addPhase("parse/warm");
+  PassResult warm;
+  for (size_t p = 0; p < passes; ++p) {
+    PassResult r = runPass("lex/warm", "parse/warm");
+    warm.heapAllocs += r.heapAllocs;
+    warm.heapBytes += r.heapBytes;
+    warm.allAccepted &= r.allAccepted;
+  }
+
+  // the plain std::vector path, for comparison
+  uint64_t a0 = g_allocCount.load(), b0 = g_allocBytes.load();
+  for (const std::string& text : inputs) {
+    Lexer l(text);
+    std::vector<Token> tokens = l.tokenize();
+    engine.parse(tokens);
+  }
+  uint64_t plainAllocs = g_allocCount.load() - a0, plainBytes = g_allocBytes.load() - b0;
+
+  std::printf("%zu inputs, 1 cold + %zu warm passes\n\n", inputs.size(), passes);
+  std::printf("through the tracking resource:\n%s\n", tracker.report().c_str());
+  std::printf("%-28s %12s %14s %12s\n", "operator new", "allocs", "bytes", "per input");
+  std::printf("%-28s %12llu %14llu %12.2f\n", "cold pass", (unsigned long long)cold.heapAllocs,
+              (unsigned long long)cold.heapBytes, (double)cold.heapAllocs / inputs.size());
+  std::printf("%-28s %12llu %14llu %12.2f\n", "warm passes", (unsigned long long)warm.heapAllocs,
+              (unsigned long long)warm.heapBytes, (double)warm.heapAllocs / (inputs.size() * passes));
+  std::printf("%-28s %12llu %14llu %12.2f\n", "Lexer(text).tokenize()", (unsigned long long)plainAllocs,
+              (unsigned long long)plainBytes, (double)plainAllocs / inputs.size());
+
+  if (!jsonOut.empty()) {
+    std::ofstream out(jsonOut);
+    out << "{\"inputs\": " << inputs.size() << ", \"warm_passes\": " << passes
+        << ", \"cold_heap_allocs\": " << cold.heapAllocs << ", \"warm_heap_allocs\": " << warm.heapAllocs
+        << ", \"plain_heap_allocs\": " << plainAllocs << ", \"resource\": " << tracker.toJson() << "}\n";
+  }
+
+  if (!cold.allAccepted || !warm.allAccepted) {
+    std::cerr << "\nSome inputs were not accepted.\n";
+    return 1;
+  }
+  if (warm.heapAllocs) {
+    std::cerr << "\nSteady state parse path allocated " << warm.heapAllocs << " times.\n";
+    return 1;
+  }
+  std::cout << "\nSteady state parse path: no heap allocations.\n";
+  return 0;
+}
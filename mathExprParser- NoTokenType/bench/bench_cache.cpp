@@ -0,0 +1,110 @@
+// Compiling every request from scratch vs going through ExprCache,
+// with a stream of requests drawn from a small set of distinct expressions
+// (written with varying whitespace so normalization matters).
+// checks (exits 1 on a failure) that texts whose spaces decide the tokens,
+// like "2e+5" (200000) and "2e + 5" (2 e + 5, a syntax error), get the same
+// result through the cache as compiled directly, in either order.
+//
+// g++ -O2 -pthread -I include bench/bench_cache.cpp -o bench_cache
+// ./bench_cache [requests] [distinct expressions] [cache capacity] [threads]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "../include/expr_cache.h"
+
+// value with every variable 1, or "error" if the text doesn't parse
+template <class Compile>
+std::string evaluate(Compile compile, const std::string& text) {
+  try {
+    std::shared_ptr<const CompiledExpr> c = compile(text);
+    std::vector<double> vars(c->bytecode.variables.size(), 1.0);
+    ExprVM vm(c->bytecode);
+    return std::to_string(vm.run(c->bytecode, vars.data()));
+  } catch (const std::exception&) {
+    return "error";
+  }
+}
+
+int checkSpacing() {
+  std::vector<std::vector<std::string>> groups = {
+    {"2e+5", "2e + 5", "2e +5", "2e+ 5", "2 e+5"},
+    {"3E-2*x", "3E - 2*x", "3E -2 * x", "3E- 2*x"},
+    {"1.5e+3", "1.5e + 3", "1.5 e+3"},
+    {"x2e + 5", "x2e+5", "x2e +5"},
+  };
+  int failures = 0;
+  for (const auto& g : groups) {
+    for (int order = 0; order < 2; ++order) { // forwards and backwards into a fresh cache
+      ExprCache cache;
+      for (size_t k = 0; k < g.size(); ++k) {
+        const std::string& text = g[order ? g.size() - 1 - k : k];
+        std::string want = evaluate(ExprCache::compile, text);
+        std::string got = evaluate([&](const std::string& t) { return cache.get(t); }, text);
+        if (got != want) {
+          std::cerr << "MISMATCH on \"" << text << "\": cached " << got << ", compiled " << want << "\n";
+          failures++;
+        }
+      }
+    }
+  }
+  return failures;
+}
+
+int main(int argc, char* argv[]) {
+  int failures = checkSpacing();
+
+  size_t requests = argc > 1 ? std::stoul(argv[1]) : 200000;
+  size_t distinct = argc > 2 ? std::stoul(argv[2]) : 500;
+  size_t capacity = argc > 3 ? std::stoul(argv[3]) : 1024;
+  size_t threads = argc > 4 ? std::stoul(argv[4]) : 4;
+
+  std::mt19937_64 rng(3);
+  std::vector<std::string> pool;
+  for (size_t i = 0; i < distinct; ++i) {
+    std::string e = "(a" + std::to_string(i) + " + b) * (c - " + std::to_string(i % 7 + 1) +
+                    ") / (d + e * f" + std::to_string(i % 13) + ") - g * 2";
+    pool.push_back(e);
+  }
+  // request stream, skewed towards the first expressions
+  std::vector<std::string> stream;
+  std::geometric_distribution<size_t> pick(5.0 / distinct);
+  for (size_t i = 0; i < requests; ++i) {
+    std::string e = pool[pick(rng) % distinct];
+    if (i % 2) e = "  " + e + " "; // same expression, different spacing
+    stream.push_back(e);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  size_t sink = 0;
+  for (const auto& e : stream) sink += ExprCache::compile(e)->bytecode.code.size();
+  double tRaw = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "no cache:\t" << (tRaw * 1e9 / requests) << " ns/request\n";
+
+  ExprCache cache(capacity);
+  start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t]() {
+      for (size_t i = t; i < stream.size(); i += threads) cache.get(stream[i]);
+    });
+  }
+  for (auto& w : workers) w.join();
+  double tCache = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  ExprCacheStats st = cache.getStats();
+  std::cout << "cached (" << threads << " threads):\t" << (tCache * 1e9 / requests) << " ns/request\n"
+            << "hits " << st.hits << ", misses " << st.misses << ", evictions " << st.evictions
+            << ", size " << st.size << "\n"
+            << "hit rate " << (100.0 * st.hits / requests) << "%, speedup " << (tRaw / tCache) << "x"
+            << " (checksum " << sink << ")\n";
+  if (failures) {
+    std::cerr << failures << " checks failed.\n";
+    return 1;
+  }
+  return 0;
+}
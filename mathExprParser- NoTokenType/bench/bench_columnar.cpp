@@ -0,0 +1,82 @@
+// Row at a time VM vs columnar block evaluation (1 thread and the whole pool)
+// over generated columns of doubles.
+//
+// g++ -O2 -march=native -pthread -I include bench/bench_columnar.cpp -o bench_columnar
+// ./bench_columnar ["expression"] [rows] [threads]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "../include/expr_ast.h"
+#include "../include/expr_vm.h"
+#include "../include/columnar_eval.h"
+
+int main(int argc, char* argv[]) {
+  std::string text = argc > 1 ? argv[1] : "(a + b) * (c - d) / (e + 2) + a * b * 3 - (c / (d + 1))";
+  size_t rows = argc > 2 ? std::stoul(argv[2]) : 10000000;
+  size_t threads = argc > 3 ? std::stoul(argv[3]) : std::thread::hardware_concurrency();
+
+  ExprTree tree = parseExpression(text);
+  Bytecode bc = compileExpr(tree);
+  size_t nvars = bc.variables.size();
+  std::cout << "Expression: " << text << "\n" << rows << " rows, " << nvars << " columns\n";
+
+  std::vector<std::vector<double>> data(nvars, std::vector<double>(rows));
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> dist(1.0, 100.0);
+  for (auto& col : data) for (auto& v : col) v = dist(rng);
+  std::vector<const double*> columns;
+  for (auto& col : data) columns.push_back(col.data());
+
+  std::vector<double> expected(rows), out(rows);
+
+  auto report = [&](const char* name, double s) {
+    std::cout << name << ":\t" << (s * 1000) << " ms\t" << (rows / s / 1e6) << " M rows/s\n";
+  };
+
+  // row at a time through the VM, row-major bindings gathered on the fly
+  {
+    ExprVM vm(bc);
+    std::vector<double> vars(nvars ? nvars : 1);
+    auto start = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rows; ++r) {
+      for (size_t v = 0; v < nvars; ++v) vars[v] = data[v][r];
+      expected[r] = vm.run(bc, vars.data());
+    }
+    report("vm per row", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  ColumnarEvaluator eval(bc);
+  auto check = [&]() {
+    for (size_t r = 0; r < rows; ++r) {
+      if (out[r] != expected[r] && !(out[r] != out[r] && expected[r] != expected[r])) {
+        std::cerr << "Mismatch at row " << r << ": " << out[r] << " vs " << expected[r] << "\n";
+        return false;
+      }
+    }
+    return true;
+  };
+
+  {
+    auto start = std::chrono::steady_clock::now();
+    eval.evaluate(columns, 0, rows, out.data());
+    report("columnar x1", std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    if (!check()) return 1;
+  }
+
+  {
+    WorkStealingPool pool(threads);
+    std::fill(out.begin(), out.end(), 0.0);
+    auto start = std::chrono::steady_clock::now();
+    eval.evaluate(columns, rows, out.data(), pool);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::string name = "columnar x" + std::to_string(pool.size());
+    report(name.c_str(), s);
+    if (!check()) return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,183 @@
+// LL1Engine with the dense [nonterminal][kind] table vs CombParseTable (row
+// displacement + a default production per row, include/parse_table_layout.h)
+// on the expression grammar and on big generated grammars:
+//
+//   S : R0 S | epsilon     R0 : t0 id R1 | u0 R1 | id   ...   Rn : ;
+//
+// (largeGrammarText, 2n + 3 terminals). the input walks down the chain, so
+// every row gets used. prints the table sizes and the compression ratio,
+// then ns per token for both layouts. checks (exits 1 on a failure): both
+// layouts accept the input, and reject the same mutated copies of it.
+//
+// g++ -O2 -pthread -I include bench/bench_comb_table.cpp -o bench_comb_table
+// ./bench_comb_table [--sizes small,medium,huge] [--huge BYTES] [--json results.json]
+//                    [--baseline baseline.json] [--threshold PCT]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <chrono>
+
+#include "bench_util.h"
+#include "../include/lexer.h"
+#include "../include/parse_table_gen.h"
+#include "../include/ll1_engine.h"
+
+// tokens that already know their kind (one per terminal of the grammar), so
+// the lexer's hash lookups don't hide the table's cost
+struct KindToken {
+  size_t kind;
+  std::string lexeme;
+};
+
+struct KindPolicy {
+  static constexpr size_t fixedKinds = 0;
+  std::vector<std::string> names;
+
+  size_t kindCount() const { return names.size(); }
+  std::string terminalName(size_t k) const { return names[k]; }
+  template <class Tok>
+  size_t kindOf(const Tok& t) const { return t.kind; }
+};
+
+struct Rng {
+  uint64_t x = 88172645463325252ull;
+  uint64_t next() {
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    return x;
+  }
+};
+
+// sentences of S down the chain of n rules, about count tokens
+std::vector<KindToken> makeChainInput(size_t n, size_t count, std::map<std::string, size_t>& kinds) {
+  std::vector<KindToken> tokens;
+  auto push = [&](const std::string& t) { tokens.push_back({kinds.at(t), t}); };
+  Rng r;
+  while (tokens.size() < count) {
+    size_t i = 0;
+    for (; i < n; ++i) {
+      uint64_t x = r.next();
+      if (x % n == 0) break; // R_i : id
+      if (x & 1) {
+        push("t" + std::to_string(i));
+        push("id");
+      } else {
+        push("u" + std::to_string(i));
+      }
+    }
+    push(i < n ? "id" : ";");
+  }
+  push("$");
+  return tokens;
+}
+
+int main(int argc, char* argv[]) {
+  BenchArgs args = parseBenchArgs(argc, argv);
+  int failures = 0;
+
+  std::printf("%-22s %8s %8s %8s %14s %14s %8s %10s\n", "grammar", "rows", "columns", "cells", "dense bytes",
+              "comb bytes", "ratio", "build ms");
+
+  // ---- expression grammar, the lexer's tokens ----
+  {
+    std::string file = "Outputs/bench_expr_grammar.txt";
+    writeFile(file, exprGrammarText());
+    ParseTableGenerator gen;
+    {
+      QuietCout quiet;
+      gen.loadGrammar(file);
+      gen.generateTable();
+    }
+    StringLL1Engine dense(gen.getParseTable(), gen.getTerminals(), gen.getNonTerminals(), gen.getStartSymbol(),
+                          RuntimeTokenPolicy::defaults());
+    CombLL1Engine comb(gen.getParseTable(), gen.getTerminals(), gen.getNonTerminals(), gen.getStartSymbol(),
+                       RuntimeTokenPolicy::defaults());
+    size_t cells = 0;
+    for (const auto& row : gen.getParseTable()) cells += row.second.size();
+    std::printf("%-22s %8zu %8zu %8zu %14zu %14zu %7.1fx %10s\n\n", "expr", gen.getNonTerminals().size(),
+                RuntimeTokenPolicy::defaults().kindCount() + 1, cells, dense.getTable().bytes(),
+                comb.getTable().bytes(), (double)dense.getTable().bytes() / comb.getTable().bytes(), "-");
+    for (const auto& sz : args.sizes) {
+      std::string input = makeExprInput(sz.second);
+      std::vector<Token> tokens = Lexer(input).tokenize();
+      if (!dense.parse(tokens) || !comb.parse(tokens)) failures++;
+      runBench("dense/expr/" + sz.first, tokens.size(), input.size(), [&]() { dense.parse(tokens); });
+      runBench("comb/expr/" + sz.first, tokens.size(), input.size(), [&]() { comb.parse(tokens); });
+    }
+    std::printf("\n");
+  }
+
+  // ---- big grammars ----
+  for (size_t n : {250, 1000, 3000}) {
+    std::string file = "Outputs/bench_chain_grammar.txt";
+    writeFile(file, "S : R0 S\nS : epsilon\n" + largeGrammarText(n));
+    ParseTableGenerator gen;
+    {
+      QuietCout quiet;
+      gen.loadGrammar(file);
+      gen.generateTable();
+    }
+    KindPolicy policy;
+    std::map<std::string, size_t> kinds;
+    for (const std::string& t : gen.getTerminals()) {
+      kinds[t] = policy.names.size();
+      policy.names.push_back(t);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    LL1Engine<KindPolicy> dense(gen.getParseTable(), gen.getTerminals(), gen.getNonTerminals(),
+                                gen.getStartSymbol(), policy);
+    double denseMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    LL1Engine<KindPolicy, CombParseTable> comb(gen.getParseTable(), gen.getTerminals(), gen.getNonTerminals(),
+                                               gen.getStartSymbol(), policy);
+    double combMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    size_t cells = 0;
+    for (const auto& row : gen.getParseTable()) cells += row.second.size();
+    const CombParseTable& t = comb.getTable();
+    std::string name = "chain of " + std::to_string(n);
+    std::printf("%-22s %8zu %8zu %8zu %14zu %14zu %7.1fx %4.1f / %.1f\n", name.c_str(), gen.getNonTerminals().size(),
+                policy.names.size() + 1, cells, dense.getTable().bytes(), t.bytes(),
+                (double)dense.getTable().bytes() / t.bytes(), denseMs, combMs);
+    std::printf("  %zu cells left after the row defaults, %zu slots (%.1f%% used)\n", t.entryCount(),
+                t.slotCount(), 100.0 * t.entryCount() / t.slotCount());
+
+    // one token changed: both must reject it, or both accept it
+    std::vector<KindToken> tokens = makeChainInput(n, 1 << 12, kinds);
+    dense.setErrorStream(nullptr);
+    comb.setErrorStream(nullptr);
+    if (!dense.parse(tokens) || !comb.parse(tokens)) failures++;
+    Rng r;
+    size_t rejected = 0;
+    for (int m = 0; m < 2000; ++m) {
+      std::vector<KindToken> bad = tokens;
+      size_t at = r.next() % (bad.size() - 1);
+      bad[at].kind = r.next() % 2 ? kinds.at("id") : r.next() % (policy.names.size() + 1); // + unknown
+      bool a = dense.parse(bad), b = comb.parse(bad);
+      rejected += !a;
+      if (a != b) {
+        std::cerr << "MISMATCH on mutation " << m << ": dense " << a << ", comb " << b << "\n";
+        failures++;
+        break;
+      }
+    }
+    std::printf("  dense and comb agree on 2000 mutated inputs (%zu rejected)\n", rejected);
+
+    for (const auto& sz : args.sizes) {
+      std::vector<KindToken> input = makeChainInput(n, sz.second / 16, kinds); // about as many tokens as expr/size
+      std::string tag = "chain-" + std::to_string(n) + "/" + sz.first;
+      size_t bytes = 0; // the input as text: lexemes separated by one space, no "$"
+      for (size_t i = 0; i + 1 < input.size(); ++i) bytes += input[i].lexeme.size() + 1;
+      runBench("dense/" + tag, input.size(), bytes, [&]() { dense.parse(input); });
+      runBench("comb/" + tag, input.size(), bytes, [&]() { comb.parse(input); });
+    }
+    std::printf("\n");
+  }
+
+  if (failures) {
+    std::cerr << failures << " checks failed.\n";
+    return 1;
+  }
+  return finishBench(args);
+}
@@ -0,0 +1,228 @@
+// GLR driver (include/glr_engine.h) on three kinds of grammar:
+//   - deterministic (the left recursive expression grammar, no conflicts):
+//     against LREngine, to see what the graph stack + forest cost when every
+//     step takes the deterministic path
+//   - locally ambiguous: the same grammar plus  F : id ( E )  and
+//     T : id ( E ) , which only split the parse around a call
+//   - ambiguous:  E : E + E | E * E | ( E ) | id , every operator is a split
+// checks (exits 1 on a failure): tree counts (Catalan numbers for a + b + ...,
+// 2^calls for the calls, 1 for hidden left recursion  S : A S + | id ,
+// A : epsilon, infinitely many for  S : S S | id | epsilon  where the accept
+// on $ clashes with a reduction) and that GLR and LREngine accept the same random token
+// strings on the (conflict free, epsilon using) program grammar.
+//
+// g++ -O2 -pthread -I include bench/bench_glr.cpp -o bench_glr
+// ./bench_glr [--sizes small,medium,huge] [--huge BYTES] [--json results.json]
+//             [--baseline baseline.json] [--threshold PCT]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cmath>
+
+#include "bench_util.h"
+#include "../include/lexer.h"
+#include "../include/lr_table_gen.h"
+#include "../include/lr_engine.h"
+#include "../include/glr_engine.h"
+
+const char* exprGrammar = "E : E + T\nE : E - T\nE : T\nT : T * F\nT : T / F\nT : F\n"
+                          "F : ( E )\nF : id\nF : num\n";
+const char* callGrammar = "F : id ( E )\nT : id ( E )\n"; // appended to exprGrammar
+const char* ambiguousGrammar = "E : E + E\nE : E * E\nE : ( E )\nE : id\n";
+
+struct Rng {
+  uint64_t x = 88172645463325252ull;
+  uint64_t next() {
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    return x;
+  }
+};
+
+// like makeExprInput, with a call f ( ... ) every so often
+std::string makeCallInput(size_t bytes, size_t& calls) {
+  static const char* ops[] = { " + ", " * ", " - ", " / " };
+  Rng r;
+  std::string s = "a";
+  calls = 0;
+  for (size_t i = 1; s.size() < bytes; ++i) {
+    uint64_t x = r.next();
+    s += ops[x % 4];
+    if (x % 16 == 0) {
+      s += "f" + std::to_string(i % 10) + " ( x + y * z )";
+      calls++;
+    } else {
+      s += "x" + std::to_string(i % 1000);
+    }
+  }
+  return s;
+}
+
+std::string chain(size_t operands, const char* op) {
+  std::string s = "a0";
+  for (size_t i = 1; i < operands; ++i) s += std::string(" ") + op + " a" + std::to_string(i);
+  return s;
+}
+
+bool buildTable(LRTableGenerator& gen, const std::string& file, const std::string& text) {
+  writeFile(file, text);
+  std::streambuf* errBuf = std::cerr.rdbuf(nullptr); // conflict warnings are expected
+  bool ok = gen.loadGrammar(file);
+  if (ok) gen.generateTable();
+  std::cerr.rdbuf(errBuf);
+  return ok;
+}
+
+int main(int argc, char* argv[]) {
+  BenchArgs args = parseBenchArgs(argc, argv);
+  int failures = 0;
+
+  LRTableGenerator exprGen, callGen, ambGen, programGen, hiddenGen, cyclicGen;
+  if (!buildTable(exprGen, "Outputs/bench_lr_grammar.txt", exprGrammar) ||
+      !buildTable(callGen, "Outputs/bench_call_grammar.txt", std::string(exprGrammar) + callGrammar) ||
+      !buildTable(ambGen, "Outputs/bench_ambiguous_grammar.txt", ambiguousGrammar) ||
+      !buildTable(hiddenGen, "Outputs/bench_hidden_grammar.txt", "S : A S +\nS : id\nA : epsilon\n") ||
+      !buildTable(cyclicGen, "Outputs/bench_cyclic_grammar.txt", "S : S S\nS : id\nS : epsilon\n") ||
+      !buildTable(programGen, "Outputs/bench_program_grammar.txt",
+                  "Program : Stmt Program\nProgram : epsilon\nStmt : datatype id L ;\nStmt : id = E ;\n"
+                  "L : , id L\nL : epsilon\ndatatype : int\ndatatype : float\n" + std::string(exprGrammar))) {
+    std::cerr << "Failed to load grammars.\n";
+    return 1;
+  }
+  std::printf("conflicts: expression %zu, with calls %zu, ambiguous %zu, program %zu\n\n", exprGen.conflicts(),
+              callGen.conflicts(), ambGen.conflicts(), programGen.conflicts());
+
+  RuntimeTokenPolicy policy = RuntimeTokenPolicy::defaults();
+  StringLREngine lr(exprGen.getTable(), policy);
+  StringGLREngine glr(exprGen.getTable(), policy), glrCall(callGen.getTable(), policy),
+                  glrAmb(ambGen.getTable(), policy);
+
+  // ---- checks ----
+  std::vector<double> catalan{1};
+  for (size_t n = 1; n < 24; ++n) {
+    double c = 0;
+    for (size_t k = 0; k < n; ++k) c += catalan[k] * catalan[n - 1 - k];
+    catalan.push_back(c);
+  }
+  for (size_t operands = 1; operands < catalan.size(); ++operands) {
+    std::vector<Token> tokens = Lexer(chain(operands, "+")).tokenize();
+    double trees = glrAmb.parse(tokens) ? glrAmb.getForest().countTrees(glrAmb.getForest().root) : 0;
+    if (trees != catalan[operands - 1]) {
+      std::cerr << "MISMATCH " << operands << " operands: " << trees << " trees, expected "
+                << catalan[operands - 1] << "\n";
+      failures++;
+    }
+  }
+  {
+    size_t calls = 0;
+    std::vector<Token> tokens = Lexer(makeCallInput(400, calls)).tokenize();
+    double trees = glrCall.parse(tokens) ? glrCall.getForest().countTrees(glrCall.getForest().root) : 0;
+    if (trees != (double)(1ull << calls)) {
+      std::cerr << "MISMATCH " << calls << " calls: " << trees << " trees\n";
+      failures++;
+    }
+  }
+  {
+    StringGLREngine glrHidden(hiddenGen.getTable(), policy);
+    std::string s = "a";
+    for (int n = 0; n < 50; ++n, s += " +") {
+      std::vector<Token> tokens = Lexer(s).tokenize();
+      if (!glrHidden.parse(tokens) || glrHidden.getForest().countTrees(glrHidden.getForest().root) != 1) {
+        std::cerr << "MISMATCH on \"" << s << "\" (hidden left recursion)\n";
+        failures++;
+        break;
+      }
+    }
+  }
+  {
+    // the accept / reduce cell on $ keeps the reduction, or only the first tree is found
+    StringGLREngine glrCyclic(cyclicGen.getTable(), policy);
+    for (const char* s : { "", "a", "a a" }) {
+      std::vector<Token> tokens = Lexer(s).tokenize();
+      if (!glrCyclic.parse(tokens) || !std::isinf(glrCyclic.getForest().countTrees(glrCyclic.getForest().root))) {
+        std::cerr << "MISMATCH on \"" << s << "\" (S : S S | id | epsilon): expected infinitely many trees\n";
+        failures++;
+      }
+    }
+  }
+  {
+    // random token strings, mostly wrong: both drivers must agree on every one
+    StringLREngine lrProgram(programGen.getTable(), policy);
+    StringGLREngine glrProgram(programGen.getTable(), policy);
+    lrProgram.setErrorStream(nullptr);
+    glrProgram.setErrorStream(nullptr);
+    static const char* words[] = { "int", "float", "x", "y", "=", "+", "*", "(", ")", ",", ";", "2" };
+    Rng r;
+    size_t accepted = 0;
+    for (int n = 0; n < 20000; ++n) {
+      std::string s;
+      size_t len = r.next() % 12;
+      for (size_t k = 0; k < len; ++k) s += std::string(words[r.next() % 12]) + " ";
+      if (n % 3 == 0) s = "int x , y ; x = " + s + ";"; // some that get further
+      std::vector<Token> tokens = Lexer(s).tokenize();
+      bool a = lrProgram.parse(tokens), b = glrProgram.parse(tokens);
+      accepted += a;
+      if (a != b || (a && glrProgram.getForest().countTrees(glrProgram.getForest().root) != 1)) {
+        std::cerr << "MISMATCH on \"" << s << "\": lr " << a << ", glr " << b << "\n";
+        failures++;
+        break;
+      }
+    }
+    std::printf("glr and lr agree on 20000 random programs (%zu accepted), Catalan counts up to %zu operands, "
+                "2^calls and hidden left recursion\n\n", accepted, catalan.size() - 1);
+  }
+  glr.setErrorStream(nullptr);
+
+  // ---- deterministic + locally ambiguous ----
+  for (const auto& sz : args.sizes) {
+    std::string input = makeExprInput(sz.second);
+    std::vector<Token> tokens = Lexer(input).tokenize();
+    std::string tag = "expr/" + sz.first;
+    if (!lr.parse(tokens) || !glr.parse(tokens)) failures++;
+    const ParseForest& forest = glr.getForest();
+    std::printf("%s, %zu tokens: %.1f%% of reductions deterministic, %.2f forest nodes per token, "
+                "%zu stack tops at most\n", tag.c_str(), tokens.size(),
+                100.0 * glr.deterministicReductions() / glr.reductionCount(),
+                (double)forest.nodes.size() / tokens.size(), glr.maxStackTops());
+    runBench("lr/" + tag, tokens.size(), input.size(), [&]() { lr.parse(tokens); });
+    runBench("glr/" + tag, tokens.size(), input.size(), [&]() { glr.parse(tokens); });
+
+    size_t calls = 0;
+    std::string callInput = makeCallInput(sz.second, calls);
+    std::vector<Token> callTokens = Lexer(callInput).tokenize();
+    tag = "calls/" + sz.first;
+    if (!glrCall.parse(callTokens)) failures++;
+    std::printf("%s, %zu tokens, %zu calls: %.1f%% of reductions deterministic, %zu ambiguous nodes, "
+                "%zu stack tops at most\n", tag.c_str(), callTokens.size(), calls,
+                100.0 * glrCall.deterministicReductions() / glrCall.reductionCount(),
+                glrCall.getForest().ambiguousNodes(), glrCall.maxStackTops());
+    runBench("glr/" + tag, callTokens.size(), callInput.size(), [&]() { glrCall.parse(callTokens); });
+    std::printf("\n");
+  }
+
+  // ---- ambiguous ----
+  std::printf("%-26s %8s %12s %12s %12s %12s %14s\n", "E : E + E | E * E", "tokens", "stack nodes",
+              "forest nodes", "families", "ambiguous", "trees");
+  for (size_t operands : {8, 16, 32, 64, 128, 256}) {
+    std::string input = chain(operands, operands % 3 ? "+" : "*");
+    std::vector<Token> tokens = Lexer(input).tokenize();
+    if (!glrAmb.parse(tokens)) failures++;
+    const ParseForest& forest = glrAmb.getForest();
+    std::printf("%-26s %8zu %12zu %12zu %12zu %12zu %14.4g\n", ("chain of " + std::to_string(operands)).c_str(),
+                tokens.size(), glrAmb.stackNodes(), forest.nodes.size(), forest.families.size(),
+                forest.ambiguousNodes(), forest.countTrees(forest.root));
+  }
+  for (size_t operands : {16, 64, 128}) {
+    std::string input = chain(operands, "+");
+    std::vector<Token> tokens = Lexer(input).tokenize();
+    runBench("glr/ambiguous/" + std::to_string(operands), tokens.size(), input.size(),
+             [&]() { glrAmb.parse(tokens); }, 0.1);
+  }
+
+  if (failures) {
+    std::cerr << failures << " checks failed.\n";
+    return 1;
+  }
+  return finishBench(args);
+}
@@ -0,0 +1,246 @@
+// ParseTableGenerator::applyEdits / reloadGrammar (incremental FIRST /
+// FOLLOW / table rows) against a full loadGrammar + generateTable.
+// checks (exits 1 on a failure): after every one of a few thousand random
+// production additions and removals on the expression and program grammars,
+// the sets, the table and the conflict cells are the ones a fresh generator
+// gets from the edited grammar. then, on a grammar with about 50k
+// productions (S : R0 S | epsilon and largeGrammarText), the time of a full
+// regeneration vs single edits: a new row, a conflict appearing and going,
+// and a new FIRST(S) terminal that goes into every R's FOLLOW. last, the same
+// for reloadGrammar on the edited file.
+//
+// g++ -O2 -pthread -I include bench/bench_incremental_table.cpp -o bench_incremental_table
+// ./bench_incremental_table [--chain N] [--edits N]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+
+#include "bench_util.h"
+#include "../include/parse_table_gen.h"
+
+using Productions = std::map<std::string, std::vector<std::vector<std::string>>>;
+
+struct Rng {
+  uint64_t x = 88172645463325252ull;
+  uint64_t next() {
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    return x;
+  }
+};
+
+// the start symbol's lines first, the rest in map order
+std::string grammarText(const Productions& prods, const std::string& start) {
+  std::string g;
+  auto add = [&](const std::string& nt) {
+    for (const auto& body : prods.at(nt)) {
+      g += nt + " :";
+      for (const auto& s : body) g += " " + s;
+      g += "\n";
+    }
+  };
+  add(start);
+  for (const auto& r : prods) {
+    if (r.first != start) add(r.first);
+  }
+  return g;
+}
+
+bool fresh(ParseTableGenerator& gen, const std::string& file, const std::string& text) {
+  writeFile(file, text);
+  gen.setVerbose(false);
+  if (!gen.loadGrammar(file)) return false;
+  std::streambuf* errBuf = std::cerr.rdbuf(nullptr); // conflict warnings
+  gen.generateTable();
+  std::cerr.rdbuf(errBuf);
+  return true;
+}
+
+std::string describe(const ParseTableGenerator& a, const ParseTableGenerator& b) {
+  if (a.getTerminals() != b.getTerminals()) return "terminals";
+  if (a.getNonTerminals() != b.getNonTerminals()) return "nonterminals";
+  for (const auto& nt : a.getNonTerminals()) {
+    if (a.getFirst(nt) != b.getFirst(nt)) return "FIRST(" + nt + ")";
+    if (a.getFollow(nt) != b.getFollow(nt)) return "FOLLOW(" + nt + ")";
+  }
+  if (a.getParseTable() != b.getParseTable()) return "table";
+  if (a.getConflicts() != b.getConflicts()) return "conflicts";
+  return "";
+}
+
+double msSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int randomEdits(const std::string& name, const std::string& text, size_t count) {
+  ParseTableGenerator gen;
+  fresh(gen, "Outputs/bench_incr_grammar.txt", text);
+  std::set<std::string> nonterms = gen.getNonTerminals();
+  std::vector<std::string> pool(nonterms.begin(), nonterms.end());
+  for (const auto& t : gen.getTerminals()) {
+    if (t != "$") pool.push_back(t);
+  }
+  pool.push_back("N1"); // new symbols, terminals until something gives them a production
+  pool.push_back("N2");
+  pool.push_back("w");
+
+  Rng r;
+  size_t conflictsSeen = 0, conflictsGone = 0, full = 0, applied = 0;
+  for (size_t n = 0; n < count; ++n) {
+    Productions prods = gen.getProductions();
+    std::vector<GrammarEdit> edits;
+    for (uint64_t k = 1 + r.next() % 2; k-- > 0;) {
+      uint64_t x = r.next();
+      if (x % 2 == 0) { // remove
+        auto it = prods.begin();
+        std::advance(it, r.next() % prods.size());
+        if (it->second.size() == 1 && (x / 2) % 8) continue; // mostly keep the last production
+        const auto& body = it->second[r.next() % it->second.size()];
+        edits.push_back({false, it->first, body});
+        continue;
+      }
+      std::string nt = x % 10 == 1 ? pool[r.next() % pool.size()] : std::next(prods.begin(), r.next() % prods.size())->first;
+      std::vector<std::string> body;
+      if (r.next() % 5 == 0) body.push_back("epsilon");
+      else {
+        for (uint64_t len = 1 + r.next() % 3; len-- > 0;) body.push_back(pool[r.next() % pool.size()]);
+      }
+      edits.push_back({true, nt, body});
+    }
+    // the same edits on a copy of the productions, for the fresh generator
+    bool valid = true;
+    for (const auto& e : edits) {
+      if (e.add) prods[e.nt].push_back(e.body);
+      else {
+        auto& list = prods[e.nt];
+        auto it = std::find(list.rbegin(), list.rend(), e.body);
+        if (it == list.rend()) valid = false;
+        else list.erase(std::next(it).base());
+        if (list.empty()) prods.erase(e.nt);
+      }
+    }
+    if (!valid || prods.empty() || !prods.count(gen.getStartSymbol())) continue;
+
+    TableUpdate report;
+    if (!gen.applyEdits(edits, report)) {
+      std::cerr << name << ": applyEdits failed on edit " << n << "\n";
+      return 1;
+    }
+    applied++;
+    full += report.fullRebuild;
+    conflictsSeen += report.conflictsAdded.size();
+    conflictsGone += report.conflictsRemoved.size();
+    ParseTableGenerator check;
+    fresh(check, "Outputs/bench_incr_check.txt", grammarText(prods, gen.getStartSymbol()));
+    std::string diff = describe(gen, check);
+    if (!diff.empty()) {
+      std::cerr << name << ": MISMATCH in " << diff << " after edit " << n << ":";
+      for (const auto& e : edits) {
+        std::cerr << (e.add ? " +" : " -") << e.nt << " :";
+        for (const auto& s : e.body) std::cerr << " " << s;
+        std::cerr << ";";
+      }
+      std::cerr << "\n";
+      return 1;
+    }
+  }
+  std::printf("%s: %zu random edit batches match a full regeneration (conflicts +%zu -%zu, %zu full rebuilds)\n",
+              name.c_str(), applied, conflictsSeen, conflictsGone, full);
+  return 0;
+}
+
+void line(const char* what, double ms, const TableUpdate& u) {
+  std::printf("  %-34s %9.3f ms  %6zu FIRST %6zu FOLLOW %6zu rows  conflicts +%zu -%zu%s\n", what, ms,
+              u.firstChanged, u.followChanged, u.rowsRebuilt, u.conflictsAdded.size(), u.conflictsRemoved.size(),
+              u.fullRebuild ? "  (full)" : "");
+}
+
+int main(int argc, char* argv[]) {
+  size_t chain = 16666, edits = 2000;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i];
+    if (key == "--chain") chain = std::stoul(argv[i + 1]);
+    else if (key == "--edits") edits = std::stoul(argv[i + 1]);
+  }
+
+  if (randomEdits("expr", exprGrammarText(), edits) ||
+      randomEdits("program", "Program : Stmt Program\nProgram : epsilon\nStmt : datatype id L ;\nStmt : id = Exp ;\n"
+                             "L : , id L\nL : epsilon\ndatatype : int\ndatatype : float\n" + exprGrammarText(), edits)) {
+    return 1;
+  }
+
+  // ---- a big grammar ----
+  std::string file = "Outputs/bench_incr_large.txt";
+  std::string text = "S : R0 S\nS : epsilon\n" + largeGrammarText(chain);
+  writeFile(file, text);
+  ParseTableGenerator gen;
+  gen.setVerbose(false);
+  auto start = std::chrono::steady_clock::now();
+  gen.loadGrammar(file);
+  double loadMs = msSince(start);
+  start = std::chrono::steady_clock::now();
+  gen.generateTable();
+  double fullMs = msSince(start);
+  size_t count = 0;
+  for (const auto& r : gen.getProductions()) count += r.second.size();
+  std::printf("\n%zu productions, %zu terminals: loadGrammar %.1f ms, generateTable %.1f ms\n", count,
+              gen.getTerminals().size(), loadMs, fullMs);
+
+  std::string mid = std::to_string(chain / 2), midNext = std::to_string(chain / 2 + 1);
+  struct Step {
+    std::string what;
+    GrammarEdit edit;
+  };
+  std::vector<Step> steps = {
+    {"add R" + mid + " : v" + mid + " R" + midNext, {true, "R" + mid, {"v" + mid, "R" + midNext}}},
+    {"remove it", {false, "R" + mid, {"v" + mid, "R" + midNext}}},
+    {"add R" + mid + " : t" + mid + " R" + midNext, {true, "R" + mid, {"t" + mid, "R" + midNext}}},
+    {"remove it", {false, "R" + mid, {"t" + mid, "R" + midNext}}},
+    {"add S : w S (every FOLLOW gets w)", {true, "S", {"w", "S"}}},
+    {"remove it", {false, "S", {"w", "S"}}},
+  };
+  int failures = 0;
+  TableUpdate none;
+  start = std::chrono::steady_clock::now();
+  gen.applyEdits({}, none); // the first update builds the dependency index
+  line("no edits (builds the index)", msSince(start), none);
+  for (const Step& s : steps) {
+    TableUpdate u;
+    start = std::chrono::steady_clock::now();
+    if (!gen.applyEdits({s.edit}, u)) failures++;
+    line(s.what.c_str(), msSince(start), u);
+  }
+  // the conflict has to show up and go again
+  ParseTableGenerator check;
+  fresh(check, file, text);
+  if (!describe(gen, check).empty()) {
+    std::cerr << "MISMATCH after the edits: " << describe(gen, check) << "\n";
+    failures++;
+  }
+
+  // the same edit through the file
+  std::string edited = text + "R" + mid + " : t" + mid + " R" + midNext + "\n";
+  writeFile(file, edited);
+  TableUpdate u;
+  start = std::chrono::steady_clock::now();
+  if (!gen.reloadGrammar(file, u)) failures++;
+  line("reloadGrammar, one line added", msSince(start), u);
+  if (u.conflictsAdded.size() != 1) failures++;
+  ParseTableGenerator reloaded;
+  start = std::chrono::steady_clock::now();
+  fresh(reloaded, file, edited);
+  std::printf("  %-34s %9.3f ms\n", "full load + generate", msSince(start));
+  if (!describe(gen, reloaded).empty()) {
+    std::cerr << "MISMATCH after reloadGrammar: " << describe(gen, reloaded) << "\n";
+    failures++;
+  }
+
+  if (failures) {
+    std::cerr << failures << " checks failed.\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,165 @@
+// x86-64 JIT (include/expr_jit.h) vs tree walk and bytecode VM, one row per
+// call, and JIT packed columns vs the columnar evaluator. every JIT result
+// is checked against evalTree bit for bit first: several expressions (deep,
+// wide, constants only, division by zero), also compiled with only 1 and 2
+// registers so values get spilled. exits 1 on a mismatch.
+//
+// g++ -O2 -I include bench/bench_jit.cpp -o bench_jit -pthread
+// ./bench_jit ["expression"] [evaluations]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstring>
+
+#include "../include/expr_ast.h"
+#include "../include/expr_vm.h"
+#include "../include/expr_jit.h"
+#include "../include/columnar_eval.h"
+
+#if EXPR_JIT_AVAILABLE
+
+bool sameBits(double a, double b) {
+  return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+// a + b * c - ... with n operands, nested every few so the tree is both deep and wide
+std::string makeLong(size_t n) {
+  static const char* ops[] = { " + ", " * ", " - ", " / " };
+  std::string s = "x0";
+  for (size_t i = 1; i < n; ++i) {
+    std::string operand = i % 7 == 0 ? "( x" + std::to_string(i % 23) + " - " + std::to_string(i) + ".5 )"
+                                     : "x" + std::to_string(i % 23);
+    s = i % 5 == 0 ? "( " + s + " )" + ops[i % 4] + operand : s + ops[i % 4] + operand;
+  }
+  return s;
+}
+
+// a balanced tree needs log2(leaves) + 1 registers, 2^16 leaves more than 15
+std::string makeBalanced(int depth, int& leaf) {
+  if (depth == 0) return "v" + std::to_string(leaf++ % 31);
+  static const char* ops[] = { " + ", " - ", " * ", " / " };
+  return "( " + makeBalanced(depth - 1, leaf) + ops[depth % 4] + makeBalanced(depth - 1, leaf) + " )";
+}
+
+size_t checkExpression(const std::string& text) {
+  ExprTree tree = parseExpression(text);
+  size_t nvars = tree.variables.size();
+  const size_t rows = 257;
+  std::mt19937_64 rng(11);
+  std::uniform_real_distribution<double> dist(-50.0, 50.0);
+  std::vector<std::vector<double>> data(nvars, std::vector<double>(rows));
+  for (auto& col : data) {
+    for (size_t r = 0; r < rows; ++r) col[r] = r % 17 == 0 ? 0.0 : dist(rng); // zeros for x / 0
+  }
+  std::vector<const double*> columns;
+  for (auto& col : data) columns.push_back(col.data());
+
+  size_t failures = 0;
+  for (int registers : {15, 2, 1}) {
+    ExprJit jit(tree, registers);
+    std::vector<double> out(rows), vars(nvars ? nvars : 1);
+    jit.evalColumns(columns.data(), rows, out.data());
+    for (size_t r = 0; r < rows; ++r) {
+      for (size_t v = 0; v < nvars; ++v) vars[v] = data[v][r];
+      double expect = evalTree(tree, vars.data());
+      double got = jit(vars.data());
+      if (!sameBits(expect, got) || !sameBits(expect, out[r])) {
+        std::cerr << "MISMATCH (" << registers << " registers) on row " << r << ": tree " << expect
+                  << " jit " << got << " columns " << out[r] << "\n  " << text.substr(0, 200) << "\n";
+        failures++;
+        break;
+      }
+    }
+    if (registers == 15) {
+      std::cout << "  " << tree.nodes.size() << " nodes, " << jit.codeBytes() << " bytes of code, "
+                << jit.spills() << " spills: " << (text.size() > 60 ? text.substr(0, 57) + "..." : text) << "\n";
+    }
+  }
+  return failures;
+}
+
+int main(int argc, char* argv[]) {
+  std::string text = argc > 1 ? argv[1] : "(a + b) * (c - d) / (e + 2) + a * b * 3 - (c / (d + 1))";
+  size_t evals = argc > 2 ? std::stoul(argv[2]) : 10000000;
+
+  int leaf = 0;
+  std::vector<std::string> checks = {
+    text, "a", "2", "2 * 3 - 1 / 3", "a / 0", "0 / 0 - a", "a - b - c - d", "a / ( b / ( c / ( d / e ) ) )",
+    "1e308 * 10 - a", "0.1 + 0.2 - a * 3", makeLong(200), makeLong(5000), makeBalanced(5, leaf),
+  };
+  leaf = 0;
+  checks.push_back(makeBalanced(16, leaf)); // more registers than there are
+  std::cout << "Bit for bit checks against the tree walk (15, 2 and 1 registers):\n";
+  size_t failures = 0;
+  for (const std::string& c : checks) failures += checkExpression(c);
+  if (failures) {
+    std::cerr << "JIT results differ from the interpreter.\n";
+    return 1;
+  }
+
+  ExprTree tree = parseExpression(text);
+  Bytecode bc = compileExpr(tree);
+  ExprVM vm(bc);
+  ExprJit jit(tree);
+  ExprJit::RowFn fn = jit.row();
+  size_t nvars = tree.variables.size();
+  std::cout << "\nExpression: " << text << "\n";
+
+  const size_t rows = 1024;
+  std::vector<double> bindings(rows * (nvars ? nvars : 1));
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> dist(1.0, 100.0);
+  for (auto& v : bindings) v = dist(rng);
+
+  auto timeIt = [&](const char* name, auto&& f) {
+    double sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < evals; ++i) sink += f(&bindings[(i % rows) * nvars]);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ":\t" << (s * 1e9 / evals) << " ns/eval\t"
+              << (evals / s / 1e6) << " M evals/s\t(checksum " << sink << ")\n";
+    return s;
+  };
+
+  double tTree = timeIt("tree walk", [&](const double* v) { return evalTree(tree, v); });
+  double tVm = timeIt("bytecode vm", [&](const double* v) { return vm.run(bc, v); });
+  double tJit = timeIt("jit, per row", [&](const double* v) { return fn(v); });
+  std::cout << "jit vs vm: " << (tVm / tJit) << "x, vs tree walk: " << (tTree / tJit) << "x\n\n";
+
+  // whole columns: the columnar evaluator's SIMD kernels vs the JIT's packed loop
+  std::vector<std::vector<double>> data(nvars, std::vector<double>(evals));
+  for (auto& col : data) for (auto& v : col) v = dist(rng);
+  std::vector<const double*> columns;
+  for (auto& col : data) columns.push_back(col.data());
+  std::vector<double> expected(evals), out(evals);
+
+  ColumnarEvaluator eval(bc);
+  auto start = std::chrono::steady_clock::now();
+  eval.evaluate(columns, 0, evals, expected.data());
+  double tCol = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  start = std::chrono::steady_clock::now();
+  jit.evalColumns(columns.data(), evals, out.data());
+  double tJitCol = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << "columnar x1:\t" << (tCol * 1e9 / evals) << " ns/row\t" << (evals / tCol / 1e6) << " M rows/s\n";
+  std::cout << "jit columns:\t" << (tJitCol * 1e9 / evals) << " ns/row\t" << (evals / tJitCol / 1e6) << " M rows/s\n";
+  for (size_t r = 0; r < evals; ++r) {
+    if (!sameBits(out[r], expected[r])) {
+      std::cerr << "Mismatch at row " << r << ": " << out[r] << " vs " << expected[r] << "\n";
+      return 1;
+    }
+  }
+  std::cout << "jit vs columnar: " << (tCol / tJitCol) << "x, same bits on every row\n";
+  return 0;
+}
+
+#else
+
+int main() {
+  std::cerr << "The JIT needs Linux x86-64.\n";
+  return 1;
+}
+
+#endif
@@ -0,0 +1,121 @@
+// LR driver (include/lr_engine.h) vs LL1Parser and the LL1Engine on the
+// same expressions. the LR tables come from include/lr_table_gen.h, for the
+// left recursive grammar (ex_Input/lr_expr_grammar.txt, which LL(1) can't
+// use) and for the LL(1) Exp grammar. prints the table sizes (row shared +
+// default reductions vs dense), steps per token (ParserMetrics parserSteps:
+// matches + expansions for LL, shifts + reductions for LR), then the usual
+// ns per token. exits 1 if a parser rejects an input.
+//
+// g++ -O2 -pthread -I include bench/bench_lr.cpp -o bench_lr
+// ./bench_lr [--sizes small,medium,huge] [--huge BYTES] [--json results.json]
+//            [--baseline baseline.json] [--threshold PCT]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "bench_util.h"
+#include "../include/lexer.h"
+#include "../include/LL1_parser_ET.h"
+#include "../include/parse_table_gen.h"
+#include "../include/ll1_engine.h"
+#include "../include/lr_table_gen.h"
+#include "../include/lr_engine.h"
+#include "../include/metrics.h"
+
+const char* leftRecursiveGrammar = "E : E + T\nE : E - T\nE : T\nT : T * F\nT : T / F\nT : F\n"
+                                   "F : ( E )\nF : id\nF : num\n";
+
+uint64_t stepsOf(const std::function<bool()>& parse, bool& ok) {
+  uint64_t before = ParserMetrics::global().parserSteps.load();
+  QuietCout quiet;
+  ok = parse();
+  return ParserMetrics::global().parserSteps.load() - before;
+}
+
+int main(int argc, char* argv[]) {
+  BenchArgs args = parseBenchArgs(argc, argv);
+
+  std::string llFile = "Outputs/bench_expr_grammar.txt", lrFile = "Outputs/bench_lr_grammar.txt";
+  writeFile(llFile, exprGrammarText());
+  writeFile(lrFile, leftRecursiveGrammar);
+
+  ParseTableGenerator gen;
+  LRTableGenerator lrGen, lrLLGen, slrGen;
+  {
+    QuietCout quiet;
+    gen.loadGrammar(llFile);
+    gen.generateTable();
+    lrGen.loadGrammar(lrFile);
+    lrGen.generateTable();
+    lrLLGen.loadGrammar(llFile);
+    lrLLGen.generateTable();
+    slrGen.loadGrammar(lrFile);
+    slrGen.generateTable(LRTableGenerator::Mode::SLR);
+  }
+  ParseTable table = gen.getParseTable();
+  std::set<std::string> terms = gen.getTerminals();
+  std::set<std::string> nonterms = gen.getNonTerminals();
+
+  std::printf("%-28s %8s %10s %10s %12s %12s\n", "LR table", "states", "conflicts", "rows", "bytes", "dense bytes");
+  auto tableLine = [](const char* name, const LRTableGenerator& g) {
+    const LRTable& t = g.getTable();
+    std::printf("%-28s %8zu %10zu %10zu %12zu %12zu\n", name, t.states, g.conflicts(),
+                t.actions.size() / t.stride(), t.bytes(), t.denseBytes());
+  };
+  tableLine("lalr / left recursive", lrGen);
+  tableLine("slr / left recursive", slrGen);
+  tableLine("lalr / ll(1) grammar", lrLLGen);
+  std::printf("\n");
+
+  StringLL1Engine engine(table, terms, nonterms, gen.getStartSymbol(), RuntimeTokenPolicy::defaults());
+  StringLREngine lr(lrGen.getTable(), RuntimeTokenPolicy::defaults());
+  StringLREngine lrLL(lrLLGen.getTable(), RuntimeTokenPolicy::defaults());
+
+  int failures = 0;
+  for (const auto& sz : args.sizes) {
+    std::string input = makeExprInput(sz.second);
+    std::vector<Token> tokens = Lexer(input).tokenize();
+    std::string tag = "expr/" + sz.first;
+
+    // steps per token, one parse each
+    bool ok = true;
+    std::printf("%s, %zu tokens, steps per token:", tag.c_str(), tokens.size());
+    if (sz.second <= (1u << 20)) { // LL1Parser prints every step, too slow for huge
+      uint64_t s = stepsOf([&]() {
+        return LL1Parser(tokens, table, terms, nonterms, gen.getStartSymbol()).parse();
+      }, ok);
+      failures += !ok;
+      std::printf(" LL1Parser %.2f,", (double)s / tokens.size());
+    }
+    uint64_t sEngine = stepsOf([&]() { return engine.parse(tokens); }, ok);
+    failures += !ok;
+    uint64_t sLr = stepsOf([&]() { return lr.parse(tokens); }, ok);
+    failures += !ok;
+    uint64_t sLrLL = stepsOf([&]() { return lrLL.parse(tokens); }, ok);
+    failures += !ok;
+    std::printf(" ll1 engine %.2f, lr %.2f (%llu shifts + %llu reductions), lr on ll(1) grammar %.2f\n",
+                (double)sEngine / tokens.size(), (double)sLr / tokens.size(),
+                (unsigned long long)lr.shiftCount(), (unsigned long long)lr.reductionCount(),
+                (double)sLrLL / tokens.size());
+    if (PARSER_METRICS_ENABLED == 0) std::printf("  (built with PARSER_NO_METRICS, no step counts)\n");
+
+    if (sz.second <= (1u << 20)) {
+      runBench("LL1Parser/" + tag, tokens.size(), input.size(), [&]() {
+        LL1Parser parser(tokens, table, terms, nonterms, gen.getStartSymbol());
+        parser.parse();
+      });
+    }
+    runBench("ll1 engine/" + tag, tokens.size(), input.size(), [&]() { engine.parse(tokens); });
+    runBench("lr/" + tag, tokens.size(), input.size(), [&]() { lr.parse(tokens); });
+    runBench("lr ll(1) grammar/" + tag, tokens.size(), input.size(), [&]() { lrLL.parse(tokens); });
+    std::printf("\n");
+  }
+
+  if (failures) {
+    std::cerr << failures << " parses failed.\n";
+    return 1;
+  }
+  return finishBench(args);
+}
@@ -0,0 +1,195 @@
+// Numeric literal decoding (include/number_literal.h): checks every value
+// against strtod / strtoll bit for bit (ints, decimals, exponents, 20+ digit
+// mantissas, halfway cases, subnormals, overflow), then measures decoding
+// alone, strtod on the same text, and Lexer::tokenize on number heavy input
+// (values come with the tokens) against tokenize + stod over the lexemes.
+//
+// g++ -O2 -pthread -I include bench/bench_numbers.cpp -o bench_numbers
+// ./bench_numbers [--sizes small,medium,huge] [--huge BYTES] [--json results.json]
+//                 [--baseline baseline.json] [--threshold PCT]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+
+#include "bench_util.h"
+#include "../include/lexer.h"
+#include "../include/number_literal.h"
+
+struct Rng {
+  uint64_t x = 88172645463325252ull;
+  uint64_t next() {
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    return x;
+  }
+  std::string digits(size_t n, bool leadingNonZero = true) {
+    std::string s;
+    for (size_t i = 0; i < n; ++i) s += char('0' + (i == 0 && leadingNonZero ? 1 + next() % 9 : next() % 10));
+    return s;
+  }
+};
+
+std::string randomInt(Rng& r) { return r.digits(1 + r.next() % 18); }
+
+std::string randomShortInt(Rng& r) { return r.digits(1 + r.next() % 3); }
+
+std::string randomFloat(Rng& r) {
+  std::string s = r.digits(1 + r.next() % 6) + "." + r.digits(r.next() % 12, false);
+  if (r.next() % 3 == 0) s += (r.next() % 2 ? "e-" : "e") + std::to_string(r.next() % 40);
+  return s;
+}
+
+// ---- correctness ----
+
+bool sameBits(double a, double b) {
+  uint64_t x, y;
+  std::memcpy(&x, &a, 8);
+  std::memcpy(&y, &b, 8);
+  return x == y;
+}
+
+// checks one literal, prints and returns false on a mismatch
+bool check(const std::string& text, bool integerOnly = false) {
+  NumberValue v;
+  size_t used = integerOnly ? scanIntegerLiteral(text.data(), text.data() + text.size(), v)
+                            : scanNumberLiteral(text.data(), text.data() + text.size(), v);
+  if (used != text.size()) {
+    std::cerr << "MISMATCH " << text << ": used " << used << " of " << text.size() << " chars\n";
+    return false;
+  }
+  bool plainInt = text.find_first_of(".eE") == std::string::npos;
+  errno = 0;
+  long long asInt = plainInt ? std::strtoll(text.c_str(), nullptr, 10) : 0;
+  if (plainInt && errno == 0) {
+    if (v.isFloat || v.intValue != asInt) {
+      std::cerr << "MISMATCH " << text << ": got " << v.asDouble() << ", strtoll " << asInt << "\n";
+      return false;
+    }
+    return true;
+  }
+  double expect = std::strtod(text.c_str(), nullptr);
+  if (!v.isFloat || !sameBits(v.floatValue, expect)) {
+    std::printf("MISMATCH %s: got %.17g, strtod %.17g\n", text.c_str(), v.asDouble(), expect);
+    return false;
+  }
+  return true;
+}
+
+size_t runChecks() {
+  std::vector<std::string> fixed = {
+    "0", "7", "12345678", "123456789", "9223372036854775807", "9223372036854775808",
+    "18446744073709551615", "18446744073709551616", "123456789012345678901234567890",
+    "0.1", "0.2", "0.3", "1.", "3.14159265358979323846264338327950288", "2.5E-3", "6e23",
+    "9007199254740992", "9007199254740993.0", "9007199254740995.0", "1e22", "1e23",
+    "4.9e-324", "2.4703282292062327e-324", "2.4703282292062328e-324", "2.2250738585072011e-308",
+    "1.7976931348623157e308", "1.7976931348623159e308", "1e400", "1e-400", "0.0000000000000000000000000001",
+    "00000000000000000000000000012", "0.000000", "123.456e+7", "1e+0", "7.0e-10",
+  };
+  size_t failures = 0, checked = 0;
+  for (const std::string& s : fixed) {
+    failures += !check(s);
+    checked++;
+  }
+  for (const char* s : {"0", "42", "99999999", "100000000", "9223372036854775808"}) {
+    failures += !check(s, true);
+    checked++;
+  }
+  Rng r;
+  for (int i = 0; i < 300000; ++i) {
+    std::string s;
+    switch (i % 5) {
+      case 0: s = randomInt(r); break;
+      case 1: s = randomFloat(r); break;
+      case 2: s = r.digits(15 + r.next() % 15) + "e" + std::to_string((int)(r.next() % 700) - 350); break;
+      case 3: s = "0." + r.digits(r.next() % 30, false) + r.digits(1 + r.next() % 20); break;
+      default: s = r.digits(1 + r.next() % 25); break;
+    }
+    failures += !check(s);
+    checked++;
+  }
+  std::printf("%zu literals checked against strtod / strtoll, %zu mismatches\n\n", checked, failures);
+  return failures;
+}
+
+// ---- speed ----
+
+// numbers separated by single spaces, about bytes long
+std::string makeNumbers(size_t bytes, std::string (*gen)(Rng&)) {
+  Rng r;
+  std::string s;
+  while (s.size() < bytes) {
+    s += gen(r);
+    s += ' ';
+  }
+  return s;
+}
+
+int main(int argc, char* argv[]) {
+  BenchArgs args = parseBenchArgs(argc, argv);
+  size_t failures = runChecks();
+
+  struct Kind {
+    const char* name;
+    std::string (*gen)(Rng&);
+  };
+  std::vector<Kind> kinds = {{"ints", randomInt}, {"short-ints", randomShortInt}, {"floats", randomFloat}};
+
+  volatile double sink = 0;
+  for (const auto& sz : args.sizes) {
+    for (const Kind& k : kinds) {
+      std::string text = makeNumbers(sz.second, k.gen);
+      std::string tag = std::string(k.name) + "/" + sz.first;
+      size_t count = 0;
+      for (char c : text) count += c == ' ';
+
+      runBench("decode/" + tag, count, text.size(), [&]() {
+        const char* p = text.data();
+        const char* end = p + text.size();
+        double sum = 0;
+        NumberValue v;
+        while (p < end) {
+          p += scanNumberLiteral(p, end, v) + 1; // + the space
+          sum += v.asDouble();
+        }
+        sink = sum;
+      });
+
+      runBench("strtod/" + tag, count, text.size(), [&]() {
+        const char* p = text.c_str();
+        const char* end = p + text.size();
+        double sum = 0;
+        while (p < end) {
+          char* stop;
+          sum += std::strtod(p, &stop);
+          p = stop + 1;
+        }
+        sink = sum;
+      });
+
+      runBench("lex/" + tag, count, text.size(), [&]() {
+        std::vector<Token> tokens = Lexer(text).tokenize();
+        double sum = 0;
+        for (const Token& t : tokens) sum += t.number.asDouble();
+        sink = sum;
+      });
+
+      runBench("lex+stod/" + tag, count, text.size(), [&]() {
+        std::vector<Token> tokens = Lexer(text).tokenize();
+        double sum = 0;
+        for (const Token& t : tokens) {
+          if (t.type == "NUMBER") sum += std::stod(t.lexeme);
+        }
+        sink = sum;
+      });
+    }
+  }
+
+  int rc = finishBench(args);
+  if (failures) {
+    std::cerr << "\nDecoded values differ from strtod / strtoll.\n";
+    return 1;
+  }
+  return rc;
+}
@@ -0,0 +1,64 @@
+// Node count and evaluation time of an expression before / after
+// constant folding, identity rewrites and hash consing (CSE).
+//
+// g++ -O2 -I include bench/bench_optimize.cpp -o bench_optimize
+// ./bench_optimize ["expression"] [evaluations]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#include "../include/expr_ast.h"
+#include "../include/expr_optimize.h"
+
+int main(int argc, char* argv[]) {
+  std::string text = argc > 1 ? argv[1]
+    : "(a + b) * (a + b) / c + (2 * 3 - 6) * d + (a + b) * 1 + (c - c) + ((a + b) * (a + b) / c) * (4 / 2 + 0)";
+  size_t evals = argc > 2 ? std::stoul(argv[2]) : 5000000;
+
+  ExprTree tree = parseExpression(text);
+  OptimizeStats stats;
+  ExprTree dag = optimizeExpr(tree, &stats);
+
+  std::cout << "Expression: " << text << "\n";
+  std::cout << "nodes before:\t" << stats.nodesBefore << "\n"
+            << "nodes after:\t" << stats.nodesAfter << "\n"
+            << "folded:\t\t" << stats.folded << "\n"
+            << "identities:\t" << stats.identities << "\n"
+            << "shared:\t\t" << stats.shared << "\n";
+
+  size_t nvars = tree.variables.size();
+  const size_t rows = 1024;
+  std::vector<double> bindings(rows * (nvars ? nvars : 1));
+  std::mt19937_64 rng(7);
+  std::uniform_real_distribution<double> dist(1.0, 100.0);
+  for (auto& v : bindings) v = dist(rng);
+
+  std::vector<double> scratch;
+  for (size_t r = 0; r < rows; ++r) {
+    double a = evalTree(tree, &bindings[r * nvars]);
+    double b = evalDag(dag, &bindings[r * nvars], scratch);
+    double diff = a > b ? a - b : b - a;
+    if (diff > 1e-9 * (a > 0 ? a : -a) + 1e-12) {
+      std::cerr << "Mismatch on row " << r << ": " << a << " vs " << b << "\n";
+      return 1;
+    }
+  }
+
+  auto timeIt = [&](const char* name, auto&& fn) {
+    double sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < evals; ++i) sink += fn(&bindings[(i % rows) * nvars]);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ":\t" << (s * 1e9 / evals) << " ns/eval\t(checksum " << sink << ")\n";
+    return s;
+  };
+
+  double t0 = timeIt("tree walk, original ", [&](const double* v) { return evalTree(tree, v); });
+  timeIt("node order, original", [&](const double* v) { return evalDag(tree, v, scratch); });
+  double t1 = timeIt("node order, optimized", [&](const double* v) { return evalDag(dag, v, scratch); });
+  std::cout << "speedup: " << (t0 / t1) << "x\n";
+  return 0;
+}
@@ -0,0 +1,202 @@
+// PEG / packrat driver (include/peg_engine.h) on two grammars for the same
+// expressions:
+//   - the LL(1) Exp grammar read as a PEG, which never backtracks
+//   - ex_input/peg_expr_grammar.txt,  E : T + E | T - E | T  and the same for
+//     T, which retries T (and F) for every alternative: exponential in the
+//     nesting depth without a memo
+// prints the profile (calls and reentries per rule) and what
+// memoizeReentered() keeps, calls per token and memo hits with all rules /
+// the profiled ones memoized, the memo's fixed size against the
+// [rule][position] table plain packrat would need, calls and ns per token
+// for several memo sizes (also on  L : E , E ; | E , E = , where the first
+// E is only retried after the second one is parsed), and the blowup without
+// a memo on nested parens.
+// checks (exits 1 on a failure): every memo setting, a 2 slot memo and a
+// start rule that ends with "$" accept the same random token strings as the
+// LL1Engine.
+//
+// g++ -O2 -pthread -I include bench/bench_peg.cpp -o bench_peg
+// ./bench_peg [--sizes small,medium,huge] [--huge BYTES] [--json results.json]
+//             [--baseline baseline.json] [--threshold PCT]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+#include "bench_util.h"
+#include "../include/lexer.h"
+#include "../include/parse_table_gen.h"
+#include "../include/ll1_engine.h"
+#include "../include/peg_engine.h"
+
+const char* backtrackingGrammar = "E : T + E\nE : T - E\nE : T\nT : F * T\nT : F / T\nT : F\n"
+                                  "F : ( E )\nF : id\nF : num\n";
+const char* pairRules = "L : E , E ;\nL : E , E =\n"; // put before backtrackingGrammar
+const char* eofRule = "S : E $\n";                     // the start rule matching the EOF token itself
+
+struct Rng {
+  uint64_t x = 88172645463325252ull;
+  uint64_t next() {
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    return x;
+  }
+};
+
+std::string nested(size_t depth) {
+  std::string s;
+  for (size_t i = 0; i < depth; ++i) s += "( ";
+  s += "a";
+  for (size_t i = 0; i < depth; ++i) s += " )";
+  return s;
+}
+
+int main(int argc, char* argv[]) {
+  BenchArgs args = parseBenchArgs(argc, argv);
+  int failures = 0;
+
+  std::string llFile = "Outputs/bench_expr_grammar.txt", pegFile = "Outputs/bench_peg_grammar.txt",
+              pairFile = "Outputs/bench_peg_pair_grammar.txt", eofFile = "Outputs/bench_peg_eof_grammar.txt";
+  writeFile(llFile, exprGrammarText());
+  writeFile(pegFile, backtrackingGrammar);
+  writeFile(pairFile, std::string(pairRules) + backtrackingGrammar);
+  writeFile(eofFile, std::string(eofRule) + backtrackingGrammar);
+  ParseTableGenerator gen;
+  {
+    QuietCout quiet;
+    gen.loadGrammar(llFile);
+    gen.generateTable();
+  }
+  PEGGrammar llGrammar, pegGrammar, pairGrammar, eofGrammar;
+  if (!llGrammar.loadGrammar(llFile) || !pegGrammar.loadGrammar(pegFile) || !pairGrammar.loadGrammar(pairFile) ||
+      !eofGrammar.loadGrammar(eofFile)) {
+    std::cerr << "Failed to load grammars.\n";
+    return 1;
+  }
+
+  RuntimeTokenPolicy policy = RuntimeTokenPolicy::defaults();
+  StringLL1Engine engine(gen.getParseTable(), gen.getTerminals(), gen.getNonTerminals(), gen.getStartSymbol(),
+                         policy);
+  StringPEGEngine pegLL(llGrammar, policy), pegAll(pegGrammar, policy), pegProfiled(pegGrammar, policy),
+                  pegTiny(pegGrammar, policy, 2);
+
+  // ---- profile ----
+  std::vector<Token> sample = Lexer(makeExprInput(64 << 10)).tokenize();
+  pegProfiled.profile(sample);
+  size_t kept = pegProfiled.memoizeReentered();
+  std::printf("profile on %zu tokens of %s:\n", sample.size(), pegFile.c_str());
+  for (size_t r = 0; r < pegGrammar.ruleCount(); ++r) {
+    const auto& p = pegProfiled.getProfile()[r];
+    std::printf("  %-4s %10llu calls %10llu reentries  %s\n", pegGrammar.ruleName(r).c_str(),
+                (unsigned long long)p.calls, (unsigned long long)p.reentries,
+                pegProfiled.isMemoized(r) ? "memoized" : "");
+  }
+  pegLL.profile(sample);
+  size_t keptLL = pegLL.memoizeReentered();
+  std::printf("%zu of %zu rules memoized, %zu of %zu for the ll(1) grammar\n\n", kept, pegGrammar.ruleCount(),
+              keptLL, llGrammar.ruleCount());
+
+  // ---- checks ----
+  {
+    StringPEGEngine pegNone(pegGrammar, policy), pegEof(eofGrammar, policy);
+    pegNone.memoizeAll(false);
+    std::vector<StringPEGEngine*> pegs{&pegLL, &pegAll, &pegProfiled, &pegTiny, &pegNone, &pegEof};
+    engine.setErrorStream(nullptr);
+    for (StringPEGEngine* p : pegs) p->setErrorStream(nullptr);
+    static const char* words[] = { "a", "b", "+", "-", "*", "/", "(", ")", "(", ")", "a", "b" };
+    Rng r;
+    size_t accepted = 0;
+    for (int n = 0; n < 20000; ++n) {
+      std::string s;
+      size_t len = r.next() % 16;
+      for (size_t k = 0; k < len; ++k) s += std::string(words[r.next() % 12]) + " ";
+      if (n % 2 == 0) s = "( a + b ) * " + s + "c"; // some that get further
+      std::vector<Token> tokens = Lexer(s).tokenize();
+      bool expected;
+      {
+        QuietCout quiet;
+        expected = engine.parse(tokens);
+      }
+      accepted += expected;
+      for (StringPEGEngine* p : pegs) {
+        if (p->parse(tokens) != expected) {
+          std::cerr << "MISMATCH on \"" << s << "\": ll1 engine " << expected << "\n";
+          failures++;
+          n = 20000;
+          break;
+        }
+      }
+    }
+    std::printf("peg engines (all, profiled, 2 slot, no memo and S : E $) agree with the ll1 engine on 20000 random "
+                "strings (%zu accepted)\n\n", accepted);
+  }
+
+  // ---- sizes ----
+  for (const auto& sz : args.sizes) {
+    std::string input = makeExprInput(sz.second);
+    std::vector<Token> tokens = Lexer(input).tokenize();
+    std::string tag = "expr/" + sz.first;
+    bool ok;
+    {
+      QuietCout quiet;
+      ok = engine.parse(tokens);
+    }
+    if (!ok || !pegLL.parse(tokens)) failures++;
+    double llCalls = (double)pegLL.callCount() / tokens.size();
+    for (StringPEGEngine* p : {&pegAll, &pegProfiled}) {
+      if (!p->parse(tokens)) failures++;
+      std::printf("%s, %zu tokens, %s: %.2f calls per token (%.2f on the ll(1) grammar), %.1f%% memo hits, "
+                  "%llu evictions, %zu memo bytes (packrat table: %zu)\n", tag.c_str(), tokens.size(),
+                  p == &pegAll ? "all memoized" : "profiled", (double)p->callCount() / tokens.size(), llCalls,
+                  100.0 * p->memoHits() / p->callCount(), (unsigned long long)p->memoEvictions(),
+                  p->memoBytes(), tokens.size() * pegGrammar.ruleCount() * 4);
+    }
+    {
+      QuietCout quiet;
+      runBench("ll1 engine/" + tag, tokens.size(), input.size(), [&]() { engine.parse(tokens); });
+    }
+    runBench("peg ll(1) grammar/" + tag, tokens.size(), input.size(), [&]() { pegLL.parse(tokens); });
+    runBench("peg all memoized/" + tag, tokens.size(), input.size(), [&]() { pegAll.parse(tokens); });
+    runBench("peg profiled/" + tag, tokens.size(), input.size(), [&]() { pegProfiled.parse(tokens); });
+    std::printf("\n");
+  }
+
+  // ---- memo size ----
+  {
+    std::string input = makeExprInput(args.sizes.back().second);
+    std::vector<Token> tokens = Lexer(input).tokenize();
+    std::string half = makeExprInput(args.sizes.back().second / 2);
+    std::vector<Token> pairTokens = Lexer(half + " , " + half + " =").tokenize();
+    std::printf("%-12s %12s %14s %12s %12s %20s\n", "memo slots", "memo bytes", "calls / token", "hits", "evictions",
+                "L : E , E =  calls");
+    for (size_t slots : {2, 16, 256, 4096, 65536}) {
+      StringPEGEngine p(pegGrammar, policy, slots), pair(pairGrammar, policy, slots);
+      p.profile(sample);
+      p.memoizeReentered();
+      if (!p.parse(tokens) || !pair.parse(pairTokens)) failures++;
+      std::printf("%-12zu %12zu %14.2f %11.1f%% %12llu %20.2f\n", slots, p.memoBytes(),
+                  (double)p.callCount() / tokens.size(), 100.0 * p.memoHits() / p.callCount(),
+                  (unsigned long long)p.memoEvictions(), (double)pair.callCount() / pairTokens.size());
+      runBench("peg " + std::to_string(slots) + " slots/expr/" + args.sizes.back().first, tokens.size(),
+               input.size(), [&]() { p.parse(tokens); }, 0.1);
+    }
+    std::printf("\n");
+  }
+
+  // ---- no memo ----
+  std::printf("%-8s %16s %16s\n", "nesting", "calls, no memo", "calls, profiled");
+  StringPEGEngine pegNone(pegGrammar, policy);
+  pegNone.memoizeAll(false);
+  for (size_t depth = 1; depth <= 7; ++depth) {
+    std::vector<Token> tokens = Lexer(nested(depth)).tokenize();
+    if (!pegNone.parse(tokens) || !pegProfiled.parse(tokens)) failures++;
+    std::printf("%-8zu %16llu %16llu\n", depth, (unsigned long long)pegNone.callCount(),
+                (unsigned long long)pegProfiled.callCount());
+  }
+
+  if (failures) {
+    std::cerr << failures << " checks failed.\n";
+    return 1;
+  }
+  return finishBench(args);
+}
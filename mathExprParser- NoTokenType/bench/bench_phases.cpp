@@ -0,0 +1,147 @@
+// Phase benchmarks for the string-typed pipeline: Lexer::tokenize,
+// StreamLexer (checked against tokenize(), exits 1 on a difference, also on
+// input without whitespace and cut in the middle of numbers),
+// ParseTableGenerator (loadGrammar + generateTable), LL1Parser::parse,
+// LL1PushParser and the shared LL1Engine with the runtime token policy, on
+// small / medium / huge inputs and small / large grammars.
+// (the enum-typed pipeline + RD Parser have the same bench in
+// simple_math_expr_parser-A6/bench/bench_phases.cpp)
+//
+// g++ -O2 -pthread -I include bench/bench_phases.cpp -o bench_phases
+// ./bench_phases [--sizes small,medium,huge] [--huge BYTES] [--json results.json]
+//                [--baseline baseline.json] [--threshold PCT]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+#include "bench_util.h"
+#include "../include/lexer.h"
+#include "../include/LL1_parser_ET.h"
+#include "../include/LL1_push_parser.h"
+#include "../include/parse_table_gen.h"
+#include "../include/ll1_engine.h"
+
+std::vector<Token> streamTokens(const std::string& input, size_t chunk) {
+  std::istringstream in(input);
+  StreamLexer lexer(in, chunk);
+  std::vector<Token> tokens;
+  Token t;
+  while (lexer.next(t)) tokens.push_back(t);
+  return tokens;
+}
+
+bool sameTokens(const std::vector<Token>& a, const std::vector<Token>& b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].type != b[i].type || a[i].lexeme != b[i].lexeme) return false;
+  }
+  return true;
+}
+
+struct GrammarCase {
+  std::string name;
+  std::string file;
+  std::string (*makeInput)(size_t);
+};
+
+int main(int argc, char* argv[]) {
+  BenchArgs args = parseBenchArgs(argc, argv);
+  int failures = 0;
+
+  // ---- stream lexer: every chunk size cuts somewhere else ----
+  for (std::string text : {std::string("x=1e+5*2.5E-3+(y/12.)-6e23"), makeExprInput(4096), makeDeclInput(4096)}) {
+    std::string packed = text;
+    packed.erase(std::remove(packed.begin(), packed.end(), ' '), packed.end());
+    for (const std::string& input : {text, packed}) {
+      std::vector<Token> expected;
+      try {
+        expected = Lexer(input).tokenize();
+      } catch (const std::runtime_error&) {
+        continue; // "intx" style merges are fine, unknown characters aren't expected here
+      }
+      for (size_t chunk : {1, 2, 3, 7, 64, 1 << 16}) {
+        if (!sameTokens(streamTokens(input, chunk), expected)) {
+          std::cerr << "MISMATCH: StreamLexer with " << chunk << " byte chunks\n";
+          failures++;
+        }
+      }
+    }
+  }
+
+  std::vector<GrammarCase> grammars = {
+    {"decl", "Outputs/bench_decl_grammar.txt", makeDeclInput},
+    {"expr", "Outputs/bench_expr_grammar.txt", makeExprInput},
+  };
+  writeFile(grammars[0].file, "Decl : datatype id L ;\nL : , id L\nL : epsilon\n"
+                              "datatype : int\ndatatype : float\ndatatype : char\n");
+  writeFile(grammars[1].file, exprGrammarText());
+
+  // ---- table generation ----
+  std::vector<std::pair<std::string, std::string>> tableCases = {
+    {"table/decl", grammars[0].file},
+    {"table/expr", grammars[1].file},
+    {"table/large-300", "Outputs/bench_large_grammar.txt"},
+  };
+  writeFile(tableCases[2].second, largeGrammarText(300));
+  for (const auto& tc : tableCases) {
+    runBench(tc.first + "/string", 1, 0, [&]() {
+      ParseTableGenerator gen;
+      gen.loadGrammar(tc.second);
+      gen.generateTable();
+    });
+  }
+
+  // ---- lexing and parsing ----
+  for (const auto& g : grammars) {
+    ParseTableGenerator gen;
+    {
+      QuietCout quiet;
+      gen.loadGrammar(g.file);
+      gen.generateTable();
+    }
+    ParseTable table = gen.getParseTable();
+    std::set<std::string> terms = gen.getTerminals();
+    std::set<std::string> nonterms = gen.getNonTerminals();
+
+    for (const auto& sz : args.sizes) {
+      std::string input = g.makeInput(sz.second);
+      std::vector<Token> tokens = Lexer(input).tokenize();
+      std::string tag = g.name + "/" + sz.first + "/string";
+
+      runBench("lex/" + tag, tokens.size(), input.size(), [&]() {
+        Lexer lexer(input);
+        std::vector<Token> t = lexer.tokenize();
+      });
+
+      std::string packed = input;
+      packed.erase(std::remove(packed.begin(), packed.end(), ' '), packed.end());
+      runBench("stream/" + tag, tokens.size(), input.size(), [&]() { streamTokens(input, 1 << 16); });
+      runBench("stream-no-spaces/" + tag, tokens.size(), packed.size(), [&]() { streamTokens(packed, 1 << 16); });
+
+      runBench("ll1/" + tag, tokens.size(), input.size(), [&]() {
+        LL1Parser parser(tokens, table, terms, nonterms, gen.getStartSymbol());
+        if (!parser.parse()) std::cerr << "ll1 parse failed on " << tag << "\n";
+      });
+
+      runBench("push/" + tag, tokens.size(), input.size(), [&]() {
+        LL1PushParser parser(table, terms, nonterms, gen.getStartSymbol());
+        for (const Token& t : tokens) parser.feed(t);
+        if (!parser.finish()) std::cerr << "push parse failed on " << tag << "\n";
+      });
+
+      StringLL1Engine engine(table, terms, nonterms, gen.getStartSymbol(), RuntimeTokenPolicy::defaults());
+      runBench("engine/" + tag, tokens.size(), input.size(), [&]() {
+        if (!engine.parse(tokens)) std::cerr << "engine parse failed on " << tag << "\n";
+      });
+    }
+  }
+
+  if (failures) {
+    std::cerr << failures << " checks failed.\n";
+    return 1;
+  }
+  return finishBench(args);
+}
@@ -0,0 +1,94 @@
+// SymbolTable (include/symbol_table.h) with a few million names, enough that
+// the arena goes well past 64 blocks (the block size stops doubling at 1 MB).
+// checks (exits 1 on a failure): every name is found with its type, a
+// second declare of it fails, names that weren't declared aren't found,
+// forEach visits each name once, and the arena wastes at most a block's
+// worth over the names. a NameArena on its own gives every name back and
+// uses about one block per MB of names (the blocks neither shrink nor grow
+// past 1 MB).
+// prints ns per declare / lookup and the memory per name.
+//
+// g++ -O2 -pthread -I include bench/bench_symbol_table.cpp -o bench_symbol_table
+// ./bench_symbol_table [--names N]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <chrono>
+
+#include "../include/symbol_table.h"
+
+std::string nameOf(size_t i) {
+  return "identifier_" + std::to_string(i * 2654435761u % 1000000007u) + "_" + std::to_string(i);
+}
+
+double nsSince(std::chrono::steady_clock::time_point start, size_t ops) {
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / ops;
+}
+
+int main(int argc, char* argv[]) {
+  size_t count = 3000000;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (std::string(argv[i]) == "--names") count = std::stoul(argv[i + 1]);
+  }
+  static const DataType types[] = { DataType::INT, DataType::FLOAT, DataType::CHAR };
+  std::vector<std::string> names(count);
+  for (size_t i = 0; i < count; ++i) names[i] = nameOf(i);
+
+  int failures = 0;
+  SymbolTable table;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    if (!table.declare(names[i], types[i % 3])) failures++;
+  }
+  double declareNs = nsSince(start, count);
+
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    if (table.lookup(names[i]) != types[i % 3]) failures++;
+  }
+  double lookupNs = nsSince(start, count);
+
+  DataType previous = DataType::NONE;
+  for (size_t i = 0; i < count; i += 997) {
+    if (table.declare(names[i], DataType::INT, &previous) || previous != types[i % 3]) failures++;
+    if (table.lookup(names[i] + "x") != DataType::NONE) failures++;
+  }
+  size_t visited = 0;
+  table.forEach([&](std::string_view, DataType) { visited++; });
+  if (visited != count || table.size() != count) failures++;
+
+  // the arena: the names with their 2 byte headers, at most one unused block on top
+  size_t arena = table.memoryBytes(), records = table.identifierBytes() + 2 * count;
+  size_t cap = 2048; // SymbolTable() sizes for 1024 names, then doubles past 3/4 full
+  while (count * 4 > cap * 3) cap <<= 1;
+  size_t slots = cap * 8;
+  std::printf("%zu names, %zu MB of records in a %zu MB arena (%zu MB of slots): %.1f ns per declare, "
+              "%.1f ns per lookup, %.1f bytes per name\n", count, records >> 20, (arena - slots) >> 20, slots >> 20,
+              declareNs, lookupNs, (double)arena / count);
+  if (records < (size_t(64) << 20)) std::printf("  (fewer than 64 blocks, use more --names)\n");
+  if (arena - slots < records || arena - slots > records + records / 64 + (NameArena::blockSize << 1)) {
+    std::cerr << "arena of " << arena - slots << " bytes for " << records << " bytes of records\n";
+    failures++;
+  }
+
+  // the arena alone: the block number is in the reference
+  {
+    NameArena arena;
+    uint32_t last = 0;
+    for (size_t i = 0; i < count; ++i) {
+      last = arena.store(types[i % 3], names[i]);
+      if (i % 101 == 0 && (arena.name(last) != names[i] || arena.type(last) != types[i % 3])) failures++;
+    }
+    size_t blocks = (last >> NameArena::blockBits) + 1;
+    std::printf("  NameArena: %zu blocks for %zu MB of records\n", blocks, records >> 20);
+    if (blocks > (records >> NameArena::blockBits) + 9) failures++; // + the 8 that double up to 1 MB
+  }
+
+  if (failures) {
+    std::cerr << failures << " checks failed.\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,155 @@
+// IR optimization passes (include/tac_optimize.h) on large generated
+// programs: declarations, then assignments with repeated sub-expressions,
+// constant sub-expressions and plain copies. the IR is emitted by the push
+// parser (include/tac_ir.h), then every pass is timed with the instruction
+// count before / after it. the optimized program must leave every variable
+// with the same bits as the original (runTac on random inputs), exits 1 if not.
+//
+// g++ -O2 -pthread -I include bench/bench_tac_opt.cpp -o bench_tac_opt
+// ./bench_tac_opt [statements ...]        (default 10000 100000 1000000)
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "bench_util.h"
+#include "../include/parse_table_gen.h"
+#include "../include/LL1_push_parser.h"
+#include "../include/tac_ir.h"
+#include "../include/tac_optimize.h"
+
+struct Rng {
+  uint64_t x = 88172645463325252ull;
+  uint64_t next() {
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    return x;
+  }
+};
+
+const size_t varCount = 64;
+
+std::string varName(uint64_t i) { return "v" + std::to_string(i % varCount); }
+
+// an operand: a variable, a constant, a constant expression or a recent sub-expression again
+std::string operand(Rng& r, std::vector<std::string>& recent, int depth) {
+  uint64_t k = r.next() % 10;
+  if (k < 4 || depth > 2) return varName(r.next());
+  if (k < 5) return std::to_string(1 + r.next() % 9);
+  if (k < 6) return "( " + std::to_string(1 + r.next() % 9) + " * " + std::to_string(1 + r.next() % 9) + " )";
+  if (k < 8 && !recent.empty()) return recent[r.next() % recent.size()];
+  static const char* ops[] = { " + ", " - ", " * ", " / " };
+  std::string e = "( " + operand(r, recent, depth + 1) + ops[r.next() % 4] + operand(r, recent, depth + 1) + " )";
+  if (recent.size() < 16) recent.push_back(e);
+  else recent[r.next() % recent.size()] = e;
+  return e;
+}
+
+std::string makeProgram(size_t statements) {
+  Rng r;
+  std::string s;
+  for (size_t i = 0; i < varCount; ++i) s += (i % 3 == 0 ? "float " : "int ") + varName(i) + " ;\n";
+  std::vector<std::string> recent;
+  for (size_t i = 0; i < statements; ++i) {
+    if (i % 32 == 0) recent.clear(); // now and then the variables changed under them
+    if (r.next() % 8 == 0) {
+      s += varName(r.next()) + " = " + varName(r.next()) + " ;\n";
+      continue;
+    }
+    s += varName(r.next()) + " = " + operand(r, recent, 0) + " + " + operand(r, recent, 0) + " ;\n";
+  }
+  return s;
+}
+
+bool sameBits(double a, double b) {
+  return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+int main(int argc, char* argv[]) {
+  std::vector<size_t> sizes;
+  for (int i = 1; i < argc; ++i) sizes.push_back(std::stoul(argv[i]));
+  if (sizes.empty()) sizes = {10000, 100000, 1000000};
+
+  std::string grammarFile = "Outputs/bench_program_grammar.txt";
+  writeFile(grammarFile, "Program : Stmt Program\nProgram : epsilon\n"
+                         "Stmt : datatype id L ;\nStmt : id = Exp ;\n"
+                         "L : , id L\nL : epsilon\n"
+                         "datatype : int\ndatatype : float\ndatatype : char\n"
+                         "Exp : Term Expr\nExpr : + Term Expr\nExpr : - Term Expr\nExpr : epsilon\n"
+                         "Term : Factor Termp\nTermp : * Factor Termp\nTermp : / Factor Termp\nTermp : epsilon\n"
+                         "Factor : ( Exp )\nFactor : id\nFactor : num\n");
+  ParseTableGenerator gen;
+  {
+    QuietCout quiet;
+    if (!gen.loadGrammar(grammarFile)) {
+      std::cerr << "Failed to load grammar.\n";
+      return 1;
+    }
+    gen.generateTable();
+  }
+  ParseTable table = gen.getParseTable();
+  std::set<std::string> terms = gen.getTerminals();
+  std::set<std::string> nonterms = gen.getNonTerminals();
+
+  int failures = 0;
+  for (size_t statements : sizes) {
+    std::string text = makeProgram(statements);
+
+    auto start = std::chrono::steady_clock::now();
+    LL1PushParser parser(table, terms, nonterms, gen.getStartSymbol());
+    parser.setErrorStream(nullptr);
+    TacEmitter emitter;
+    parser.setActions(&emitter);
+    Lexer lexer(text);
+    std::vector<Token> tokens = lexer.tokenize();
+    for (const Token& t : tokens) {
+      if (!parser.feed(t)) break;
+    }
+    if (!parser.finish()) {
+      std::cerr << "Generated program doesn't parse: " << parser.getError() << "\n";
+      return 1;
+    }
+    TacProgram original = emitter.finish();
+    double emitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    TacProgram prog = original;
+    std::vector<PassStats> passes = optimizeTac(prog);
+
+    std::printf("%zu statements, %zu tokens: %zu instructions, %u registers (lex + parse + emit %.1f ms)\n",
+                statements, tokens.size(), original.code.size(), original.registers, emitMs);
+    std::printf("  %-18s %12s %12s %10s %10s %8s %10s\n", "pass", "before", "after", "removed", "rewrites",
+                "visits", "ms");
+    double totalMs = 0;
+    for (const PassStats& s : passes) {
+      std::printf("  %-18s %12zu %12zu %10zu %10zu %8zu %10.2f\n", s.name.c_str(), s.before, s.after,
+                  s.before - s.after, s.rewrites, s.visits, s.ms);
+      totalMs += s.ms;
+    }
+    std::printf("  %-18s %12zu %12zu %9.1f%% %10s %8s %10.2f\n\n", "total", original.code.size(), prog.code.size(),
+                100.0 * (original.code.size() - prog.code.size()) / original.code.size(), "", "", totalMs);
+
+    Rng r;
+    for (int trial = 0; trial < 3; ++trial) {
+      std::vector<double> a(original.variables.size()), b;
+      for (double& v : a) v = 1.0 + (double)(r.next() % 1000) / 7.0;
+      b = a;
+      runTac(original, a);
+      runTac(prog, b);
+      for (size_t i = 0; i < a.size(); ++i) {
+        if (!sameBits(a[i], b[i]) && !(a[i] != a[i] && b[i] != b[i])) { // NaN payloads may differ
+          std::cerr << "MISMATCH " << original.variables[i] << ": " << a[i] << " vs " << b[i] << "\n";
+          failures++;
+          break;
+        }
+      }
+    }
+  }
+  if (failures) {
+    std::cerr << "Optimized programs compute different values.\n";
+    return 1;
+  }
+  std::cout << "Optimized programs leave every variable with the same bits.\n";
+  return 0;
+}
@@ -0,0 +1,275 @@
+#ifndef BENCH_UTIL_H
+#define BENCH_UTIL_H
+
+// Shared pieces of the phase benchmarks (bench_phases.cpp in both trees):
+// allocation counting, peak RSS, input builders, timing loop, JSON results
+// and the comparison against a stored baseline.
+// include from exactly one .cpp, it replaces the global operator new/delete.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <sys/resource.h>
+
+// ---- allocation counting ----
+
+std::atomic<uint64_t> g_allocCount(0);
+std::atomic<uint64_t> g_allocBytes(0);
+
+// gcc cannot see that these deletes pair with the malloc based new below
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(std::size_t n) {
+  g_allocCount.fetch_add(1, std::memory_order_relaxed);
+  g_allocBytes.fetch_add(n, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// over-aligned new, std::pmr::new_delete_resource() goes through this one
+void* operator new(std::size_t n, std::align_val_t al) {
+  g_allocCount.fetch_add(1, std::memory_order_relaxed);
+  g_allocBytes.fetch_add(n, std::memory_order_relaxed);
+  size_t a = (size_t)al;
+  if (void* p = std::aligned_alloc(a, (n + a - 1) / a * a)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#pragma GCC diagnostic pop
+
+// peak resident set size of the process so far, in KB (Linux)
+long peakRssKb() {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF, &ru);
+  return ru.ru_maxrss;
+}
+
+// ---- silencing the parsers' step by step std::cout logging ----
+
+class NullBuffer : public std::streambuf {
+protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+struct QuietCout {
+  NullBuffer null;
+  std::streambuf* old;
+  QuietCout() : old(std::cout.rdbuf(&null)) {}
+  ~QuietCout() { std::cout.rdbuf(old); }
+};
+
+// ---- inputs ----
+
+// one long declaration: int v0 , v1 , ... ;  (about bytes long)
+std::string makeDeclInput(size_t bytes) {
+  std::string s = "int v0";
+  for (size_t i = 1; s.size() + 2 < bytes; ++i) s += " , v" + std::to_string(i);
+  s += " ;";
+  return s;
+}
+
+// one long expression out of + - * / and parenthesised groups (about bytes long)
+std::string makeExprInput(size_t bytes) {
+  static const char* ops[] = { " + ", " * ", " - ", " / " };
+  std::string s = "a";
+  uint64_t x = 88172645463325252ull;
+  for (size_t i = 1; s.size() < bytes; ++i) {
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    s += ops[x % 4];
+    if (x % 5 == 0) s += "( b" + std::to_string(i % 100) + " + c * d )";
+    else s += "x" + std::to_string(i % 1000);
+  }
+  return s;
+}
+
+std::string exprGrammarText() {
+  return "Exp : Term Expr\nExpr : + Term Expr\nExpr : - Term Expr\nExpr : epsilon\n"
+         "Term : Factor Termp\nTermp : * Factor Termp\nTermp : / Factor Termp\nTermp : epsilon\n"
+         "Factor : ( Exp )\nFactor : id\nFactor : num\n";
+}
+
+// big LL(1) grammar: n chained nonterminals, each with its own terminals
+//   R0 : t0 id R1 | u0 R1 | id     ...   Rn : ;
+std::string largeGrammarText(size_t n) {
+  std::string g;
+  for (size_t i = 0; i < n; ++i) {
+    std::string r = "R" + std::to_string(i), next = "R" + std::to_string(i + 1);
+    g += r + " : t" + std::to_string(i) + " id " + next + "\n";
+    g += r + " : u" + std::to_string(i) + " " + next + "\n";
+    g += r + " : id\n";
+  }
+  g += "R" + std::to_string(n) + " : ;\n";
+  return g;
+}
+
+bool writeFile(const std::string& path, const std::string& text) {
+  std::ofstream out(path);
+  out << text;
+  return (bool)out;
+}
+
+// ---- measuring ----
+
+struct BenchResult {
+  std::string name;
+  double nsPerOp;      // per token for lex/parse, per run for table generation
+  double mbPerSec;     // input bytes (0 when not meaningful)
+  uint64_t allocs;     // allocations in one run
+  uint64_t allocBytes;
+  long peakRssKb;
+};
+
+std::vector<BenchResult> g_results;
+
+// Runs fn until about minSeconds have passed (at least once, after one warm up run).
+// ops = tokens (or 1) per run, bytes = input size per run (0 = skip MB/s)
+void runBench(const std::string& name, size_t ops, size_t bytes,
+              const std::function<void()>& fn, double minSeconds = 0.3) {
+  {
+    QuietCout quiet;
+    fn(); // warm up
+
+    uint64_t a0 = g_allocCount.load(), b0 = g_allocBytes.load();
+    fn();
+    uint64_t allocs = g_allocCount.load() - a0, allocBytes = g_allocBytes.load() - b0;
+
+    size_t reps = 0;
+    auto start = std::chrono::steady_clock::now();
+    double s = 0;
+    do {
+      fn();
+      reps++;
+      s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (s < minSeconds);
+
+    BenchResult r;
+    r.name = name;
+    r.nsPerOp = s * 1e9 / reps / (ops ? ops : 1);
+    r.mbPerSec = bytes ? bytes * reps / s / 1e6 : 0;
+    r.allocs = allocs;
+    r.allocBytes = allocBytes;
+    r.peakRssKb = peakRssKb();
+    g_results.push_back(r);
+  }
+  const BenchResult& r = g_results.back();
+  std::printf("%-34s %12.2f ns/op %10.2f MB/s %12llu allocs %14llu bytes %9ld KB rss\n",
+              r.name.c_str(), r.nsPerOp, r.mbPerSec, (unsigned long long)r.allocs,
+              (unsigned long long)r.allocBytes, r.peakRssKb);
+}
+
+// ---- JSON results + baseline ----
+
+// one result object per line, so the baseline reader can stay simple
+bool saveResultsJson(const std::string& path) {
+  std::ofstream out(path);
+  if (!out) return false;
+  out << "[\n";
+  for (size_t i = 0; i < g_results.size(); ++i) {
+    const BenchResult& r = g_results[i];
+    out << "  {\"name\": \"" << r.name << "\", \"ns_per_op\": " << r.nsPerOp
+        << ", \"mb_per_s\": " << r.mbPerSec << ", \"allocs\": " << r.allocs
+        << ", \"alloc_bytes\": " << r.allocBytes << ", \"peak_rss_kb\": " << r.peakRssKb << "}"
+        << (i + 1 < g_results.size() ? "," : "") << "\n";
+  }
+  out << "]\n";
+  return true;
+}
+
+// name -> ns_per_op from a file written by saveResultsJson
+std::map<std::string, double> loadBaselineJson(const std::string& path) {
+  std::map<std::string, double> base;
+  std::ifstream in(path);
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t n = line.find("\"name\": \"");
+    size_t v = line.find("\"ns_per_op\": ");
+    if (n == std::string::npos || v == std::string::npos) continue;
+    n += 9;
+    std::string name = line.substr(n, line.find('"', n) - n);
+    base[name] = std::atof(line.c_str() + v + 13);
+  }
+  return base;
+}
+
+// prints the change per benchmark, returns the number slower than threshold (e.g. 0.10)
+int compareWithBaseline(const std::string& path, double threshold) {
+  std::map<std::string, double> base = loadBaselineJson(path);
+  if (base.empty()) {
+    std::cerr << "No baseline results in " << path << "\n";
+    return 0;
+  }
+  int regressions = 0;
+  std::printf("\n%-34s %12s %12s %8s\n", "benchmark", "baseline", "now", "change");
+  for (const BenchResult& r : g_results) {
+    auto it = base.find(r.name);
+    if (it == base.end() || it->second <= 0) continue;
+    double change = (r.nsPerOp - it->second) / it->second;
+    bool slow = change > threshold;
+    regressions += slow;
+    std::printf("%-34s %12.2f %12.2f %+7.1f%%%s\n", r.name.c_str(), it->second, r.nsPerOp,
+                change * 100, slow ? "  REGRESSION" : "");
+  }
+  return regressions;
+}
+
+// common command line: --sizes small,medium,huge --huge BYTES --json FILE
+//                      --baseline FILE --threshold PCT
+struct BenchArgs {
+  std::vector<std::pair<std::string, size_t>> sizes;
+  std::string jsonOut;
+  std::string baseline;
+  double threshold = 0.10;
+};
+
+BenchArgs parseBenchArgs(int argc, char* argv[]) {
+  BenchArgs args;
+  std::string sizeList = "small,medium,huge";
+  size_t huge = 16u << 20;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    std::string key = argv[i], val = argv[i + 1];
+    if (key == "--sizes") sizeList = val;
+    else if (key == "--huge") huge = std::stoull(val);
+    else if (key == "--json") args.jsonOut = val;
+    else if (key == "--baseline") args.baseline = val;
+    else if (key == "--threshold") args.threshold = std::stod(val) / 100.0;
+    else std::cerr << "Ignoring unknown option " << key << "\n";
+  }
+  std::stringstream ss(sizeList);
+  std::string s;
+  while (std::getline(ss, s, ',')) {
+    if (s == "small") args.sizes.push_back({s, 1u << 10});
+    else if (s == "medium") args.sizes.push_back({s, 1u << 20});
+    else if (s == "huge") args.sizes.push_back({s, huge});
+  }
+  return args;
+}
+
+// writes JSON / compares, returns the process exit code
+int finishBench(const BenchArgs& args) {
+  if (!args.jsonOut.empty()) {
+    if (saveResultsJson(args.jsonOut)) std::cout << "\nResults saved to " << args.jsonOut << "\n";
+    else std::cerr << "Could not write " << args.jsonOut << "\n";
+  }
+  if (!args.baseline.empty() && compareWithBaseline(args.baseline, args.threshold) > 0) {
+    std::cerr << "\nRegressions above " << (args.threshold * 100) << "% found.\n";
+    return 1;
+  }
+  return 0;
+}
+
+#endif // BENCH_UTIL_H
@@ -0,0 +1,60 @@
+// Tree walk vs bytecode VM on one expression evaluated many times
+// with different variable bindings.
+//
+// g++ -O2 -I include bench/bench_vm.cpp -o bench_vm
+// ./bench_vm ["expression"] [evaluations]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <random>
+
+#include "../include/expr_ast.h"
+#include "../include/expr_vm.h"
+
+int main(int argc, char* argv[]) {
+  std::string text = argc > 1 ? argv[1] : "(a + b) * (c - d) / (e + 2) + a * b * 3 - (c / (d + 1))";
+  size_t evals = argc > 2 ? std::stoul(argv[2]) : 10000000;
+
+  ExprTree tree = parseExpression(text);
+  Bytecode bc = compileExpr(tree);
+  ExprVM vm(bc);
+  size_t nvars = tree.variables.size();
+
+  std::cout << "Expression: " << text << "\n";
+  std::cout << tree.nodes.size() << " nodes, " << bc.code.size() << " instructions, "
+            << nvars << " variables, max stack " << bc.maxStack << "\n";
+  std::cout << disassemble(bc);
+
+  // a pool of bindings so the loop is not just re-evaluating constants
+  const size_t rows = 1024;
+  std::vector<double> bindings(rows * (nvars ? nvars : 1));
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> dist(1.0, 100.0);
+  for (auto& v : bindings) v = dist(rng);
+
+  for (size_t r = 0; r < rows; ++r) {
+    const double* vars = &bindings[r * nvars];
+    double a = evalTree(tree, vars), b = vm.run(bc, vars);
+    if (a != b && !(a != a && b != b)) {
+      std::cerr << "Mismatch on row " << r << ": tree " << a << " vm " << b << "\n";
+      return 1;
+    }
+  }
+
+  auto timeIt = [&](const char* name, auto&& fn) {
+    double sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < evals; ++i) sink += fn(&bindings[(i % rows) * nvars]);
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << name << ":\t" << (s * 1e9 / evals) << " ns/eval\t"
+              << (evals / s / 1e6) << " M evals/s\t(checksum " << sink << ")\n";
+    return s;
+  };
+
+  double tTree = timeIt("tree walk", [&](const double* v) { return evalTree(tree, v); });
+  double tVm = timeIt("bytecode vm", [&](const double* v) { return vm.run(bc, v); });
+  std::cout << "speedup: " << (tTree / tVm) << "x\n";
+  return 0;
+}
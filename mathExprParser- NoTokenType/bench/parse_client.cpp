@@ -0,0 +1,227 @@
+// Load generator for the parse server (parser --serve): N connections, each
+// on its own thread, keeping up to --depth requests in flight. prints
+// throughput and latency percentiles (send of a request -> its response line).
+//
+// g++ -O2 -pthread bench/parse_client.cpp -o parse_client
+// ./parser --serve /tmp/parser.sock decl=ex_input/grammar.txt &
+// ./parse_client --socket /tmp/parser.sock [--grammar decl] [--conns 4]
+//                [--requests 100000] [--depth 1] [--input lines.txt]
+//                [--tree] [--framed]
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using Clock = std::chrono::steady_clock;
+
+struct ClientArgs {
+  std::string socketPath = "/tmp/parser.sock";
+  std::string grammar = "decl";
+  size_t conns = 4;
+  size_t requests = 100000; // total, split over the connections
+  size_t depth = 1;
+  std::string inputFile;
+  bool tree = false;
+  bool framed = false;
+};
+
+struct ConnStats {
+  std::vector<double> latenciesUs;
+  size_t ok = 0, failed = 0;
+  std::string firstError;
+};
+
+int connectTo(const std::string& path) {
+  int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+  if (fd < 0 || ::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+    if (fd >= 0) ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+bool sendAll(int fd, const std::string& data) {
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t n = ::send(fd, data.data() + done, data.size() - done, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    done += n;
+  }
+  return true;
+}
+
+// reads responses (newline or #<n> framed) out of a socket
+class ResponseReader {
+  int fd;
+  std::string buf;
+  size_t pos = 0;
+
+  bool fill() {
+    if (pos > 0) {
+      buf.erase(0, pos);
+      pos = 0;
+    }
+    char tmp[1 << 16];
+    ssize_t n;
+    do n = ::read(fd, tmp, sizeof(tmp)); while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    buf.append(tmp, n);
+    return true;
+  }
+
+public:
+  explicit ResponseReader(int f) : fd(f) {}
+
+  bool next(std::string& resp, bool framed) {
+    while (true) {
+      size_t nl = buf.find('\n', pos);
+      if (nl != std::string::npos) {
+        if (!framed) {
+          resp.assign(buf, pos, nl - pos);
+          pos = nl + 1;
+          return true;
+        }
+        size_t len = std::stoul(buf.substr(pos + 1, nl - pos - 1));
+        if (buf.size() - (nl + 1) >= len) {
+          resp.assign(buf, nl + 1, len);
+          pos = nl + 1 + len;
+          return true;
+        }
+      }
+      if (!fill()) return false;
+    }
+  }
+};
+
+void runConnection(const ClientArgs& args, const std::vector<std::string>& texts,
+                   size_t count, size_t offset, ConnStats& stats) {
+  int fd = connectTo(args.socketPath);
+  if (fd < 0) {
+    stats.firstError = "connect to " + args.socketPath + " failed: " + std::strerror(errno);
+    stats.failed = count;
+    return;
+  }
+  ResponseReader reader(fd);
+  std::string cmd = std::string(args.tree ? "TREE " : "PARSE ") + args.grammar + " ";
+  std::deque<Clock::time_point> inFlight;
+  stats.latenciesUs.reserve(count);
+
+  size_t sent = 0, received = 0;
+  std::string out, resp;
+  while (received < count) {
+    // top up to depth requests in flight, one write for all of them
+    out.clear();
+    while (sent < count && inFlight.size() < args.depth) {
+      std::string req = cmd + texts[(offset + sent) % texts.size()];
+      if (args.framed) out += "#" + std::to_string(req.size()) + "\n" + req;
+      else out += req + "\n";
+      inFlight.push_back(Clock::now());
+      sent++;
+    }
+    if (!out.empty() && !sendAll(fd, out)) break;
+
+    if (!reader.next(resp, args.framed)) break;
+    stats.latenciesUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - inFlight.front()).count());
+    inFlight.pop_front();
+    received++;
+    if (resp.compare(0, 2, "OK") == 0) stats.ok++;
+    else {
+      stats.failed++;
+      if (stats.firstError.empty()) stats.firstError = resp;
+    }
+  }
+  if (received < count) {
+    stats.failed += count - received;
+    if (stats.firstError.empty()) stats.firstError = "connection closed early";
+  }
+  ::close(fd);
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  size_t i = std::min(sorted.size() - 1, (size_t)(p * sorted.size()));
+  return sorted[i];
+}
+
+int main(int argc, char* argv[]) {
+  ClientArgs args;
+  for (int i = 1; i < argc; ++i) {
+    std::string key = argv[i];
+    if (key == "--tree") { args.tree = true; continue; }
+    if (key == "--framed") { args.framed = true; continue; }
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << key << "\n";
+      return 1;
+    }
+    std::string val = argv[++i];
+    if (key == "--socket") args.socketPath = val;
+    else if (key == "--grammar") args.grammar = val;
+    else if (key == "--conns") args.conns = std::max<size_t>(1, std::stoul(val));
+    else if (key == "--requests") args.requests = std::stoul(val);
+    else if (key == "--depth") args.depth = std::max<size_t>(1, std::stoul(val));
+    else if (key == "--input") args.inputFile = val;
+    else std::cerr << "Ignoring unknown option " << key << "\n";
+  }
+
+  // request texts: one per line of --input, or a few declarations
+  std::vector<std::string> texts;
+  if (!args.inputFile.empty()) {
+    std::ifstream in(args.inputFile);
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty()) texts.push_back(line);
+    }
+    if (texts.empty()) {
+      std::cerr << "No request lines in " << args.inputFile << "\n";
+      return 1;
+    }
+  } else {
+    texts = {"int x , y , z ;", "float a ;", "char c1 , c2 ;", "int v0 , v1 , v2 , v3 , v4 , v5 ;"};
+  }
+
+  std::vector<ConnStats> stats(args.conns);
+  std::vector<std::thread> threads;
+  auto start = Clock::now();
+  for (size_t c = 0; c < args.conns; ++c) {
+    size_t count = args.requests / args.conns + (c < args.requests % args.conns);
+    threads.emplace_back(runConnection, std::cref(args), std::cref(texts), count, c, std::ref(stats[c]));
+  }
+  for (auto& t : threads) t.join();
+  double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+  std::vector<double> all;
+  size_t ok = 0, failed = 0;
+  std::string firstError;
+  for (auto& s : stats) {
+    all.insert(all.end(), s.latenciesUs.begin(), s.latenciesUs.end());
+    ok += s.ok;
+    failed += s.failed;
+    if (firstError.empty()) firstError = s.firstError;
+  }
+  std::sort(all.begin(), all.end());
+
+  std::printf("%zu requests (%zu ok, %zu failed) on %zu connections, depth %zu, in %.3f s\n",
+              ok + failed, ok, failed, args.conns, args.depth, secs);
+  std::printf("throughput %.0f req/s\n", secs > 0 ? all.size() / secs : 0.0);
+  std::printf("latency us: p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+              percentile(all, 0.50), percentile(all, 0.90), percentile(all, 0.99),
+              percentile(all, 0.999), all.empty() ? 0.0 : all.back());
+  if (!firstError.empty()) std::cout << "first error: " << firstError << "\n";
+  return failed ? 1 : 0;
+}
@@ -11,12 +11,14 @@
 #include <set>
 #include <stdexcept>
 #include "lexer.h" // lexer included for token struct
+#include "metrics.h"
+#include "ll1_engine.h"
 
 using ParseTable = std::map<std::string, std::map<std::string, std::vector<std::string>>>;
 
 std::string tokenToParserSymbol(const Token& token) {
   if (token.type == "ID") return "id";
-  // if (token.type == "NUMBER") return "id"; 
+  if (token.type == "NUMBER") return "num";
 
   if (token.type == "DATATYPE") {
     return token.lexeme; // e.g., "int", "float", "char"
@@ -42,7 +44,9 @@ std::string tokenToParserSymbol(const Token& token) {
 }
 
 
-class LL1Parser {
+// Tracing front end over the shared LL1Engine (include/ll1_engine.h): the
+// engine parses, this prints every step and the errors in the usual format.
+class LL1Parser : private LL1Trace {
 public:
   ParseTable table;
   std::set<std::string> terminals;
@@ -55,16 +59,19 @@ public:
           const std::set<std::string>& terms,
           const std::set<std::string>& nonTerms,
           const std::string& startSym)
-    : tokens(t),
-      table(parseTable),
+    : table(parseTable),
       terminals(terms),
       nonTerminals(nonTerms),
-      startSymbol(startSym)
+      startSymbol(startSym),
+      tokens(t),
+      engine(parseTable, terms, nonTerms, startSym, RuntimeTokenPolicy::defaults())
   {
     if (startSymbol.empty() && !nonTerminals.empty()) {
       std::cerr << "Warning: Start symbol not provided or empty.\n";
     }
     terminals.insert("$"); // $ is treated as a terminal
+    engine.setErrorStream(nullptr); // errors are printed by the trace below
+    engine.setTrace(this);
   }
 
   bool parse() {
@@ -81,101 +88,69 @@ public:
       return false;
     }
 
-    int tokenIndex = 0;
-    std::stack<std::string> parseStack;
-    parseStack.push("$");
-    parseStack.push(startSymbol);
-
     std::cout << "\n--- Starting Parse ---" << std::endl;
+    reported = false;
+    if (engine.parse(tokens)) {
+      std::cout << "Parse successful!\n";
+      return true;
+    }
+    if (!reported) std::cerr << engine.getError(); // not a token error (no EOF token at the end)
+    return false;
+  }
+
+private:
+  StringLL1Engine engine;
+  bool reported = false;
 
-    while (!parseStack.empty()) {
-      std::string stackTop = parseStack.top();
-      std::string currentTokenSymbol = "$";
-      std::string currentLexeme = "EOF";
-
-      if (tokenIndex < tokens.size()) {
-        currentTokenSymbol = tokenToParserSymbol(tokens[tokenIndex]);
-        currentLexeme = tokens[tokenIndex].lexeme;
-        if (tokens[tokenIndex].type == "EOF") {
-          currentLexeme = "$";
-          currentTokenSymbol = "$"; // Ensure EOF maps to $ symbol via function
-        }
-      } else if (stackTop != "$"){
-        std::cerr << "Syntax Error: Unexpected end of input. Expected token for stack symbol '" << stackTop << "'.\n";
-        return false;
-      }
-
-      std::cout << "Stack top: '" << stackTop
-                << "', Current token symbol: '" << currentTokenSymbol
-                << "' (Lexeme: '" << currentLexeme << "')" << std::endl;
-
-      if (terminals.count(stackTop)) {
-        if (stackTop == currentTokenSymbol) {
-          std::cout << "  Action: Matched terminal '" << stackTop << "'. Popping stack, advancing input.\n";
-          parseStack.pop();
-          tokenIndex++;
-
-          if (stackTop == "$") {
-            if (tokenIndex >= tokens.size() || tokens[tokenIndex-1].type == "EOF") {
-              std::cout << "Parse successful!\n";
-              return true;
-            } else {
-              std::cerr << "Syntax Error: Input remaining after end-of-input marker '$' was processed. Next token: '"
-                        << tokens[tokenIndex].lexeme << "' (Symbol: '" << tokenToParserSymbol(tokens[tokenIndex]) << "').\n";
-              return false;
-            }
-          }
-        } else {
-          std::cerr << "Syntax Error: Mismatch. Expected terminal '" << stackTop
-                    << "' but found token '" << currentTokenSymbol
-                    << "' (Lexeme: '" << currentLexeme << "').\n";
-          return false;
-        }
-      }
-      else if (nonTerminals.count(stackTop)) {
-        if (table.count(stackTop) && table.at(stackTop).count(currentTokenSymbol)) {
-          const std::vector<std::string>& production = table.at(stackTop).at(currentTokenSymbol);
-
-          std::cout << "  Action: Apply rule " << stackTop << " ->";
-          for (const auto& sym : production) std::cout << " '" << sym << "'";
-          std::cout << ". Popping stack, pushing production.\n";
-
-          parseStack.pop();
-
-          if (!(production.size() == 1 && production[0] == "epsilon")) {
-            for (int i = production.size() - 1; i >= 0; --i) {
-              if (!terminals.count(production[i]) && !nonTerminals.count(production[i])) {
-                std::cerr << "Internal Error: Grammar production for '" << stackTop << "' contains unknown symbol '" << production[i] << "' that is neither terminal nor non-terminal.\n";
-                return false;
-              }
-              parseStack.push(production[i]);
-            }
-          } else {
-            std::cout << "  (Epsilon production, only popped stack)\n";
-          }
-        } else {
-          std::cerr << "Syntax Error: No production rule found for Non-Terminal '" << stackTop
-                    << "' with lookahead token symbol '" << currentTokenSymbol
-                    << "' (Lexeme: '" << currentLexeme << "').\n";
-          if (table.count(stackTop)) {
-            std::cerr << "  Possible expected token symbols for '" << stackTop << "':";
-            for(const auto& pair : table.at(stackTop)) std::cerr << " '" << pair.first << "'";
-            std::cerr << std::endl;
-          } else {
-            std::cerr << "  Non-terminal '" << stackTop << "' has no rules defined in the parse table.\n";
-          }
-          return false;
-        }
-      }
-      else {
-        std::cerr << "Internal Error: Symbol '" << stackTop
-                  << "' on stack is neither a known terminal nor a non-terminal. Check grammar/sets generation.\n";
-        return false;
-      }
+  // the lookahead as the old printing parser showed it, EOF as "$"
+  std::string symbolAt(size_t i) const {
+    return tokens[i].type == "EOF" ? "$" : tokenToParserSymbol(tokens[i]);
+  }
+  std::string lexemeAt(size_t i) const {
+    return tokens[i].type == "EOF" ? "$" : tokens[i].lexeme;
+  }
+
+  void step(const std::string& top, size_t i) override {
+    std::cout << "Stack top: '" << top
+              << "', Current token symbol: '" << symbolAt(i)
+              << "' (Lexeme: '" << lexemeAt(i) << "')" << std::endl;
+  }
+
+  void match(const std::string& terminal, size_t) override {
+    std::cout << "  Action: Matched terminal '" << terminal << "'. Popping stack, advancing input.\n";
+  }
+
+  void expand(const std::string& nonTerminal, const std::vector<std::string>& body, size_t) override {
+    std::cout << "  Action: Apply rule " << nonTerminal << " ->";
+    for (const auto& sym : body) std::cout << " '" << sym << "'";
+    std::cout << ". Popping stack, pushing production.\n";
+    if (body.size() == 1 && body[0] == "epsilon") std::cout << "  (Epsilon production, only popped stack)\n";
+  }
+
+  void mismatch(const std::string& expected, size_t i) override {
+    reported = true;
+    if (!terminals.count(expected)) {
+      std::cerr << "Internal Error: Grammar symbol '" << expected
+                << "' is neither terminal nor non-terminal. Check grammar/sets generation.\n";
+      return;
     }
+    std::cerr << "Syntax Error: Mismatch. Expected terminal '" << expected
+              << "' but found token '" << symbolAt(i)
+              << "' (Lexeme: '" << lexemeAt(i) << "').\n";
+  }
 
-    std::cerr << "Syntax Error: Parsing ended unexpectedly. Stack empty, but end condition not met?\n";
-    return false;
+  void noProduction(const std::string& nonTerminal, size_t i) override {
+    reported = true;
+    std::cerr << "Syntax Error: No production rule found for Non-Terminal '" << nonTerminal
+              << "' with lookahead token symbol '" << symbolAt(i)
+              << "' (Lexeme: '" << lexemeAt(i) << "').\n";
+    if (table.count(nonTerminal)) {
+      std::cerr << "  Possible expected token symbols for '" << nonTerminal << "':";
+      for (const auto& pair : table.at(nonTerminal)) std::cerr << " '" << pair.first << "'";
+      std::cerr << std::endl;
+    } else {
+      std::cerr << "  Non-terminal '" << nonTerminal << "' has no rules defined in the parse table.\n";
+    }
   }
 };
 
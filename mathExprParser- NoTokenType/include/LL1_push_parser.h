@@ -0,0 +1,224 @@
+#ifndef LL1_PUSH_PARSER_H
+#define LL1_PUSH_PARSER_H
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <stack>
+#include <string>
+#include <map>
+#include <set>
+#include <memory_resource>
+#include "lexer.h"
+#include "LL1_parser_ET.h" // ParseTable + tokenToParserSymbol
+#include "metrics.h"
+
+// Push style version of LL1Parser: instead of owning the whole token vector
+// the caller feeds one token at a time and the parse stack is kept between calls.
+// this lets the lexer and parser run in one pass without a token vector in between.
+//
+//   LL1PushParser p(table, terms, nonterms, start);
+//   while (lexer.next(tok)) if (!p.feed(tok)) break;
+//   p.finish();
+//
+// setActions() runs semantic actions while parsing: shift() for every matched
+// terminal, reduce() when a nonterminal's production is done (its last symbol
+// matched). the IR emitter (tac_ir.h) works this way, without a tree.
+//
+// the stack keeps its capacity over reset(), so once it has grown to the
+// deepest parse seen, feeding a valid input allocates nothing. its storage
+// comes from the memory_resource given to the constructor (alloc_tracking.h)
+
+// semantic actions, see LL1PushParser::setActions
+class ParseActions {
+public:
+  virtual ~ParseActions() {}
+  virtual void shift(const Token& token) = 0;        // token matched a terminal ('$' excluded)
+  virtual void reduce(const std::string& nonTerminal) = 0; // all of its production matched
+};
+
+class LL1PushParser {
+private:
+  const ParseTable& table;
+  const std::set<std::string>& terminals;
+  const std::set<std::string>& nonTerminals;
+  std::string startSymbol;
+
+  std::stack<std::string, std::pmr::vector<std::string>> parseStack;
+  size_t tokenCount; // tokens consumed so far, used for error positions
+  bool failed;
+  bool accepted;
+  std::string error;     // message of the first error
+  std::ostream* errOut;  // where errors are echoed, nullptr = keep quiet
+  std::string* treeOut;  // parse tree as an s-expression, nullptr = not recorded
+  ParseActions* actions; // nullptr = none
+  std::pmr::vector<const std::string*> open; // nonterminals whose close marker is on the stack
+  ParseCounters stats;   // published when the parse is accepted or fails
+
+  // stack marker closing a nonterminal's node (tree output, reduce actions),
+  // can't clash with a grammar symbol (those never contain control chars)
+  static const std::string& treeClose() {
+    static const std::string marker = "\x01)";
+    return marker;
+  }
+
+  bool fail(const std::string& message) {
+    METRIC_ONLY(stats.publish();)
+    failed = true;
+    error = message;
+    if (errOut) *errOut << message;
+    return false;
+  }
+
+public:
+  LL1PushParser(const ParseTable& parseTable,
+                const std::set<std::string>& terms,
+                const std::set<std::string>& nonTerms,
+                const std::string& startSym,
+                std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+    : table(parseTable),
+      terminals(terms),
+      nonTerminals(nonTerms),
+      startSymbol(startSym),
+      parseStack(std::pmr::vector<std::string>(mr)),
+      tokenCount(0),
+      failed(false),
+      accepted(false),
+      errOut(&std::cerr),
+      treeOut(nullptr),
+      actions(nullptr),
+      open(mr)
+  {
+    reset();
+  }
+
+  // Start over with a fresh stack (same grammar)
+  void reset() {
+    METRIC_ONLY(stats.publish();) // an abandoned parse still counts
+    while (!parseStack.empty()) parseStack.pop(); // not reassigned, that would drop the capacity
+    parseStack.push("$");
+    parseStack.push(startSymbol);
+    open.clear();
+    tokenCount = 0;
+    failed = false;
+    accepted = false;
+    error.clear();
+    if (startSymbol.empty() || !nonTerminals.count(startSymbol)) {
+      fail("Error: Start symbol '" + startSymbol + "' is not in the set of non-terminals.\n");
+    }
+  }
+
+  // Send error messages somewhere else (nullptr to only keep them in getError())
+  void setErrorStream(std::ostream* out) {
+    errOut = out;
+  }
+
+  // Record the parse tree into out as "(Decl (datatype int) x (L) ;)",
+  // set before the first feed(). nullptr turns recording off
+  void setTreeOutput(std::string* out) {
+    treeOut = out;
+    if (treeOut) treeOut->clear();
+  }
+
+  // Call a's shift / reduce while parsing, set before the first feed(). nullptr = none
+  void setActions(ParseActions* a) {
+    actions = a;
+  }
+
+  // Feed one token, expands non-terminals until the token is matched.
+  // returns false on a syntax error (the parser then ignores further tokens)
+  bool feed(const Token& token) {
+    if (failed) return false;
+    if (accepted) {
+      std::ostringstream msg;
+      msg << "Syntax Error: Input remaining after end-of-input marker '$' at token "
+          << tokenCount << " (Lexeme: '" << token.lexeme << "').\n";
+      return fail(msg.str());
+    }
+
+    const std::string symbol = (token.type == "EOF") ? "$" : tokenToParserSymbol(token);
+
+    while (!parseStack.empty()) {
+      const std::string& stackTop = parseStack.top();
+      METRIC_ONLY(stats.steps++; stats.depth(parseStack.size());)
+
+      if ((treeOut || actions) && stackTop == treeClose()) {
+        if (treeOut) *treeOut += ')';
+        parseStack.pop();
+        if (actions) {
+          const std::string* nt = open.back();
+          open.pop_back();
+          actions->reduce(*nt);
+        }
+        continue;
+      }
+
+      if (terminals.count(stackTop) || stackTop == "$") {
+        if (stackTop != symbol) {
+          std::ostringstream msg;
+          msg << "Syntax Error: Mismatch at token " << tokenCount << ". Expected terminal '" << stackTop
+              << "' but found token '" << symbol
+              << "' (Lexeme: '" << token.lexeme << "').\n";
+          return fail(msg.str());
+        }
+        if (treeOut && symbol != "$") {
+          if (!treeOut->empty()) *treeOut += ' ';
+          *treeOut += token.lexeme;
+        }
+        parseStack.pop();
+        tokenCount++;
+        if (actions && symbol != "$") actions->shift(token);
+        if (symbol == "$") {
+          accepted = true;
+          METRIC_ONLY(stats.publish();)
+        }
+        return true;
+      }
+
+      if (!nonTerminals.count(stackTop)) {
+        return fail("Internal Error: Symbol '" + stackTop +
+                    "' on stack is neither a known terminal nor a non-terminal.\n");
+      }
+
+      auto row = table.find(stackTop);
+      if (row == table.end() || !row->second.count(symbol)) {
+        std::ostringstream msg;
+        msg << "Syntax Error: No production rule found for Non-Terminal '" << stackTop
+            << "' with lookahead token symbol '" << symbol
+            << "' at token " << tokenCount << " (Lexeme: '" << token.lexeme << "').\n";
+        return fail(msg.str());
+      }
+
+      const std::vector<std::string>& production = row->second.at(symbol);
+      if (treeOut) {
+        if (!treeOut->empty()) *treeOut += ' ';
+        *treeOut += '(' + stackTop;
+      }
+      if (actions) open.push_back(&row->first);
+      parseStack.pop();
+      METRIC_ONLY(stats.expansions++;)
+      if (treeOut || actions) parseStack.push(treeClose());
+      if (!(production.size() == 1 && production[0] == "epsilon")) {
+        for (int i = production.size() - 1; i >= 0; --i) {
+          parseStack.push(production[i]);
+        }
+      }
+    }
+
+    return fail("Syntax Error: Parse stack empty before end of input.\n");
+  }
+
+  // End of input, feeds the EOF token if the caller did not. true if accepted
+  bool finish() {
+    if (!failed && !accepted) feed(Token("EOF", "$"));
+    return accepted && !failed;
+  }
+
+  bool hasFailed() const { return failed; }
+  bool isAccepted() const { return accepted; }
+  size_t tokensConsumed() const { return tokenCount; }
+  size_t stackDepth() const { return parseStack.size(); }
+  const std::string& getError() const { return error; }
+};
+
+#endif // LL1_PUSH_PARSER_H
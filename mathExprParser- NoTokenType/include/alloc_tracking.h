@@ -0,0 +1,188 @@
+#ifndef ALLOC_TRACKING_H
+#define ALLOC_TRACKING_H
+
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <sstream>
+#include <cstdint>
+#include <optional>
+
+// Allocator hooks: Lexer::tokenize(mr), LL1PushParser and ParseTableGenerator
+// take a std::pmr::memory_resource. what to pass:
+//   ParseArena                              monotonic arena, rewound per parse
+//   std::pmr::unsynchronized_pool_resource  one per worker thread
+//   TrackingResource                        counts what goes through it, per phase
+//
+// short strings (token types, symbols, lexemes up to 15 chars) live inside the
+// std::string itself, so a steady state parse with an arena never hits the heap.
+// careful with moves: assigning a pmr container to one on another resource
+// copies every element into the target's resource.
+
+// Wraps an upstream resource and counts allocations / bytes, in total and per phase
+class TrackingResource : public std::pmr::memory_resource {
+public:
+  struct Stats {
+    uint64_t allocs = 0;
+    uint64_t frees = 0;
+    uint64_t bytes = 0;      // allocated in total
+    uint64_t peakLive = 0;   // most bytes allocated at once
+  };
+
+  explicit TrackingResource(std::pmr::memory_resource* up = std::pmr::get_default_resource())
+    : upstream(up) {}
+
+  Stats totals() const {
+    Stats s;
+    s.allocs = allocs.load();
+    s.frees = frees.load();
+    s.bytes = bytes.load();
+    s.peakLive = peakLive.load();
+    return s;
+  }
+
+  uint64_t liveBytes() const { return live.load(); }
+
+  // phase name -> what was allocated while it ran (see Phase)
+  std::map<std::string, Stats> phases() const {
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    return phaseStats;
+  }
+
+  // make the phase's entry now, so not even its first scope allocates
+  void addPhase(const std::string& name) {
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    phaseStats[name];
+  }
+
+  // Counts everything allocated through this resource until the end of the
+  // scope into the named phase. phases may repeat (they add up), not nest
+  class Phase {
+  public:
+    // the entry is made by the first scope of a name (or addPhase), not looked up again
+    Phase(TrackingResource& r, const std::string& name) : res(r), start(r.totals()) {
+      std::lock_guard<std::mutex> lock(res.phaseMutex);
+      stats = &res.phaseStats[name];
+      res.phasePeak.store(res.live.load()); // peak of this phase starts at what is live now
+    }
+
+    ~Phase() {
+      Stats now = res.totals();
+      std::lock_guard<std::mutex> lock(res.phaseMutex);
+      stats->allocs += now.allocs - start.allocs;
+      stats->frees += now.frees - start.frees;
+      stats->bytes += now.bytes - start.bytes;
+      uint64_t peak = res.phasePeak.load();
+      if (peak > stats->peakLive) stats->peakLive = peak;
+    }
+
+  private:
+    TrackingResource& res;
+    Stats start;
+    Stats* stats; // map nodes don't move
+  };
+
+  // one line per phase, then the totals
+  std::string report() const {
+    std::ostringstream out;
+    auto line = [&](const std::string& name, const Stats& s) {
+      out << name << ": " << s.allocs << " allocs, " << s.frees << " frees, "
+          << s.bytes << " bytes, peak " << s.peakLive << " bytes live\n";
+    };
+    for (const auto& p : phases()) line(p.first, p.second);
+    line("total", totals());
+    return out.str();
+  }
+
+  std::string toJson() const {
+    std::ostringstream out;
+    auto obj = [&](const Stats& s) {
+      out << "{\"allocs\": " << s.allocs << ", \"frees\": " << s.frees << ", \"bytes\": " << s.bytes
+          << ", \"peak_live_bytes\": " << s.peakLive << "}";
+    };
+    out << "{\"phases\": {";
+    const char* sep = "";
+    for (const auto& p : phases()) {
+      out << sep << "\"" << p.first << "\": ";
+      obj(p.second);
+      sep = ", ";
+    }
+    out << "}, \"total\": ";
+    obj(totals());
+    out << "}";
+    return out.str();
+  }
+
+protected:
+  void* do_allocate(size_t n, size_t align) override {
+    void* p = upstream->allocate(n, align);
+    allocs.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(n, std::memory_order_relaxed);
+    uint64_t now = live.fetch_add(n, std::memory_order_relaxed) + n;
+    raise(peakLive, now);
+    raise(phasePeak, now);
+    return p;
+  }
+
+  void do_deallocate(void* p, size_t n, size_t align) override {
+    upstream->deallocate(p, n, align);
+    frees.fetch_add(1, std::memory_order_relaxed);
+    live.fetch_sub(n, std::memory_order_relaxed);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+
+private:
+  std::pmr::memory_resource* upstream;
+  std::atomic<uint64_t> allocs{0}, frees{0}, bytes{0}, live{0}, peakLive{0};
+  std::atomic<uint64_t> phasePeak{0}; // peak live bytes since the current Phase started
+  mutable std::mutex phaseMutex;
+  std::map<std::string, Stats> phaseStats;
+
+  static void raise(std::atomic<uint64_t>& peak, uint64_t v) {
+    uint64_t cur = peak.load(std::memory_order_relaxed);
+    while (v > cur && !peak.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+  }
+};
+
+// Monotonic arena for one parse at a time: allocation is a pointer bump,
+// rewind() frees everything at once. the first block is kept between parses
+// and grows at a rewind when the parse before needed more, so after the
+// biggest input has been seen a parse allocates nothing from upstream.
+class ParseArena {
+public:
+  explicit ParseArena(size_t initialBytes = 64 << 10,
+                      std::pmr::memory_resource* up = std::pmr::get_default_resource())
+    : spill(up), buffer(initialBytes) {
+    arena.emplace(buffer.data(), buffer.size(), &spill);
+  }
+
+  std::pmr::memory_resource* resource() { return &*arena; }
+
+  size_t capacity() const { return buffer.size(); }
+
+  // Drop everything allocated since the last rewind. containers using the
+  // arena must be gone (or never touched again) before this
+  void rewind() {
+    arena->release();
+    uint64_t spilled = spill.totals().bytes - spilledBefore;
+    if (spilled == 0) return;
+    spilledBefore += spilled;
+    arena.reset();
+    buffer.assign(buffer.size() + spilled, 0);
+    arena.emplace(buffer.data(), buffer.size(), &spill);
+  }
+
+private:
+  TrackingResource spill;      // what went past the first block
+  uint64_t spilledBefore = 0;
+  std::vector<char> buffer;
+  std::optional<std::pmr::monotonic_buffer_resource> arena; // remade when the buffer grows
+};
+
+#endif // ALLOC_TRACKING_H
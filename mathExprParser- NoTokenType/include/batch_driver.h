@@ -0,0 +1,192 @@
+#ifndef BATCH_DRIVER_H
+#define BATCH_DRIVER_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <filesystem>
+#include <stdexcept>
+#include <algorithm>
+#include <cstring>
+#include "lexer.h"
+#include "LL1_push_parser.h"
+#include "work_stealing_pool.h"
+#include "file_reader.h"
+
+// Batch mode: one grammar (loaded + table generated once), many inputs.
+// an input is a file, every file under a directory, or one line of stdin.
+
+struct BatchInput {
+  std::string name; // path, or "stdin:<line>" for records
+  std::string path; // empty for stdin records
+  std::string text; // stdin records only, files are read by the workers
+};
+
+struct BatchResult {
+  bool ok = false;
+  size_t bytes = 0;
+  size_t tokens = 0;
+  std::string error;
+};
+
+// Expand the command line inputs, "-" = read stdin records (one per line)
+std::vector<BatchInput> collectBatchInputs(const std::vector<std::string>& args) {
+  namespace fs = std::filesystem;
+  std::vector<BatchInput> inputs;
+  for (const auto& arg : args) {
+    if (arg == "-") {
+      std::string line;
+      size_t n = 0;
+      while (std::getline(std::cin, line)) {
+        n++;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        inputs.push_back({"stdin:" + std::to_string(n), "", line});
+      }
+      continue;
+    }
+    std::error_code ec;
+    if (fs::is_directory(arg, ec)) {
+      std::vector<std::string> files;
+      for (auto it = fs::recursive_directory_iterator(arg, ec); !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (it->is_regular_file(ec)) files.push_back(it->path().string());
+      }
+      std::sort(files.begin(), files.end()); // stable order between runs
+      for (auto& f : files) inputs.push_back({f, f, ""});
+    } else {
+      inputs.push_back({arg, arg, ""}); // missing files are reported per input
+    }
+  }
+  return inputs;
+}
+
+class BatchDriver {
+private:
+  const ParseTable& table;
+  const std::set<std::string>& terminals;
+  const std::set<std::string>& nonTerminals;
+  std::string startSymbol;
+
+  void processOne(const BatchInput& in, size_t index, const std::string& dumpDir,
+                  Lexer& lexer, LL1PushParser& parser, std::string& buf, BatchResult& r) const {
+    if (in.path.empty()) {
+      parseText(in.text, index, dumpDir, lexer, parser, r);
+      return;
+    }
+    int err = readWholeFile(in.path, buf);
+    if (err) {
+      r.error = "Could not read input file: " + in.path + " (" + std::strerror(err) + ")";
+      return;
+    }
+    parseText(buf, index, dumpDir, lexer, parser, r);
+  }
+
+  void parseText(const std::string& text, size_t index, const std::string& dumpDir,
+                 Lexer& lexer, LL1PushParser& parser, BatchResult& r) const {
+    r.bytes = text.size();
+
+    std::ofstream dump;
+    if (!dumpDir.empty()) dump.open(dumpDir + "/" + std::to_string(index) + ".tokens.txt");
+
+    parser.reset();
+    lexer.reset(text);
+    try {
+      Token token;
+      while (lexer.next(token)) {
+        r.tokens++;
+        if (dump) dump << token.type << "\t\t'" << token.lexeme << "'\n";
+        if (!parser.feed(token)) break;
+      }
+    } catch (const std::exception& e) {
+      r.error = std::string("Lexer Error: ") + e.what();
+      return;
+    }
+    if (dump) dump << "EOF\t\t'$'\n";
+    r.ok = parser.finish();
+    if (!r.ok) {
+      r.error = parser.getError();
+      if (!r.error.empty() && r.error.back() == '\n') r.error.pop_back();
+    }
+  }
+
+public:
+  BatchDriver(const ParseTable& parseTable,
+              const std::set<std::string>& terms,
+              const std::set<std::string>& nonTerms,
+              const std::string& startSym)
+    : table(parseTable), terminals(terms), nonTerminals(nonTerms), startSymbol(startSym) {}
+
+  // Lex + parse every input on the pool, results in input order.
+  // dumpDir (optional) gets <index>.tokens.txt per input, same format as Outputs/tokens.txt
+  std::vector<BatchResult> run(const std::vector<BatchInput>& inputs, WorkStealingPool& pool,
+                               const std::string& dumpDir = "", size_t batchSize = 64) const {
+    std::vector<BatchResult> results(inputs.size());
+    size_t tasks = (inputs.size() + batchSize - 1) / batchSize;
+    pool.parallelFor(tasks, [&](size_t t) {
+      // one lexer / parser / read buffer per task, reused for its inputs
+      std::pmr::unsynchronized_pool_resource taskHeap; // parse stack storage, no locking
+      Lexer lexer("");
+      LL1PushParser parser(table, terminals, nonTerminals, startSymbol, &taskHeap);
+      parser.setErrorStream(nullptr);
+      std::string buf;
+      size_t last = std::min(inputs.size(), (t + 1) * batchSize);
+      for (size_t i = t * batchSize; i < last; ++i) {
+        processOne(inputs[i], i, dumpDir, lexer, parser, buf, results[i]);
+      }
+    });
+    return results;
+  }
+
+  // Same results as run(), but the files are read by one io_uring (or pread,
+  // or std::ifstream) reader while the pool's threads lex + parse what has
+  // already arrived.
+  // used (optional) gets the read mode actually used
+  std::vector<BatchResult> runOverlapped(const std::vector<BatchInput>& inputs, WorkStealingPool& pool,
+                                         const std::string& dumpDir = "", ReadMode mode = ReadMode::AUTO,
+                                         ReadMode* used = nullptr) const {
+    std::vector<BatchResult> results(inputs.size());
+    std::vector<std::string> paths;
+    std::vector<size_t> pathInput; // paths[i] belongs to inputs[pathInput[i]]
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (inputs[i].path.empty()) continue;
+      paths.push_back(inputs[i].path);
+      pathInput.push_back(i);
+    }
+
+    FileQueue queue(4 * pool.size() + 64);
+    std::thread reader([&]() {
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        if (!inputs[i].path.empty()) continue;
+        std::string text = inputs[i].text; // stdin records go through the queue too
+        queue.push(i, text, 0);
+      }
+      ReadMode m = readFiles(paths, [&](size_t index, std::string& data, int err) {
+        queue.push(pathInput[index], data, err);
+      }, mode, std::max<size_t>(2, pool.size()));
+      if (used) *used = m;
+      queue.close();
+    });
+
+    pool.parallelFor(pool.size(), [&](size_t) {
+      std::pmr::unsynchronized_pool_resource workerHeap;
+      Lexer lexer("");
+      LL1PushParser parser(table, terminals, nonTerminals, startSymbol, &workerHeap);
+      parser.setErrorStream(nullptr);
+      FileQueue::Item item;
+      while (queue.pop(item)) {
+        BatchResult& r = results[item.index];
+        if (item.err) {
+          r.error = "Could not read input file: " + inputs[item.index].path + " (" + std::strerror(item.err) + ")";
+          continue;
+        }
+        parseText(item.data, item.index, dumpDir, lexer, parser, r);
+      }
+    });
+    reader.join();
+    return results;
+  }
+};
+
+#endif // BATCH_DRIVER_H
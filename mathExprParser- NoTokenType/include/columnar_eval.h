@@ -0,0 +1,162 @@
+#ifndef COLUMNAR_EVAL_H
+#define COLUMNAR_EVAL_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdexcept>
+#include <algorithm>
+#include "expr_vm.h"
+#include "work_stealing_pool.h"
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Evaluates one compiled expression over columns of values (one column per
+// variable) instead of one row at a time. the bytecode is run once per block
+// of rows and every instruction becomes a tight loop over the block:
+//   load_var   -> pointer into the column, no copy
+//   load_const -> pointer to a block filled with the constant (filled once)
+//   add/sub/.. -> SIMD kernel writing into a scratch block
+// the scratch blocks are reused for every block (and kept per thread).
+
+const size_t EVAL_BLOCK = 1024; // rows per block
+
+struct AddOp {
+  static double scalar(double a, double b) { return a + b; }
+#if defined(__AVX__)
+  static __m256d vec(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+#elif defined(__SSE2__)
+  static __m128d vec(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+#endif
+};
+
+struct SubOp {
+  static double scalar(double a, double b) { return a - b; }
+#if defined(__AVX__)
+  static __m256d vec(__m256d a, __m256d b) { return _mm256_sub_pd(a, b); }
+#elif defined(__SSE2__)
+  static __m128d vec(__m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+#endif
+};
+
+struct MulOp {
+  static double scalar(double a, double b) { return a * b; }
+#if defined(__AVX__)
+  static __m256d vec(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+#elif defined(__SSE2__)
+  static __m128d vec(__m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+#endif
+};
+
+struct DivOp {
+  static double scalar(double a, double b) { return a / b; }
+#if defined(__AVX__)
+  static __m256d vec(__m256d a, __m256d b) { return _mm256_div_pd(a, b); }
+#elif defined(__SSE2__)
+  static __m128d vec(__m128d a, __m128d b) { return _mm_div_pd(a, b); }
+#endif
+};
+
+// out[i] = a[i] op b[i], out may alias a or b
+template <typename Op>
+void blockKernel(double* out, const double* a, const double* b, size_t n) {
+  size_t i = 0;
+#if defined(__AVX__)
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(out + i, Op::vec(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+  }
+#elif defined(__SSE2__)
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(out + i, Op::vec(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+  }
+#endif
+  for (; i < n; ++i) out[i] = Op::scalar(a[i], b[i]);
+}
+
+class ColumnarEvaluator {
+private:
+  const Bytecode& bc;
+  std::vector<double> constBlocks; // one EVAL_BLOCK sized block per constant
+
+  // run the bytecode over rows [begin, begin + n), n <= EVAL_BLOCK
+  void evalBlock(const std::vector<const double*>& columns, size_t begin, size_t n,
+                 double* out, std::vector<double>& scratch, std::vector<const double*>& stack) const {
+    size_t sp = 0;
+    for (const Instr& in : bc.code) {
+      switch (in.op) {
+        case OpCode::LOAD_VAR:
+          stack[sp++] = columns[in.arg] + begin;
+          break;
+        case OpCode::LOAD_CONST:
+          stack[sp++] = &constBlocks[in.arg * EVAL_BLOCK];
+          break;
+        case OpCode::RET:
+          std::copy(stack[sp - 1], stack[sp - 1] + n, out);
+          return;
+        default: {
+          // result of the op at depth d goes to scratch block d
+          double* dst = &scratch[(sp - 2) * EVAL_BLOCK];
+          const double* a = stack[sp - 2];
+          const double* b = stack[sp - 1];
+          switch (in.op) {
+            case OpCode::ADD: blockKernel<AddOp>(dst, a, b, n); break;
+            case OpCode::SUB: blockKernel<SubOp>(dst, a, b, n); break;
+            case OpCode::MUL: blockKernel<MulOp>(dst, a, b, n); break;
+            case OpCode::DIV: blockKernel<DivOp>(dst, a, b, n); break;
+            default: throw std::runtime_error("Unknown opcode");
+          }
+          sp--;
+          stack[sp - 1] = dst;
+          break;
+        }
+      }
+    }
+  }
+
+public:
+  explicit ColumnarEvaluator(const Bytecode& code) : bc(code), constBlocks(code.constants.size() * EVAL_BLOCK) {
+    for (size_t c = 0; c < bc.constants.size(); ++c) {
+      std::fill(constBlocks.begin() + c * EVAL_BLOCK, constBlocks.begin() + (c + 1) * EVAL_BLOCK, bc.constants[c]);
+    }
+  }
+
+  // columns[slot] = first value of that variable's column (bc.variables order)
+  std::vector<const double*> bindColumns(const std::map<std::string, const double*>& byName) const {
+    std::vector<const double*> columns;
+    for (const auto& name : bc.variables) {
+      auto it = byName.find(name);
+      if (it == byName.end()) throw std::runtime_error("No column bound for variable '" + name + "'");
+      columns.push_back(it->second);
+    }
+    return columns;
+  }
+
+  // out[r] = expression over row r, for rows [begin, end), single thread
+  void evaluate(const std::vector<const double*>& columns, size_t begin, size_t end, double* out) const {
+    if (columns.size() < bc.variables.size()) throw std::runtime_error("Missing column bindings");
+    // scratch per thread, grows once and is reused for every later call
+    thread_local std::vector<double> scratch;
+    thread_local std::vector<const double*> stack;
+    if (scratch.size() < bc.maxStack * EVAL_BLOCK) scratch.resize(bc.maxStack * EVAL_BLOCK);
+    if (stack.size() < bc.maxStack + 1) stack.resize(bc.maxStack + 1);
+
+    for (size_t r = begin; r < end; r += EVAL_BLOCK) {
+      size_t n = std::min(EVAL_BLOCK, end - r);
+      evalBlock(columns, r, n, out + r, scratch, stack);
+    }
+  }
+
+  // Same, rows split into chunks of blocks and spread over the pool
+  void evaluate(const std::vector<const double*>& columns, size_t rows, double* out,
+                WorkStealingPool& pool, size_t blocksPerTask = 64) const {
+    size_t chunk = EVAL_BLOCK * blocksPerTask;
+    size_t tasks = (rows + chunk - 1) / chunk;
+    pool.parallelFor(tasks, [&](size_t t) {
+      evaluate(columns, t * chunk, std::min(rows, (t + 1) * chunk), out);
+    });
+  }
+};
+
+#endif // COLUMNAR_EVAL_H
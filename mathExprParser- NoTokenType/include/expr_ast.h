@@ -0,0 +1,161 @@
+#ifndef EXPR_AST_H
+#define EXPR_AST_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdexcept>
+#include "lexer.h"
+
+// Expression tree for the math grammar:
+//   Exp -> Term Expr        Expr  -> + Term Expr | - Term Expr | e
+//   Term -> Factor Termp    Termp -> * Factor Termp | / Factor Termp | e
+//   Factor -> ( Exp ) | id | num
+// nodes live in one flat vector and point at their children by index,
+// variables are numbered (slots) when the tree is built.
+
+enum class ExprKind {
+  NUM, VAR, ADD, SUB, MUL, DIV
+};
+
+struct ExprNode {
+  ExprKind kind;
+  double value; // NUM
+  int slot;     // VAR, index into ExprTree::variables
+  int lhs;      // children (binary ops), -1 if none
+  int rhs;
+};
+
+struct ExprTree {
+  std::vector<ExprNode> nodes;
+  std::vector<std::string> variables; // slot -> name
+  int root = -1;
+
+  int addNode(ExprKind kind, double value, int slot, int lhs, int rhs) {
+    nodes.push_back({kind, value, slot, lhs, rhs});
+    return (int)nodes.size() - 1;
+  }
+
+  int slotOf(const std::string& name) const {
+    for (size_t i = 0; i < variables.size(); ++i) {
+      if (variables[i] == name) return (int)i;
+    }
+    return -1;
+  }
+};
+
+// Builds an ExprTree from the lexer tokens, the Expr / Termp tails are
+// handled as loops so '+' and '*' chains come out left associative.
+class ExprBuilder {
+private:
+  const std::vector<Token>& tokens;
+  size_t current;
+  ExprTree tree;
+  std::map<std::string, int> slots;
+
+  const Token& peek() const {
+    return tokens[current];
+  }
+
+  void expect(const std::string& type) {
+    if (peek().type != type) {
+      throw std::runtime_error("Expected " + type + " but got " + peek().type +
+                               " ('" + peek().lexeme + "') at token " + std::to_string(current));
+    }
+    current++;
+  }
+
+  // Exp -> Term Expr
+  int parseExp() {
+    int lhs = parseTerm();
+    while (peek().type == "PLUS" || peek().type == "MINUS") {
+      ExprKind kind = (peek().type == "PLUS") ? ExprKind::ADD : ExprKind::SUB;
+      current++;
+      int rhs = parseTerm();
+      lhs = tree.addNode(kind, 0, -1, lhs, rhs);
+    }
+    return lhs;
+  }
+
+  // Term -> Factor Termp
+  int parseTerm() {
+    int lhs = parseFactor();
+    while (peek().type == "TIMES" || peek().type == "DIVIDE") {
+      ExprKind kind = (peek().type == "TIMES") ? ExprKind::MUL : ExprKind::DIV;
+      current++;
+      int rhs = parseFactor();
+      lhs = tree.addNode(kind, 0, -1, lhs, rhs);
+    }
+    return lhs;
+  }
+
+  // Factor -> ( Exp ) | id | num
+  int parseFactor() {
+    const Token& tok = peek();
+    if (tok.type == "LPAREN") {
+      current++;
+      int inner = parseExp();
+      expect("RPAREN");
+      return inner;
+    }
+    if (tok.type == "ID") {
+      auto it = slots.find(tok.lexeme);
+      int slot;
+      if (it == slots.end()) {
+        slot = (int)tree.variables.size();
+        tree.variables.push_back(tok.lexeme);
+        slots[tok.lexeme] = slot;
+      } else {
+        slot = it->second;
+      }
+      current++;
+      return tree.addNode(ExprKind::VAR, 0, slot, -1, -1);
+    }
+    if (tok.type == "NUMBER") {
+      current++;
+      return tree.addNode(ExprKind::NUM, tok.number.asDouble(), -1, -1, -1);
+    }
+    throw std::runtime_error("Expected ID, NUMBER, or '(' but got '" + tok.lexeme +
+                             "' at token " + std::to_string(current));
+  }
+
+public:
+  // tokens must end with the EOF token (as Lexer::tokenize() returns them)
+  ExprBuilder(const std::vector<Token>& t) : tokens(t), current(0) {}
+
+  ExprTree build() {
+    if (tokens.empty() || tokens.back().type != "EOF") {
+      throw std::runtime_error("Token list must end with EOF");
+    }
+    tree.root = parseExp();
+    expect("EOF");
+    return tree;
+  }
+};
+
+// Convenience: source text -> tree
+ExprTree parseExpression(const std::string& text) {
+  Lexer lexer(text);
+  std::vector<Token> tokens = lexer.tokenize();
+  return ExprBuilder(tokens).build();
+}
+
+// Plain recursive tree walk, the reference the faster evaluators are checked against
+double evalTree(const ExprTree& tree, int node, const double* vars) {
+  const ExprNode& n = tree.nodes[node];
+  switch (n.kind) {
+    case ExprKind::NUM: return n.value;
+    case ExprKind::VAR: return vars[n.slot];
+    case ExprKind::ADD: return evalTree(tree, n.lhs, vars) + evalTree(tree, n.rhs, vars);
+    case ExprKind::SUB: return evalTree(tree, n.lhs, vars) - evalTree(tree, n.rhs, vars);
+    case ExprKind::MUL: return evalTree(tree, n.lhs, vars) * evalTree(tree, n.rhs, vars);
+    case ExprKind::DIV: return evalTree(tree, n.lhs, vars) / evalTree(tree, n.rhs, vars);
+  }
+  return 0;
+}
+
+double evalTree(const ExprTree& tree, const double* vars) {
+  return evalTree(tree, tree.root, vars);
+}
+
+#endif // EXPR_AST_H
@@ -0,0 +1,184 @@
+#ifndef EXPR_CACHE_H
+#define EXPR_CACHE_H
+
+#include <cstdint>
+#include <cctype>
+#include <string>
+#include <list>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include "expr_ast.h"
+#include "expr_vm.h"
+#include "expr_optimize.h"
+
+// Cache of compiled expressions keyed by their normalized text, so an
+// expression string that was seen before skips lexing, parsing and compiling.
+// the cache is split into shards (own mutex + LRU list each) picked by the
+// key hash, so threads looking up different expressions rarely share a lock.
+
+struct CompiledExpr {
+  ExprTree tree;      // optimized tree / DAG
+  Bytecode bytecode;
+};
+
+struct ExprCacheStats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  size_t size;
+};
+
+// Whitespace normalization: runs of whitespace become one space, and spaces
+// next to operators / delimiters are dropped ("a  +b" and "a + b" -> "a+b").
+// spaces between two words are kept, "a b" must not turn into "ab", and so
+// are the ones that would make an exponent: "2e + 5" is 2 e + 5, a syntax
+// error, but "2e+5" is 200000.
+std::string normalizeExpression(const std::string& text) {
+  auto isWord = [](char c) { return isalnum((unsigned char)c) || c == '_' || c == '.'; };
+  auto isNumChar = [](char c) { return isdigit((unsigned char)c) || c == '.'; };
+  // out ends with a number's "e" (then the sign is next) or "e+" / "e-" (then its digits)
+  auto exponentAt = [&](const std::string& s, char next) {
+    size_t n = s.size();
+    if ((next == '+' || next == '-') && n >= 2) {
+      return (s[n - 1] == 'e' || s[n - 1] == 'E') && isNumChar(s[n - 2]);
+    }
+    if (isdigit((unsigned char)next) && n >= 3 && (s[n - 1] == '+' || s[n - 1] == '-')) {
+      return (s[n - 2] == 'e' || s[n - 2] == 'E') && isNumChar(s[n - 3]);
+    }
+    return false;
+  };
+  std::string out;
+  out.reserve(text.size());
+  bool pendingSpace = false;
+  for (char c : text) {
+    if (isspace((unsigned char)c)) {
+      pendingSpace = !out.empty();
+      continue;
+    }
+    if (pendingSpace && ((isWord(c) && isWord(out.back())) || exponentAt(out, c))) out += ' ';
+    pendingSpace = false;
+    out += c;
+  }
+  return out;
+}
+
+// FNV-1a, 64 bit
+uint64_t hashExpression(const std::string& normalized) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (unsigned char c : normalized) {
+    h ^= c;
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+class ExprCache {
+private:
+  struct Entry {
+    uint64_t hash;
+    std::string text; // normalized, to rule out hash collisions
+    std::shared_ptr<const CompiledExpr> compiled;
+  };
+
+  struct Shard {
+    std::mutex m;
+    std::list<Entry> lru; // front = most recently used
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+  };
+
+  std::vector<std::unique_ptr<Shard>> shards;
+  size_t shardCapacity;
+  std::atomic<uint64_t> hits;
+  std::atomic<uint64_t> misses;
+  std::atomic<uint64_t> evictions;
+
+  Shard& shardFor(uint64_t hash) {
+    return *shards[(hash >> 48) % shards.size()];
+  }
+
+public:
+  ExprCache(size_t capacity = 4096, size_t shardCount = 16)
+    : hits(0), misses(0), evictions(0)
+  {
+    if (shardCount == 0) shardCount = 1;
+    shardCapacity = (capacity + shardCount - 1) / shardCount;
+    if (shardCapacity == 0) shardCapacity = 1;
+    for (size_t i = 0; i < shardCount; ++i) shards.emplace_back(new Shard());
+  }
+
+  // Lex + parse + optimize + compile, what a cache miss costs
+  static std::shared_ptr<const CompiledExpr> compile(const std::string& text) {
+    std::shared_ptr<CompiledExpr> c = std::make_shared<CompiledExpr>();
+    c->tree = optimizeExpr(parseExpression(text));
+    c->bytecode = compileExpr(c->tree);
+    return c;
+  }
+
+  // Compiled form of text, compiled on a miss. throws on syntax errors
+  // (failures are not cached). the result stays valid after eviction.
+  std::shared_ptr<const CompiledExpr> get(const std::string& text) {
+    std::string key = normalizeExpression(text);
+    uint64_t hash = hashExpression(key);
+    Shard& shard = shardFor(hash);
+
+    {
+      std::lock_guard<std::mutex> lock(shard.m);
+      auto it = shard.index.find(hash);
+      if (it != shard.index.end() && it->second->text == key) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return it->second->compiled;
+      }
+    }
+
+    // compile without holding the lock, two threads may race on the same
+    // new expression, the second insert just replaces the first. the text as
+    // given is compiled, the key is only for finding it again
+    misses.fetch_add(1, std::memory_order_relaxed);
+    std::shared_ptr<const CompiledExpr> compiled = compile(text);
+
+    std::lock_guard<std::mutex> lock(shard.m);
+    auto it = shard.index.find(hash);
+    if (it != shard.index.end()) {
+      // same hash: a racing insert of this text, or a collision, keep the newest
+      it->second->text = key;
+      it->second->compiled = compiled;
+      shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+      return compiled;
+    }
+    shard.lru.push_front({hash, key, compiled});
+    shard.index[hash] = shard.lru.begin();
+    if (shard.lru.size() > shardCapacity) {
+      shard.index.erase(shard.lru.back().hash);
+      shard.lru.pop_back();
+      evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+    return compiled;
+  }
+
+  void clear() {
+    for (auto& s : shards) {
+      std::lock_guard<std::mutex> lock(s->m);
+      s->lru.clear();
+      s->index.clear();
+    }
+  }
+
+  ExprCacheStats getStats() {
+    ExprCacheStats st;
+    st.hits = hits.load();
+    st.misses = misses.load();
+    st.evictions = evictions.load();
+    st.size = 0;
+    for (auto& s : shards) {
+      std::lock_guard<std::mutex> lock(s->m);
+      st.size += s->lru.size();
+    }
+    return st;
+  }
+};
+
+#endif // EXPR_CACHE_H
@@ -0,0 +1,427 @@
+#ifndef EXPR_JIT_H
+#define EXPR_JIT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <initializer_list>
+#include <stdexcept>
+#include "expr_ast.h"
+
+// Native code for one expression tree, Linux x86-64 only (EXPR_JIT_AVAILABLE
+// is 0 elsewhere and there is no ExprJit).
+//
+// two functions are emitted into an mmap'd buffer (written, then made
+// read + exec):
+//   row:     double f(const double* vars)                      scalar SSE2 (addsd ..)
+//   columns: void f(const double* const* cols, size_t n, double* out)
+//            two rows per iteration with packed SSE2 (addpd ..), n even
+// SysV calling convention: arguments in rdi / rsi / rdx, result in xmm0,
+// everything used (rax, rcx, xmm0-15) is caller saved, so no saves.
+//
+// the tree is linearized with the operand needing more registers first
+// (Sethi-Ullman), each value gets a live interval from its definition to
+// its one use, and a linear scan gives the intervals xmm0-xmm14, spilling
+// the one that ends last to a stack slot when they run out (xmm15 is the
+// scratch register for spilled values). constants sit in a pool after the
+// code, addressed rip relative. every operation is the same IEEE double
+// operation on the same operands as evalTree / ExprVM, so results match
+// them bit for bit.
+
+#if defined(__x86_64__) && defined(__linux__)
+#define EXPR_JIT_AVAILABLE 1
+#include <sys/mman.h>
+#include <unistd.h>
+
+class ExprJit {
+public:
+  using RowFn = double (*)(const double* vars);
+  using ColumnsFn = void (*)(const double* const* columns, size_t rows, double* out);
+
+  // registers: how many xmm registers the allocator may use (1..15),
+  // fewer only to exercise spilling
+  explicit ExprJit(const ExprTree& tree, int registers = 15) {
+    if (tree.root < 0) throw std::runtime_error("Cannot compile an empty expression tree");
+    if (registers < 1 || registers > 15) throw std::runtime_error("JIT: registers must be 1..15");
+    nvars = tree.variables.size();
+
+    std::vector<uint8_t> code;
+    std::vector<Fixup> fixups;
+    Emitter e{code, fixups, tree};
+
+    for (int packed = 0; packed < 2; ++packed) {
+      Plan plan(tree, packed == 1, registers);
+      spillCount = std::max(spillCount, plan.spilled);
+      size_t entry = code.size();
+      if (packed) e.columnsFunction(plan);
+      else e.rowFunction(plan);
+      (packed ? columnsAt : rowAt) = entry;
+    }
+
+    // constant pool: 16 bytes per NUM node (the value twice, for the packed loads)
+    while (code.size() % 16) code.push_back(0xCC);
+    size_t pool = code.size();
+    std::vector<size_t> entry(tree.nodes.size());
+    for (size_t i = 0; i < tree.nodes.size(); ++i) {
+      if (tree.nodes[i].kind != ExprKind::NUM) continue;
+      entry[i] = code.size();
+      uint8_t bytes[8];
+      std::memcpy(bytes, &tree.nodes[i].value, 8);
+      for (int twice = 0; twice < 2; ++twice) code.insert(code.end(), bytes, bytes + 8);
+    }
+    for (const Fixup& f : fixups) {
+      int32_t rel = (int32_t)(entry[f.node] - (f.at + 4));
+      std::memcpy(&code[f.at], &rel, 4);
+    }
+
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size = (code.size() + page - 1) / page * page;
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) throw std::runtime_error("JIT: mmap failed");
+    std::memcpy(mem, code.data(), code.size());
+    if (mprotect(mem, size, PROT_READ | PROT_EXEC) != 0) {
+      munmap(mem, size);
+      throw std::runtime_error("JIT: mprotect failed");
+    }
+    buffer = (uint8_t*)mem;
+    codeSize = pool;
+  }
+
+  ~ExprJit() {
+    if (buffer) munmap(buffer, size);
+  }
+
+  ExprJit(const ExprJit&) = delete;
+  ExprJit& operator=(const ExprJit&) = delete;
+  ExprJit(ExprJit&& o) noexcept { *this = std::move(o); }
+  ExprJit& operator=(ExprJit&& o) noexcept {
+    std::swap(buffer, o.buffer);
+    std::swap(size, o.size);
+    codeSize = o.codeSize;
+    rowAt = o.rowAt;
+    columnsAt = o.columnsAt;
+    nvars = o.nvars;
+    spillCount = o.spillCount;
+    return *this;
+  }
+
+  RowFn row() const { return (RowFn)(buffer + rowAt); }
+  double operator()(const double* vars) const { return row()(vars); }
+
+  // out[i] = value on row i, columns[slot] is the variable's column
+  void evalColumns(const double* const* columns, size_t rows, double* out) const {
+    size_t even = rows & ~size_t(1);
+    if (even) ((ColumnsFn)(buffer + columnsAt))(columns, even, out);
+    if (rows & 1) {
+      std::vector<double> vars(nvars);
+      for (size_t v = 0; v < nvars; ++v) vars[v] = columns[v][even];
+      out[even] = row()(vars.data());
+    }
+  }
+
+  size_t codeBytes() const { return codeSize; } // both functions, without the constants
+  int spills() const { return spillCount; }     // values kept on the stack (the worse function)
+
+private:
+  uint8_t* buffer = nullptr;
+  size_t size = 0, codeSize = 0;
+  size_t rowAt = 0, columnsAt = 0;
+  size_t nvars = 0;
+  int spillCount = 0;
+
+  static constexpr int SCRATCH = 15;
+
+  // where a value lives
+  struct Loc {
+    bool inRegister = true;
+    int index = 0; // xmm register or stack slot
+  };
+
+  // one linear instruction: dst = a op b, or dst = leaf
+  struct Step {
+    ExprKind kind;
+    int leaf = -1;    // NUM / VAR node loaded into dst
+    int a = -1, b = -1; // operand values
+    int bLeaf = -1;   // or a leaf node used straight from memory as b (scalar only)
+  };
+
+  // linear code + register allocation for one function
+  struct Plan {
+    const ExprTree& tree;
+    bool packed;
+    std::vector<Step> steps;   // value i is defined by steps[i]
+    std::vector<int> lastUse;  // step reading value i (steps.size() for the result)
+    std::vector<Loc> loc;
+    int stackSlots = 0;
+    int spilled = 0;
+
+    Plan(const ExprTree& t, bool p, int registers) : tree(t), packed(p) {
+      std::vector<int> need(tree.nodes.size(), 0);
+      registersNeeded(tree.root, need);
+      int result = linearize(tree.root, need);
+      lastUse.resize(steps.size(), -1);
+      for (int i = 0; i < (int)steps.size(); ++i) {
+        if (steps[i].a >= 0) lastUse[steps[i].a] = i;
+        if (steps[i].b >= 0) lastUse[steps[i].b] = i;
+      }
+      lastUse[result] = (int)steps.size();
+      allocate(registers);
+    }
+
+    static bool isLeaf(const ExprNode& n) { return n.kind == ExprKind::NUM || n.kind == ExprKind::VAR; }
+
+    // a leaf used as b stays in memory in the scalar function (addsd xmm, [mem]).
+    // packed loads from columns need a register, and 16 byte alignment we don't have
+    bool memoryOperand(int node) const { return !packed && isLeaf(tree.nodes[node]); }
+
+    int registersNeeded(int node, std::vector<int>& need) {
+      const ExprNode& n = tree.nodes[node];
+      if (isLeaf(n)) return need[node] = 1;
+      int l = registersNeeded(n.lhs, need);
+      int r = memoryOperand(n.rhs) ? 0 : registersNeeded(n.rhs, need);
+      return need[node] = l == r ? l + 1 : std::max(l, r);
+    }
+
+    int linearize(int node, const std::vector<int>& need) {
+      const ExprNode& n = tree.nodes[node];
+      Step s;
+      s.kind = n.kind;
+      if (isLeaf(n)) {
+        s.leaf = node;
+      } else if (memoryOperand(n.rhs)) {
+        s.a = linearize(n.lhs, need);
+        s.bLeaf = n.rhs;
+      } else if (need[n.rhs] > need[n.lhs]) {
+        s.b = linearize(n.rhs, need);
+        s.a = linearize(n.lhs, need);
+      } else {
+        s.a = linearize(n.lhs, need);
+        s.b = linearize(n.rhs, need);
+      }
+      steps.push_back(s);
+      return (int)steps.size() - 1;
+    }
+
+    // linear scan: value i's interval is [i, lastUse[i]], they start in order.
+    // the operands' registers are free again at the step that reads them, so a
+    // result takes over its left operand's register when it can
+    void allocate(int registers) {
+      loc.resize(steps.size());
+      std::vector<int> active; // values in registers, by end
+      std::vector<char> freeReg(registers, 1);
+      std::vector<int> freeSlots;
+      auto release = [&](int v) {
+        if (v < 0) return;
+        if (loc[v].inRegister) {
+          freeReg[loc[v].index] = 1;
+          active.erase(std::find(active.begin(), active.end(), v));
+        } else {
+          freeSlots.push_back(loc[v].index);
+        }
+      };
+      for (int i = 0; i < (int)steps.size(); ++i) {
+        release(steps[i].a);
+        release(steps[i].b);
+        int reg = -1;
+        if (steps[i].a >= 0 && loc[steps[i].a].inRegister && freeReg[loc[steps[i].a].index]) {
+          reg = loc[steps[i].a].index;
+        }
+        for (int r = 0; reg < 0 && r < registers; ++r) {
+          if (freeReg[r]) reg = r;
+        }
+        if (reg < 0) { // spill whichever ends last, this one or an active one
+          int victim = i;
+          for (int v : active) {
+            if (lastUse[v] > lastUse[victim]) victim = v;
+          }
+          if (victim != i) {
+            reg = loc[victim].index;
+            active.erase(std::find(active.begin(), active.end(), victim));
+            loc[victim] = Loc{false, slot(freeSlots)};
+            spilled++;
+          } else {
+            loc[i] = Loc{false, slot(freeSlots)};
+            spilled++;
+            continue;
+          }
+        }
+        freeReg[reg] = 0;
+        loc[i] = Loc{true, reg};
+        active.push_back(i);
+      }
+    }
+
+    int slot(std::vector<int>& freeSlots) {
+      if (freeSlots.empty()) return stackSlots++;
+      int s = freeSlots.back();
+      freeSlots.pop_back();
+      return s;
+    }
+
+    // bytes below rsp for the slots, keeping rsp 16 byte aligned (it is 8 off at entry)
+    int32_t frameBytes() const { return stackSlots ? 16 * stackSlots + 8 : 0; }
+  };
+
+  struct Fixup {
+    size_t at; // rel32 to patch
+    int node;  // NUM node whose pool entry it points at
+  };
+
+  // x86-64 encoding, just what the two functions need
+  struct Emitter {
+    std::vector<uint8_t>& code;
+    std::vector<Fixup>& fixups;
+    const ExprTree& tree;
+
+    enum class Mode { XMM, STACK, VAR, CONST, COLUMN }; // COLUMN = [rax + rcx*8]
+    struct Operand {
+      Mode mode;
+      int index; // register, stack slot, variable slot or NUM node
+    };
+
+    void byte(uint8_t b) { code.push_back(b); }
+    void bytes(std::initializer_list<uint8_t> bs) { code.insert(code.end(), bs); }
+    void imm32(int32_t v) {
+      uint8_t b[4];
+      std::memcpy(b, &v, 4);
+      code.insert(code.end(), b, b + 4);
+    }
+
+    // prefix [rex] 0F op modrm..., reg = xmm register in ModRM.reg
+    void sse(uint8_t prefix, uint8_t op, int reg, Operand m) {
+      byte(prefix);
+      uint8_t rex = 0x40 | (reg & 8 ? 4 : 0) | (m.mode == Mode::XMM && (m.index & 8) ? 1 : 0);
+      if (rex != 0x40) byte(rex);
+      byte(0x0F);
+      byte(op);
+      uint8_t r = (reg & 7) << 3;
+      switch (m.mode) {
+        case Mode::XMM:
+          byte(0xC0 | r | (m.index & 7));
+          break;
+        case Mode::STACK: // [rsp + 16 * slot]
+          byte(0x84 | r);
+          byte(0x24);
+          imm32(16 * m.index);
+          break;
+        case Mode::VAR:   // [rdi + 8 * slot]
+          byte(0x87 | r);
+          imm32(8 * m.index);
+          break;
+        case Mode::CONST: // [rip + pool entry]
+          byte(0x05 | r);
+          fixups.push_back(Fixup{code.size(), m.index});
+          imm32(0);
+          break;
+        case Mode::COLUMN:
+          byte(0x04 | r);
+          byte(0xC8);
+          break;
+      }
+    }
+
+    static uint8_t opcode(ExprKind k) {
+      switch (k) {
+        case ExprKind::ADD: return 0x58;
+        case ExprKind::SUB: return 0x5C;
+        case ExprKind::MUL: return 0x59;
+        default: return 0x5E; // DIV
+      }
+    }
+
+    // scalar: F2 (sd), packed: 66 (pd). loads: movsd / movapd (aligned: stack, pool)
+    // or movupd (columns), stores movsd / movapd, register copies movapd
+    void arith(bool packed, ExprKind k, int reg, Operand m) { sse(packed ? 0x66 : 0xF2, opcode(k), reg, m); }
+    void load(bool packed, int reg, Operand m) {
+      if (!packed) sse(0xF2, 0x10, reg, m);
+      else sse(0x66, m.mode == Mode::COLUMN ? 0x10 : 0x28, reg, m);
+    }
+    void store(bool packed, Operand m, int reg) { sse(packed ? 0x66 : 0xF2, packed ? 0x29 : 0x11, reg, m); }
+    void copy(int dst, int src) {
+      if (dst != src) sse(0x66, 0x28, dst, Operand{Mode::XMM, src});
+    }
+
+    Operand at(const Loc& l) const { return Operand{l.inRegister ? Mode::XMM : Mode::STACK, l.index}; }
+
+    // leaf as an operand, for packed VAR this loads the column pointer into rax first
+    Operand leaf(int node, bool packed) {
+      const ExprNode& n = tree.nodes[node];
+      if (n.kind == ExprKind::NUM) return Operand{Mode::CONST, node};
+      if (!packed) return Operand{Mode::VAR, n.slot};
+      bytes({0x48, 0x8B, 0x87}); // mov rax, [rdi + 8 * slot]
+      imm32(8 * n.slot);
+      return Operand{Mode::COLUMN, 0};
+    }
+
+    void body(const Plan& p) {
+      for (size_t i = 0; i < p.steps.size(); ++i) {
+        const Step& s = p.steps[i];
+        const Loc& d = p.loc[i];
+        int work = d.inRegister ? d.index : SCRATCH;
+        if (s.leaf >= 0) {
+          load(p.packed, work, leaf(s.leaf, p.packed));
+        } else {
+          const Loc& a = p.loc[s.a];
+          bool bInWork = s.b >= 0 && p.loc[s.b].inRegister && p.loc[s.b].index == work;
+          if (bInWork) work = SCRATCH; // loading a would overwrite b
+          if (a.inRegister) copy(work, a.index);
+          else load(p.packed, work, at(a));
+          arith(p.packed, s.kind, work, s.bLeaf >= 0 ? leaf(s.bLeaf, p.packed) : at(p.loc[s.b]));
+        }
+        if (!d.inRegister) store(p.packed, Operand{Mode::STACK, d.index}, work);
+        else copy(d.index, work);
+      }
+    }
+
+    // result of the last step into xmm0
+    void result(const Plan& p) {
+      const Loc& r = p.loc.back();
+      if (r.inRegister) copy(0, r.index);
+      else load(p.packed, 0, at(r));
+    }
+
+    void frame(int32_t bytes, bool enter) {
+      if (!bytes) return;
+      code.insert(code.end(), {0x48, 0x81, (uint8_t)(enter ? 0xEC : 0xC4)}); // sub / add rsp, imm32
+      imm32(bytes);
+    }
+
+    void rowFunction(const Plan& p) {
+      frame(p.frameBytes(), true);
+      body(p);
+      result(p);
+      frame(p.frameBytes(), false);
+      byte(0xC3); // ret
+    }
+
+    // rdi = columns, rsi = rows (even), rdx = out, rcx = row
+    void columnsFunction(const Plan& p) {
+      frame(p.frameBytes(), true);
+      bytes({0x31, 0xC9});       // xor ecx, ecx
+      bytes({0x48, 0x85, 0xF6}); // test rsi, rsi
+      bytes({0x0F, 0x84});       // jz done
+      size_t skip = code.size();
+      imm32(0);
+      size_t loop = code.size();
+      body(p);
+      result(p);
+      bytes({0x66, 0x0F, 0x11, 0x04, 0xCA}); // movupd [rdx + rcx*8], xmm0
+      bytes({0x48, 0x83, 0xC1, 0x02});       // add rcx, 2
+      bytes({0x48, 0x39, 0xF1});             // cmp rcx, rsi
+      bytes({0x0F, 0x82});                   // jb loop
+      imm32((int32_t)(loop - (code.size() + 4)));
+      int32_t done = (int32_t)(code.size() - (skip + 4));
+      std::memcpy(&code[skip], &done, 4);
+      frame(p.frameBytes(), false);
+      byte(0xC3);
+    }
+  };
+};
+
+#else
+#define EXPR_JIT_AVAILABLE 0
+#endif
+
+#endif // EXPR_JIT_H
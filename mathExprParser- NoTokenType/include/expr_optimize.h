@@ -0,0 +1,187 @@
+#ifndef EXPR_OPTIMIZE_H
+#define EXPR_OPTIMIZE_H
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+#include "expr_ast.h"
+
+// Optimization pass over an ExprTree:
+//  - constant folding      2 * 3 + a   -> 6 + a
+//  - identities            x*1, 1*x, x/1, x+0, 0+x, x-0 -> x   and  x-x -> 0
+//  - hash consing (CSE)    identical subtrees become one node, so the
+//                          result is a DAG: (a+b)*(a+b) has a single a+b
+// the builder adds children before parents, so walking nodes in index order
+// is already a bottom-up walk; the output keeps that property.
+
+struct OptimizeStats {
+  size_t nodesBefore = 0;
+  size_t nodesAfter = 0;
+  size_t folded = 0;      // constant sub-expressions computed
+  size_t identities = 0;  // x*1 style rewrites
+  size_t shared = 0;      // nodes merged with an existing identical one
+};
+
+class ExprOptimizer {
+private:
+  struct NodeKey {
+    int kind;
+    uint64_t bits; // value for NUM, slot for VAR
+    int lhs, rhs;
+    bool operator==(const NodeKey& o) const {
+      return kind == o.kind && bits == o.bits && lhs == o.lhs && rhs == o.rhs;
+    }
+  };
+
+  struct NodeKeyHash {
+    size_t operator()(const NodeKey& k) const {
+      uint64_t h = k.bits * 0x9E3779B97F4A7C15ull;
+      h ^= ((uint64_t)(uint32_t)k.lhs << 32 | (uint32_t)k.rhs) + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2);
+      h ^= (uint64_t)k.kind * 0xC2B2AE3D27D4EB4Full;
+      return (size_t)(h ^ (h >> 29));
+    }
+  };
+
+  ExprTree out;
+  std::unordered_map<NodeKey, int, NodeKeyHash> unique;
+  OptimizeStats stats;
+
+  // add a node, or return the existing identical one
+  int intern(ExprKind kind, double value, int slot, int lhs, int rhs) {
+    NodeKey key{(int)kind, 0, lhs, rhs};
+    if (kind == ExprKind::NUM) std::memcpy(&key.bits, &value, sizeof(value));
+    if (kind == ExprKind::VAR) key.bits = (uint64_t)slot;
+    auto it = unique.find(key);
+    if (it != unique.end()) {
+      stats.shared++;
+      return it->second;
+    }
+    int id = out.addNode(kind, value, slot, lhs, rhs);
+    unique.emplace(key, id);
+    return id;
+  }
+
+  bool isConst(int id, double v) const {
+    return out.nodes[id].kind == ExprKind::NUM && out.nodes[id].value == v;
+  }
+
+  int rewriteBinary(ExprKind kind, int l, int r) {
+    const ExprNode& a = out.nodes[l];
+    const ExprNode& b = out.nodes[r];
+
+    if (a.kind == ExprKind::NUM && b.kind == ExprKind::NUM) {
+      double v = 0;
+      switch (kind) {
+        case ExprKind::ADD: v = a.value + b.value; break;
+        case ExprKind::SUB: v = a.value - b.value; break;
+        case ExprKind::MUL: v = a.value * b.value; break;
+        case ExprKind::DIV: v = a.value / b.value; break;
+        default: break;
+      }
+      stats.folded++;
+      return intern(ExprKind::NUM, v, -1, -1, -1);
+    }
+
+    switch (kind) {
+      case ExprKind::ADD:
+        if (isConst(r, 0)) { stats.identities++; return l; }
+        if (isConst(l, 0)) { stats.identities++; return r; }
+        break;
+      case ExprKind::SUB:
+        if (isConst(r, 0)) { stats.identities++; return l; }
+        if (l == r) { stats.identities++; return intern(ExprKind::NUM, 0, -1, -1, -1); } // same DAG node
+        break;
+      case ExprKind::MUL:
+        if (isConst(r, 1)) { stats.identities++; return l; }
+        if (isConst(l, 1)) { stats.identities++; return r; }
+        break;
+      case ExprKind::DIV:
+        if (isConst(r, 1)) { stats.identities++; return l; }
+        break;
+      default:
+        break;
+    }
+    return intern(kind, 0, -1, l, r);
+  }
+
+  // drop nodes the root no longer reaches (children of folded nodes etc.)
+  ExprTree compact(const ExprTree& t) const {
+    std::vector<char> live(t.nodes.size(), 0);
+    live[t.root] = 1;
+    for (int i = t.root; i >= 0; --i) {
+      if (!live[i] || t.nodes[i].lhs < 0) continue;
+      live[t.nodes[i].lhs] = 1;
+      live[t.nodes[i].rhs] = 1;
+    }
+    ExprTree res;
+    res.variables = t.variables;
+    std::vector<int> remap(t.nodes.size(), -1);
+    for (size_t i = 0; i < t.nodes.size(); ++i) {
+      if (!live[i]) continue;
+      ExprNode n = t.nodes[i];
+      if (n.lhs >= 0) {
+        n.lhs = remap[n.lhs];
+        n.rhs = remap[n.rhs];
+      }
+      remap[i] = res.addNode(n.kind, n.value, n.slot, n.lhs, n.rhs);
+    }
+    res.root = remap[t.root];
+    return res;
+  }
+
+public:
+  ExprTree optimize(const ExprTree& in) {
+    out = ExprTree();
+    out.variables = in.variables;
+    unique.clear();
+    stats = OptimizeStats();
+    stats.nodesBefore = in.nodes.size();
+
+    std::vector<int> remap(in.nodes.size(), -1);
+    for (size_t i = 0; i < in.nodes.size(); ++i) {
+      const ExprNode& n = in.nodes[i];
+      if (n.kind == ExprKind::NUM || n.kind == ExprKind::VAR) {
+        remap[i] = intern(n.kind, n.value, n.slot, -1, -1);
+      } else {
+        remap[i] = rewriteBinary(n.kind, remap[n.lhs], remap[n.rhs]);
+      }
+    }
+    out.root = remap[in.root];
+
+    ExprTree result = compact(out);
+    stats.nodesAfter = result.nodes.size();
+    return result;
+  }
+
+  const OptimizeStats& getStats() const {
+    return stats;
+  }
+};
+
+ExprTree optimizeExpr(const ExprTree& tree, OptimizeStats* stats = nullptr) {
+  ExprOptimizer opt;
+  ExprTree result = opt.optimize(tree);
+  if (stats) *stats = opt.getStats();
+  return result;
+}
+
+// Evaluate a tree or DAG computing every node exactly once, in index order
+// (children always come before parents). values is scratch, sized by the call.
+double evalDag(const ExprTree& tree, const double* vars, std::vector<double>& values) {
+  values.resize(tree.nodes.size());
+  for (size_t i = 0; i < tree.nodes.size(); ++i) {
+    const ExprNode& n = tree.nodes[i];
+    switch (n.kind) {
+      case ExprKind::NUM: values[i] = n.value; break;
+      case ExprKind::VAR: values[i] = vars[n.slot]; break;
+      case ExprKind::ADD: values[i] = values[n.lhs] + values[n.rhs]; break;
+      case ExprKind::SUB: values[i] = values[n.lhs] - values[n.rhs]; break;
+      case ExprKind::MUL: values[i] = values[n.lhs] * values[n.rhs]; break;
+      case ExprKind::DIV: values[i] = values[n.lhs] / values[n.rhs]; break;
+    }
+  }
+  return values[tree.root];
+}
+
+#endif // EXPR_OPTIMIZE_H
@@ -0,0 +1,168 @@
+#ifndef EXPR_VM_H
+#define EXPR_VM_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "expr_ast.h"
+
+// Bytecode for one compiled expression + a small stack VM to run it.
+// variables are resolved to slot numbers at compile time, so running it
+// is just an array of doubles in (one per slot) and a double out.
+
+enum class OpCode : uint8_t {
+  LOAD_VAR,   // push vars[arg]
+  LOAD_CONST, // push constants[arg]
+  ADD, SUB, MUL, DIV,
+  RET         // result = top of stack
+};
+
+struct Instr {
+  OpCode op;
+  uint32_t arg;
+};
+
+struct Bytecode {
+  std::vector<Instr> code;
+  std::vector<double> constants;
+  std::vector<std::string> variables; // slot -> name, same order as the tree
+  size_t maxStack = 0;
+};
+
+class ExprCompiler {
+private:
+  const ExprTree& tree;
+  Bytecode out;
+  size_t depth;
+
+  void emit(OpCode op, uint32_t arg = 0) {
+    out.code.push_back({op, arg});
+  }
+
+  void push() {
+    if (++depth > out.maxStack) out.maxStack = depth;
+  }
+
+  // post order: operands first, then the operator
+  void compileNode(int node) {
+    const ExprNode& n = tree.nodes[node];
+    switch (n.kind) {
+      case ExprKind::NUM:
+        emit(OpCode::LOAD_CONST, (uint32_t)out.constants.size());
+        out.constants.push_back(n.value);
+        push();
+        return;
+      case ExprKind::VAR:
+        emit(OpCode::LOAD_VAR, (uint32_t)n.slot);
+        push();
+        return;
+      default:
+        break;
+    }
+    compileNode(n.lhs);
+    compileNode(n.rhs);
+    switch (n.kind) {
+      case ExprKind::ADD: emit(OpCode::ADD); break;
+      case ExprKind::SUB: emit(OpCode::SUB); break;
+      case ExprKind::MUL: emit(OpCode::MUL); break;
+      case ExprKind::DIV: emit(OpCode::DIV); break;
+      default: throw std::runtime_error("Unknown expression node");
+    }
+    depth--;
+  }
+
+public:
+  ExprCompiler(const ExprTree& t) : tree(t), depth(0) {}
+
+  Bytecode compile() {
+    if (tree.root < 0) throw std::runtime_error("Cannot compile an empty expression tree");
+    out = Bytecode();
+    out.variables = tree.variables;
+    depth = 0;
+    compileNode(tree.root);
+    emit(OpCode::RET);
+    return out;
+  }
+};
+
+Bytecode compileExpr(const ExprTree& tree) {
+  return ExprCompiler(tree).compile();
+}
+
+// Stack VM. the top of stack lives in a local (acc) so binary ops only
+// touch memory for the left operand. on gcc/clang dispatch is a computed
+// goto per instruction, other compilers get a plain switch loop.
+class ExprVM {
+private:
+  std::vector<double> stack;
+
+public:
+  explicit ExprVM(const Bytecode& bc) : stack(bc.maxStack + 1) {}
+
+  double run(const Bytecode& bc, const double* vars) {
+    const Instr* ip = bc.code.data();
+    const double* consts = bc.constants.data();
+    double* sp = stack.data(); // next free slot below acc
+    double acc = 0;
+
+#if defined(__GNUC__)
+    static void* dispatch[] = { &&op_load_var, &&op_load_const, &&op_add, &&op_sub,
+                                &&op_mul, &&op_div, &&op_ret };
+#define VM_NEXT() goto *dispatch[(int)(ip++)->op]
+    VM_NEXT();
+  op_load_var:
+    *sp++ = acc;
+    acc = vars[ip[-1].arg];
+    VM_NEXT();
+  op_load_const:
+    *sp++ = acc;
+    acc = consts[ip[-1].arg];
+    VM_NEXT();
+  op_add:
+    acc = *--sp + acc;
+    VM_NEXT();
+  op_sub:
+    acc = *--sp - acc;
+    VM_NEXT();
+  op_mul:
+    acc = *--sp * acc;
+    VM_NEXT();
+  op_div:
+    acc = *--sp / acc;
+    VM_NEXT();
+  op_ret:
+    return acc;
+#undef VM_NEXT
+#else
+    while (true) {
+      const Instr& in = *ip++;
+      switch (in.op) {
+        case OpCode::LOAD_VAR:   *sp++ = acc; acc = vars[in.arg]; break;
+        case OpCode::LOAD_CONST: *sp++ = acc; acc = consts[in.arg]; break;
+        case OpCode::ADD: acc = *--sp + acc; break;
+        case OpCode::SUB: acc = *--sp - acc; break;
+        case OpCode::MUL: acc = *--sp * acc; break;
+        case OpCode::DIV: acc = *--sp / acc; break;
+        case OpCode::RET: return acc;
+      }
+    }
+#endif
+  }
+};
+
+// Readable listing, one instruction per line
+std::string disassemble(const Bytecode& bc) {
+  static const char* names[] = { "load_var", "load_const", "add", "sub", "mul", "div", "ret" };
+  std::string s;
+  for (size_t i = 0; i < bc.code.size(); ++i) {
+    const Instr& in = bc.code[i];
+    s += std::to_string(i) + "\t" + names[(int)in.op];
+    if (in.op == OpCode::LOAD_VAR) s += "\t" + std::to_string(in.arg) + " (" + bc.variables[in.arg] + ")";
+    if (in.op == OpCode::LOAD_CONST) s += "\t" + std::to_string(in.arg) + " (" + std::to_string(bc.constants[in.arg]) + ")";
+    s += "\n";
+  }
+  return s;
+}
+
+#endif // EXPR_VM_H
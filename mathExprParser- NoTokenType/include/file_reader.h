@@ -0,0 +1,474 @@
+#ifndef FILE_READER_H
+#define FILE_READER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#define PARSER_HAVE_PREAD 1
+#endif
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define PARSER_HAVE_IO_URING 1
+#endif
+
+// Reading many small input files without one std::ifstream per file.
+//
+// UringFileReader submits the openat / read / close of up to queueDepth files
+// at once through io_uring (raw syscalls, no liburing, Linux only),
+// PreadFileReader does open / fstat / pread / close on a few threads (POSIX)
+// and StreamFileReader does the same with std::ifstream (everywhere else).
+// all of them call
+//   onFile(index, data, err)     err = 0 or the errno of the failed step
+// as each file completes, in completion order, so the caller can start lexing
+// one file while the others are still being read.
+
+using FileCallback = std::function<void(size_t index, std::string& data, int err)>;
+
+// hands out paths to threadCount threads (this one included), each reading
+// with readFile into a buffer it reuses
+inline void readOnThreads(const std::vector<std::string>& paths, const FileCallback& onFile, size_t threadCount,
+                          int (*readFile)(const std::string&, std::string&)) {
+  std::atomic<size_t> next(0);
+  auto work = [&]() {
+    std::string buf;
+    for (size_t i; (i = next.fetch_add(1)) < paths.size();) {
+      int err = readFile(paths[i], buf);
+      onFile(i, buf, err);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < threadCount; ++t) threads.emplace_back(work);
+  work();
+  for (auto& t : threads) t.join();
+}
+
+// ---- thread pool + std::ifstream ----
+
+class StreamFileReader {
+private:
+  size_t threadCount;
+
+public:
+  explicit StreamFileReader(size_t threads = 4) : threadCount(threads ? threads : 1) {}
+
+  // reads the whole file into out, returns 0 or an errno (EIO if the
+  // library didn't set one)
+  static int readFile(const std::string& path, std::string& out) {
+    errno = 0;
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+      out.clear();
+      return errno ? errno : EIO;
+    }
+    file.seekg(0, std::ios::end);
+    std::streamoff size = file.tellg();
+    file.seekg(0, std::ios::beg);
+    out.resize(size > 0 ? (size_t)size : 4096);
+    size_t got = 0;
+    while (file) {
+      if (got == out.size()) out.resize(out.size() * 2); // file grew, or no size from tellg
+      file.read(&out[got], out.size() - got);
+      got += (size_t)file.gcount();
+    }
+    out.resize(got);
+    return file.bad() ? (errno ? errno : EIO) : 0;
+  }
+
+  void readAll(const std::vector<std::string>& paths, const FileCallback& onFile) const {
+    readOnThreads(paths, onFile, threadCount, readFile);
+  }
+};
+
+#ifdef PARSER_HAVE_PREAD
+// ---- thread pool + pread ----
+
+class PreadFileReader {
+private:
+  size_t threadCount;
+
+public:
+  explicit PreadFileReader(size_t threads = 4) : threadCount(threads ? threads : 1) {}
+
+  // reads the whole file into out, returns 0 or an errno
+  static int readFile(const std::string& path, std::string& out) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return errno;
+    struct stat st;
+    size_t size = (::fstat(fd, &st) == 0 && st.st_size > 0) ? st.st_size : 0;
+    out.resize(size ? size : 4096);
+    size_t got = 0;
+    int err = 0;
+    while (true) {
+      if (got == out.size()) out.resize(out.size() * 2); // file grew, or no size from fstat
+      ssize_t n = ::pread(fd, &out[got], out.size() - got, got);
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0) { err = errno; break; }
+      if (n == 0) break;
+      got += n;
+      if (size && got == size) break; // saves the extra read that returns 0
+    }
+    ::close(fd);
+    out.resize(got);
+    return err;
+  }
+
+  void readAll(const std::vector<std::string>& paths, const FileCallback& onFile) const {
+    readOnThreads(paths, onFile, threadCount, readFile);
+  }
+};
+#endif // PARSER_HAVE_PREAD
+
+// whole file with the fastest single-file read the platform has
+inline int readWholeFile(const std::string& path, std::string& out) {
+#ifdef PARSER_HAVE_PREAD
+  return PreadFileReader::readFile(path, out);
+#else
+  return StreamFileReader::readFile(path, out);
+#endif
+}
+
+// ---- io_uring ----
+
+class UringFileReader {
+public:
+  explicit UringFileReader(unsigned depth = 256, size_t firstReadSize = 16 << 10)
+    : queueDepth(depth ? depth : 1), readSize(firstReadSize ? firstReadSize : 4096) {}
+
+#ifdef PARSER_HAVE_IO_URING
+  ~UringFileReader() {
+    closeRing();
+  }
+
+  // true if the kernel lets us set up a ring and knows openat / read / close
+  static bool available() {
+    static const bool ok = []() {
+      io_uring_params p{};
+      int fd = (int)syscall(__NR_io_uring_setup, 4, &p);
+      if (fd < 0) return false;
+      size_t size = sizeof(io_uring_probe) + IORING_OP_LAST * sizeof(io_uring_probe_op);
+      std::vector<char> mem(size, 0);
+      io_uring_probe* probe = (io_uring_probe*)mem.data();
+      bool supported = syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) == 0;
+      for (int op : {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_CLOSE}) {
+        supported = supported && op <= probe->last_op && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+      }
+      ::close(fd);
+      return supported;
+    }();
+    return ok;
+  }
+
+  // false if the ring could not be set up (nothing was read then). if the
+  // ring fails later, the files not finished yet are read with pread, so
+  // every file still gets exactly one onFile
+  bool readAll(const std::vector<std::string>& paths, const FileCallback& onFile) {
+    if (ringFd < 0 && !openRing()) return false;
+
+    std::vector<Slot> slots(std::min<size_t>(queueDepth, paths.size()));
+    std::vector<unsigned> freeSlots;
+    for (unsigned i = 0; i < slots.size(); ++i) freeSlots.push_back((unsigned)slots.size() - 1 - i);
+    size_t nextFile = 0, done = 0;
+    unsigned inFlight = 0, toSubmit = 0;
+
+    auto finish = [&](unsigned s, int err) {
+      Slot& slot = slots[s];
+      if (slot.fd >= 0) {
+        io_uring_sqe* sqe = getSqe(toSubmit);
+        sqe->opcode = IORING_OP_CLOSE;
+        sqe->fd = slot.fd;
+        sqe->user_data = CLOSE_TAG;
+        inFlight++;
+        slot.fd = -1;
+      }
+      slot.buf.resize(err ? 0 : slot.got);
+      slot.busy = false;
+      onFile(slot.index, slot.buf, err);
+      done++;
+      freeSlots.push_back(s);
+    };
+
+    while (done < paths.size()) {
+      // every free slot opens the next file (one slot can need 2 sqes: close + read)
+      while (!freeSlots.empty() && nextFile < paths.size() && inFlight + 2 <= sqEntries) {
+        unsigned s = freeSlots.back();
+        freeSlots.pop_back();
+        Slot& slot = slots[s];
+        slot.index = nextFile;
+        slot.busy = true;
+        slot.fd = -1;
+        slot.got = 0;
+        slot.buf.resize(readSize);
+        io_uring_sqe* sqe = getSqe(toSubmit);
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = (uint64_t)(uintptr_t)paths[nextFile].c_str();
+        sqe->open_flags = O_RDONLY | O_CLOEXEC;
+        sqe->user_data = s;
+        inFlight++;
+        nextFile++;
+      }
+
+      // submit what is queued and wait for at least one completion
+      int n = (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (n < 0 && errno != EINTR) {
+        // let the kernel finish with the slot buffers if it still can (what
+        // was never submitted won't complete), the rest is cancelled with the ring
+        unsigned submitted = inFlight - toSubmit;
+        if (submitted > 0) syscall(__NR_io_uring_enter, ringFd, 0, submitted, IORING_ENTER_GETEVENTS, nullptr, 0);
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for (unsigned head = *cqHead; head != tail; ++head) { // opens that finished still have an fd to close
+          const io_uring_cqe& cqe = cqes[head & *cqMask];
+          if (cqe.user_data != CLOSE_TAG && cqe.res >= 0 && slots[cqe.user_data].fd < 0) {
+            slots[cqe.user_data].fd = cqe.res;
+          }
+        }
+        unsigned sqEnd = *sqTail;
+        for (unsigned i = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE); i != sqEnd; ++i) { // closes never submitted
+          const io_uring_sqe& sqe = sqes[sqArray[i & *sqMask]];
+          if (sqe.opcode == IORING_OP_CLOSE) ::close(sqe.fd);
+        }
+        closeRing();
+        for (Slot& slot : slots) {
+          if (!slot.busy) continue;
+          if (slot.fd >= 0) ::close(slot.fd);
+          std::string data;
+          int err = PreadFileReader::readFile(paths[slot.index], data);
+          onFile(slot.index, data, err);
+        }
+        for (size_t i = nextFile; i < paths.size(); ++i) {
+          std::string data;
+          int err = PreadFileReader::readFile(paths[i], data);
+          onFile(i, data, err);
+        }
+        return true;
+      }
+      if (n > 0) toSubmit -= std::min<unsigned>(toSubmit, (unsigned)n);
+
+      unsigned head = *cqHead;
+      unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+      for (; head != tail; ++head) {
+        io_uring_cqe cqe = cqes[head & *cqMask];
+        inFlight--;
+        if (cqe.user_data == CLOSE_TAG) continue;
+        unsigned s = (unsigned)cqe.user_data;
+        Slot& slot = slots[s];
+        if (cqe.res < 0) {
+          finish(s, -cqe.res);
+          continue;
+        }
+        if (slot.fd < 0) {
+          slot.fd = cqe.res; // openat done
+        } else {
+          slot.got += cqe.res;
+          // a short read (or 0) means end of file, a full buffer means maybe more
+          if (cqe.res == 0 || slot.got < slot.buf.size()) {
+            finish(s, 0);
+            continue;
+          }
+          slot.buf.resize(slot.buf.size() * 2);
+        }
+        io_uring_sqe* sqe = getSqe(toSubmit);
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = slot.fd;
+        sqe->addr = (uint64_t)(uintptr_t)(slot.buf.data() + slot.got);
+        sqe->len = (unsigned)(slot.buf.size() - slot.got);
+        sqe->off = slot.got;
+        sqe->user_data = s;
+        inFlight++;
+      }
+      __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    // reap the last closes
+    while (inFlight > 0) {
+      int n = (int)syscall(__NR_io_uring_enter, ringFd, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+      if (n < 0 && errno != EINTR) break;
+      if (n > 0) toSubmit -= std::min<unsigned>(toSubmit, (unsigned)n);
+      unsigned head = *cqHead;
+      unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+      inFlight -= tail - head;
+      __atomic_store_n(cqHead, tail, __ATOMIC_RELEASE);
+    }
+    return true;
+  }
+
+private:
+  static constexpr uint64_t CLOSE_TAG = ~0ull;
+
+  struct Slot {
+    size_t index = 0;
+    bool busy = false; // between its openat and its onFile
+    int fd = -1;
+    size_t got = 0;
+    std::string buf;
+  };
+
+  int ringFd = -1;
+  unsigned sqEntries = 0;
+  unsigned* sqHead = nullptr;
+  unsigned* sqTail = nullptr;
+  unsigned* sqMask = nullptr;
+  unsigned* sqArray = nullptr;
+  io_uring_sqe* sqes = nullptr;
+  unsigned* cqHead = nullptr;
+  unsigned* cqTail = nullptr;
+  unsigned* cqMask = nullptr;
+  io_uring_cqe* cqes = nullptr;
+  void* sqRing = nullptr;
+  void* cqRing = nullptr;
+  size_t sqRingSize = 0, cqRingSize = 0, sqesSize = 0;
+
+  bool openRing() {
+    io_uring_params p{};
+    ringFd = (int)syscall(__NR_io_uring_setup, queueDepth, &p);
+    if (ringFd < 0) return false;
+    sqEntries = p.sq_entries;
+    sqRingSize = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cqRingSize = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (single) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+    cqRing = single ? sqRing
+                    : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+    sqesSize = p.sq_entries * sizeof(io_uring_sqe);
+    void* sqeMem = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+    if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqeMem == MAP_FAILED) {
+      if (sqRing == MAP_FAILED) sqRing = nullptr;
+      if (cqRing == MAP_FAILED) cqRing = nullptr;
+      if (sqeMem != MAP_FAILED) munmap(sqeMem, sqesSize);
+      closeRing();
+      return false;
+    }
+
+    char* sq = (char*)sqRing;
+    sqHead = (unsigned*)(sq + p.sq_off.head);
+    sqTail = (unsigned*)(sq + p.sq_off.tail);
+    sqMask = (unsigned*)(sq + p.sq_off.ring_mask);
+    sqArray = (unsigned*)(sq + p.sq_off.array);
+    sqes = (io_uring_sqe*)sqeMem;
+    char* cq = (char*)cqRing;
+    cqHead = (unsigned*)(cq + p.cq_off.head);
+    cqTail = (unsigned*)(cq + p.cq_off.tail);
+    cqMask = (unsigned*)(cq + p.cq_off.ring_mask);
+    cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+    return true;
+  }
+
+  void closeRing() {
+    if (sqes) munmap(sqes, sqesSize);
+    if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+    if (sqRing) munmap(sqRing, sqRingSize);
+    if (ringFd >= 0) ::close(ringFd);
+    sqes = nullptr;
+    sqRing = cqRing = nullptr;
+    ringFd = -1;
+  }
+
+  // next free sqe, zeroed. the caller keeps inFlight <= sqEntries so there always is one
+  io_uring_sqe* getSqe(unsigned& toSubmit) {
+    unsigned tail = *sqTail;
+    unsigned idx = tail & *sqMask;
+    io_uring_sqe* sqe = &sqes[idx];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqArray[idx] = idx;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    toSubmit++;
+    return sqe;
+  }
+#else
+  static bool available() { return false; }
+  bool readAll(const std::vector<std::string>&, const FileCallback&) { return false; }
+#endif
+
+private:
+  unsigned queueDepth;
+  size_t readSize;
+};
+
+// ---- handing buffers from the reader to the parsing workers ----
+
+// bounded multi producer / multi consumer queue of finished files.
+// push blocks while full so a fast reader can't buffer the whole directory.
+class FileQueue {
+public:
+  struct Item {
+    size_t index;
+    int err;
+    std::string data;
+  };
+
+  explicit FileQueue(size_t cap = 1024) : capacity(cap ? cap : 1) {}
+
+  void push(size_t index, std::string& data, int err) {
+    std::unique_lock<std::mutex> lock(m);
+    notFull.wait(lock, [&]() { return items.size() < capacity; });
+    items.push_back({index, err, std::string()});
+    items.back().data.swap(data); // the reader gets the old buffer back to reuse
+    notEmpty.notify_one();
+  }
+
+  // false once close() was called and everything was taken
+  bool pop(Item& out) {
+    std::unique_lock<std::mutex> lock(m);
+    notEmpty.wait(lock, [&]() { return !items.empty() || closed; });
+    if (items.empty()) return false;
+    out = std::move(items.front());
+    items.pop_front();
+    notFull.notify_one();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(m);
+    closed = true;
+    notEmpty.notify_all();
+  }
+
+private:
+  size_t capacity;
+  std::mutex m;
+  std::condition_variable notEmpty, notFull;
+  std::deque<Item> items;
+  bool closed = false;
+};
+
+enum class ReadMode { AUTO, URING, PREAD, STREAM };
+
+// Reads paths with the chosen mode, falling back io_uring -> pread ->
+// std::ifstream when the kernel or platform lacks one (AUTO = the first
+// that works). returns the mode actually used
+inline ReadMode readFiles(const std::vector<std::string>& paths, const FileCallback& onFile,
+                          ReadMode mode = ReadMode::AUTO, size_t threads = 4) {
+  if ((mode == ReadMode::AUTO || mode == ReadMode::URING) && UringFileReader::available()) {
+    UringFileReader reader;
+    if (reader.readAll(paths, onFile)) return ReadMode::URING;
+  }
+#ifdef PARSER_HAVE_PREAD
+  if (mode != ReadMode::STREAM) {
+    PreadFileReader(threads).readAll(paths, onFile);
+    return ReadMode::PREAD;
+  }
+#endif
+  StreamFileReader(threads).readAll(paths, onFile);
+  return ReadMode::STREAM;
+}
+
+#endif // FILE_READER_H
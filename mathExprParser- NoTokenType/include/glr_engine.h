@@ -0,0 +1,772 @@
+#ifndef GLR_ENGINE_H
+#define GLR_ENGINE_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <cstdint>
+#include "ll1_engine.h"   // token type policies
+#include "lr_table_gen.h" // LRTable
+#include "metrics.h"
+
+// Shared packed parse forest: one node per (symbol, start, end) and one
+// family per way of deriving it (production + child nodes), so n ambiguous
+// spots cost n extra families, not 2^n trees. tokens are leaf nodes.
+class ParseForest {
+public:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  struct Node {
+    uint32_t symbol;     // terminal column, or terminals + nonterminal index
+    uint32_t start, end; // token positions, end excluded
+    uint32_t family;     // first family, NONE for tokens
+    uint32_t families;   // more than one = ambiguous
+  };
+  struct Family {
+    uint32_t production;
+    uint32_t kids;       // children[kids .. kids + production length)
+    uint32_t next;       // next family of the same node
+    uint32_t node;
+  };
+
+  std::vector<Node> nodes;
+  std::vector<Family> families;
+  std::vector<uint32_t> children;
+  uint32_t root = NONE;
+
+  explicit ParseForest(const LRTable& t) : table(&t) {}
+
+  void clear() {
+    nodes.clear();
+    families.clear();
+    children.clear();
+    if (indexed) std::fill(slots.begin(), slots.end(), NONE);
+    indexed = 0;
+    root = NONE;
+  }
+
+  bool isToken(uint32_t n) const { return nodes[n].symbol < table->terminals.size(); }
+  const std::string& name(uint32_t n) const {
+    uint32_t s = nodes[n].symbol, t = (uint32_t)table->terminals.size();
+    return s < t ? table->terminals[s] : table->nonTerminals[s - t];
+  }
+  uint32_t length(const Family& f) const { return table->productions[f.production].length; }
+
+  uint32_t addNode(uint32_t symbol, uint32_t start, uint32_t end) {
+    nodes.push_back(Node{symbol, start, end, NONE, 0});
+    return (uint32_t)nodes.size() - 1;
+  }
+
+  // adds production + kids as a way to derive node n, false if it already was one
+  bool addFamily(uint32_t n, uint32_t production, const uint32_t* kids, uint32_t len) {
+    Node& node = nodes[n];
+    if (node.families >= hashFrom) {
+      size_t mask = slots.size() - 1;
+      for (size_t h = hash(n, production, kids, len) & mask; slots[h] != NONE; h = (h + 1) & mask) {
+        const Family& f = families[slots[h]];
+        if (f.node == n && same(f, production, kids, len)) return false;
+      }
+    } else {
+      for (uint32_t f = node.family; f != NONE; f = families[f].next) {
+        if (same(families[f], production, kids, len)) return false;
+      }
+    }
+    families.push_back(Family{production, (uint32_t)children.size(), node.family, n});
+    for (uint32_t k = 0; k < len; ++k) children.push_back(kids[k]);
+    node.family = (uint32_t)families.size() - 1;
+    node.families++;
+    if (node.families > hashFrom) {
+      index(node.family);
+    } else if (node.families == hashFrom) { // many ways to derive it: index them
+      for (uint32_t f = node.family; f != NONE; f = families[f].next) index(f);
+    }
+    return true;
+  }
+
+  // nodes reachable from the root with more than one family
+  size_t ambiguousNodes() const {
+    size_t count = 0;
+    forEachReachable([&](uint32_t n) { count += nodes[n].families > 1; });
+    return count;
+  }
+
+  // number of parse trees under n (infinity if the forest has a cycle)
+  double countTrees(uint32_t n) const {
+    std::vector<double> trees(nodes.size(), 0);
+    std::vector<char> state(nodes.size(), 0); // 1 = expanded, 2 = counted
+    std::vector<uint32_t> stack{n};
+    while (!stack.empty()) {
+      uint32_t top = stack.back();
+      if (state[top] == 2) {
+        stack.pop_back();
+        continue;
+      }
+      if (isToken(top)) {
+        trees[top] = 1;
+        state[top] = 2;
+        continue;
+      }
+      if (state[top] == 0) {
+        state[top] = 1;
+        for (uint32_t f = nodes[top].family; f != NONE; f = families[f].next) {
+          for (uint32_t k = 0; k < length(families[f]); ++k) {
+            uint32_t kid = children[families[f].kids + k];
+            if (state[kid] == 1) return INFINITY; // kid is an ancestor: A =>+ A
+            if (state[kid] == 0) stack.push_back(kid);
+          }
+        }
+        continue;
+      }
+      double sum = 0;
+      for (uint32_t f = nodes[top].family; f != NONE; f = families[f].next) {
+        double product = 1;
+        for (uint32_t k = 0; k < length(families[f]); ++k) product *= trees[children[families[f].kids + k]];
+        sum += product;
+      }
+      trees[top] = sum;
+      state[top] = 2;
+      stack.pop_back();
+    }
+    return trees[n];
+  }
+
+  // one tree (each node's newest family) as "(E (E (T (F a))) + (T (F b)))",
+  // leaves[token position] for the tokens if given, else their terminal names
+  std::string tree(uint32_t n, const std::vector<std::string>& leaves = {}) const {
+    std::string out;
+    auto leaf = [&](uint32_t t) { out += leaves.empty() ? name(t) : leaves[nodes[t].start]; };
+    if (n == NONE) return out;
+    if (isToken(n)) {
+      leaf(n);
+      return out;
+    }
+    std::vector<char> onPath(nodes.size(), 0);
+    std::vector<std::pair<uint32_t, uint32_t>> stack{{n, 0}}; // node, next kid
+    out += "(" + name(n);
+    onPath[n] = 1;
+    while (!stack.empty()) {
+      auto& top = stack.back();
+      const Family& f = families[nodes[top.first].family];
+      if (top.second == length(f)) {
+        out += ")";
+        onPath[top.first] = 0;
+        stack.pop_back();
+        continue;
+      }
+      uint32_t kid = children[f.kids + top.second++];
+      out += " ";
+      if (isToken(kid)) {
+        leaf(kid);
+      } else if (onPath[kid]) {
+        out += "(" + name(kid) + " ...)"; // cyclic grammar
+      } else {
+        out += "(" + name(kid);
+        onPath[kid] = 1;
+        stack.push_back({kid, 0});
+      }
+    }
+    return out;
+  }
+
+  // every reachable nonterminal node with its families, one per line
+  std::string dump() const {
+    std::ostringstream out;
+    auto label = [&](uint32_t n) {
+      return name(n) + "[" + std::to_string(nodes[n].start) + "," + std::to_string(nodes[n].end) + "]";
+    };
+    forEachReachable([&](uint32_t n) {
+      if (isToken(n)) return;
+      out << label(n) << (nodes[n].families > 1 ? " (ambiguous)" : "") << "\n";
+      for (uint32_t f = nodes[n].family; f != NONE; f = families[f].next) {
+        out << "  " << table->productionText[families[f].production] << "  ->";
+        for (uint32_t k = 0; k < length(families[f]); ++k) out << " " << label(children[families[f].kids + k]);
+        out << "\n";
+      }
+    });
+    return out.str();
+  }
+
+private:
+  const LRTable* table;
+  static constexpr uint32_t hashFrom = 16; // families per node before they are looked up by hash
+  // families of those nodes, open addressing over family indices
+  std::vector<uint32_t> slots;
+  size_t indexed = 0;
+
+  void index(uint32_t f) {
+    if ((indexed + 1) * 2 > slots.size()) {
+      std::vector<uint32_t> old = std::move(slots);
+      slots.assign(old.empty() ? 1024 : old.size() * 2, NONE);
+      indexed = 0;
+      for (uint32_t g : old) {
+        if (g != NONE) place(g);
+      }
+    }
+    place(f);
+  }
+
+  void place(uint32_t f) {
+    const Family& fam = families[f];
+    size_t mask = slots.size() - 1;
+    size_t h = hash(fam.node, fam.production, &children[fam.kids], length(fam)) & mask;
+    while (slots[h] != NONE) h = (h + 1) & mask;
+    slots[h] = f;
+    indexed++;
+  }
+
+  bool same(const Family& f, uint32_t production, const uint32_t* kids, uint32_t len) const {
+    if (f.production != production) return false;
+    for (uint32_t k = 0; k < len; ++k) {
+      if (children[f.kids + k] != kids[k]) return false;
+    }
+    return true;
+  }
+
+  static uint64_t hash(uint32_t n, uint32_t production, const uint32_t* kids, uint32_t len) {
+    uint64_t h = (uint64_t)n * 0x9E3779B97F4A7C15ull ^ production;
+    for (uint32_t k = 0; k < len; ++k) h = (h ^ kids[k]) * 0x100000001B3ull;
+    return h;
+  }
+
+  template <class F>
+  void forEachReachable(F f) const {
+    if (root == NONE) return;
+    std::vector<char> seen(nodes.size(), 0);
+    std::vector<uint32_t> stack{root};
+    seen[root] = 1;
+    while (!stack.empty()) {
+      uint32_t n = stack.back();
+      stack.pop_back();
+      f(n);
+      for (uint32_t fam = nodes[n].family; fam != NONE; fam = families[fam].next) {
+        for (uint32_t k = 0; k < length(families[fam]); ++k) {
+          uint32_t kid = children[families[fam].kids + k];
+          if (!seen[kid]) {
+            seen[kid] = 1;
+            stack.push_back(kid);
+          }
+        }
+      }
+    }
+  }
+};
+
+// GLR driver over LRTableGenerator's tables, for grammars with conflicts
+// (ambiguous, or needing more than one token of lookahead). where the table
+// has two actions the parse splits: the stacks form a graph (one node per
+// state and position, merged where the branches meet again) and every
+// reduction adds to a shared packed parse forest.
+//
+// where the input is locally deterministic (one stack top whose state has a
+// single action on the lookahead) it runs like LREngine: a plain array of
+// (state, forest node) above one graph node, no graph nodes or work list.
+// that array only becomes graph nodes when a state with a conflict is
+// reached, and the parse goes back to it as soon as one top is left, so
+// conflicts only cost something around the tokens that hit them.
+//
+// epsilon rules: a reduction that adds an edge to a stack top that already
+// had its reductions done runs them again through the new edge (Farshi), so
+// hidden left recursion is handled.
+template <class Policy>
+class GLREngine {
+private:
+  static constexpr uint32_t NONE = UINT32_MAX;
+
+  struct GssNode {
+    int32_t state;
+    uint32_t pos;
+    uint32_t edges;     // first edge
+    uint32_t edgeCount;
+    bool reduced;       // its reductions were done (or queued)
+  };
+  struct GssEdge {
+    uint32_t to;
+    uint32_t label;     // forest node of the symbol between the two
+    uint32_t next;
+  };
+  struct Pending {
+    uint32_t node;
+    uint32_t production;
+    uint32_t via;       // only paths through this edge, NONE = all
+  };
+  struct LinearEntry {
+    int32_t state;
+    uint32_t pos;
+    uint32_t label;     // forest node of the symbol below it
+  };
+
+  const LRTable& table;
+  Policy policy;
+  size_t kinds;
+  std::vector<uint32_t> kindColumn; // kind (+ unknown) -> action column
+  uint32_t endColumn;
+  size_t ntCount;
+  uint32_t terminalCount;
+
+  std::vector<GssNode> gss;
+  std::vector<GssEdge> edges;
+  std::vector<uint32_t> level, nextLevel; // stack tops at the current / next position
+  struct Head {
+    uint32_t node;
+    uint32_t stamp;     // current only if == stamp
+  };
+  // key -> value for one position (open addressing), emptied by a new stamp
+  struct PositionIndex {
+    std::vector<uint64_t> keys;
+    std::vector<uint32_t> values, stamps;
+    size_t count = 0;
+
+    PositionIndex() : keys(64), values(64), stamps(64, 0) {}
+
+    static size_t slot(uint64_t key, size_t mask) { return (size_t)((key * 0x9E3779B97F4A7C15ull) >> 40) & mask; }
+
+    uint32_t find(uint64_t key, uint32_t stamp) const {
+      size_t mask = keys.size() - 1;
+      for (size_t h = slot(key, mask); stamps[h] == stamp; h = (h + 1) & mask) {
+        if (keys[h] == key) return values[h];
+      }
+      return NONE;
+    }
+
+    void insert(uint64_t key, uint32_t value, uint32_t stamp) {
+      if (++count * 2 > keys.size()) grow(stamp);
+      size_t mask = keys.size() - 1, h = slot(key, mask);
+      while (stamps[h] == stamp) h = (h + 1) & mask;
+      keys[h] = key;
+      values[h] = value;
+      stamps[h] = stamp;
+    }
+
+    void grow(uint32_t stamp) {
+      std::vector<uint64_t> oldKeys = std::move(keys);
+      std::vector<uint32_t> oldValues = std::move(values), oldStamps = std::move(stamps);
+      keys.assign(oldKeys.size() * 2, 0);
+      values.assign(oldKeys.size() * 2, 0);
+      stamps.assign(oldKeys.size() * 2, 0);
+      size_t mask = keys.size() - 1;
+      for (size_t i = 0; i < oldKeys.size(); ++i) {
+        if (oldStamps[i] != stamp) continue;
+        size_t h = slot(oldKeys[i], mask);
+        while (stamps[h] == stamp) h = (h + 1) & mask;
+        keys[h] = oldKeys[i];
+        values[h] = oldValues[i];
+        stamps[h] = stamp;
+      }
+    }
+  };
+  std::vector<Head> headAt;                // state -> top at the position being built
+  std::vector<Pending> work;
+  std::vector<LinearEntry> linear; // deterministic stack above graph node base
+  uint32_t base = NONE;
+  bool deterministic = true;
+  std::vector<uint32_t> kids;
+  uint32_t stamp = 0;
+  uint32_t col = 0;        // lookahead column
+  bool hasEmpty = false;   // epsilon rules, stack edges within one position
+
+  // the table's arrays, taken at the start of each parse
+  const int32_t* actions = nullptr;
+  const uint32_t* actionRow = nullptr;
+  size_t stride = 0;
+  const int32_t* defaults = nullptr;
+  const int32_t* gotos = nullptr;
+  const uint32_t* gotoRow = nullptr;
+  const LRTable::Production* prods = nullptr;
+  const uint32_t* extraIndex = nullptr; // nullptr = no conflicts anywhere
+
+  // the current position's forest nodes by (nonterminal, start) and edges by (from, to)
+  PositionIndex symbols, edgeIndex;
+
+  ParseForest forest;
+  size_t consumed = 0;
+  uint64_t shifts = 0, reductions = 0, fastReductions = 0;
+  size_t maxTops = 0;
+  std::string error;
+  std::ostream* errOut = &std::cerr;
+
+  bool fail(const std::string& msg) {
+    error = msg;
+    if (errOut) *errOut << msg;
+    return false;
+  }
+
+public:
+  GLREngine(const LRTable& t, Policy p = Policy())
+    : table(t), policy(std::move(p)), kinds(policy.kindCount()), ntCount(t.nonTerminals.size()),
+      terminalCount((uint32_t)t.terminals.size()), forest(t) {
+    std::map<std::string, uint32_t> columns;
+    for (uint32_t c = 0; c < table.terminals.size(); ++c) columns[table.terminals[c]] = c;
+    kindColumn.assign(kinds + 1, terminalCount); // the all-error column
+    for (size_t k = 0; k < kinds; ++k) {
+      auto it = columns.find(policy.terminalName(k));
+      if (it != columns.end()) kindColumn[k] = it->second;
+    }
+    endColumn = columns.count("$") ? columns["$"] : terminalCount;
+    headAt.assign(table.states, Head{NONE, 0});
+    uint32_t longest = 0;
+    for (const auto& p : table.productions) {
+      longest = std::max(longest, p.length);
+      hasEmpty |= p.length == 0;
+    }
+    kids.resize(longest + 1);
+  }
+
+  // nullptr = only keep the message for getError()
+  void setErrorStream(std::ostream* out) { errOut = out; }
+  const std::string& getError() const { return error; }
+  size_t tokensConsumed() const { return consumed; }
+
+  // of the last parse: the forest (root = the start symbol over all tokens)
+  // and what it took to build it
+  const ParseForest& getForest() const { return forest; }
+  uint64_t shiftCount() const { return shifts; }
+  uint64_t reductionCount() const { return reductions; }
+  uint64_t deterministicReductions() const { return fastReductions; } // on the plain stack
+  size_t maxStackTops() const { return maxTops; }
+  size_t stackNodes() const { return gss.size(); }
+
+  // Parses tokens (ending with the EOF token), true if accepted
+  template <class Tok>
+  bool parse(const std::vector<Tok>& tokens) {
+    return parse(tokens.data(), tokens.size());
+  }
+
+  template <class Tok>
+  bool parse(const Tok* tokens, size_t count) {
+    consumed = 0;
+    shifts = reductions = fastReductions = 0;
+    maxTops = 1;
+    error.clear();
+    forest.clear();
+    gss.clear();
+    edges.clear();
+    level.clear();
+    work.clear();
+    linear.clear();
+    if (count == 0 || column(tokens, count - 1) != endColumn) {
+      return fail("Error: Token list does not end with the EOF token.\n");
+    }
+    actions = table.actions.data();
+    actionRow = table.actionRow.data();
+    stride = table.stride();
+    defaults = table.defaultReduce.data();
+    gotos = table.gotos.data();
+    gotoRow = table.gotoRow.data();
+    prods = table.productions.data();
+    extraIndex = table.extraBegin.empty() ? nullptr : table.extraBegin.data();
+
+    nextStamp();
+    base = newNode(0, 0);
+    deterministic = true;
+    size_t i = 0;
+    col = column(tokens, 0);
+    while (true) {
+      if (deterministic) {
+        int32_t state = linear.empty() ? gss[base].state : linear.back().state;
+        const LRTable::ExtraAction* end;
+        if (extraBegin(state, col, end) != end) { // a conflict: split from here
+          toGraph((uint32_t)i);
+          continue;
+        }
+        int32_t a = cell(state, col);
+        if (a == 0) {
+          if (defaults[state] < 0) {
+            toGraph((uint32_t)i);
+            consumed = i;
+            return fail(syntaxError(tokens[i], col, i));
+          }
+          a = -defaults[state] - 1;
+        }
+        if (a == LR_ACCEPT) {
+          forest.root = linear.empty() ? edges[gss[base].edges].label : linear.back().label;
+          return accept(i);
+        }
+        if (a > 0) {
+          uint32_t leaf = forest.addNode(col, (uint32_t)i, (uint32_t)i + 1);
+          linear.push_back(LinearEntry{a - 1, (uint32_t)i + 1, leaf});
+          shifts++;
+          nextStamp();
+          col = column(tokens, ++i);
+          continue;
+        }
+        if (!reduceLinear((uint32_t)(-a - 1), (uint32_t)i)) toGraph((uint32_t)i); // popping into a split
+        continue;
+      }
+
+      reduceAll((uint32_t)i);
+      if (level.size() > maxTops) maxTops = level.size();
+      if (col == endColumn) {
+        for (uint32_t n : level) {
+          if (cell(gss[n].state, col) != LR_ACCEPT) continue;
+          forest.root = edges[gss[n].edges].label; // start' : start . , the edge down to the bottom
+          return accept(i);
+        }
+        return fail(syntaxError(tokens[i], col, i));
+      }
+
+      // shift: every top with a shift on the token, merged by state
+      nextStamp();
+      nextLevel.clear();
+      uint32_t leaf = NONE;
+      for (uint32_t n : level) {
+        int32_t a = cell(gss[n].state, col);
+        if (a <= 0 || a == LR_ACCEPT) continue;
+        if (leaf == NONE) leaf = forest.addNode(col, (uint32_t)i, (uint32_t)i + 1);
+        uint32_t w = headAt[a - 1].node;
+        if (headAt[a - 1].stamp != stamp) {
+          w = newNode(a - 1, (uint32_t)i + 1);
+          nextLevel.push_back(w);
+        }
+        addEdge(w, n, leaf);
+        shifts++;
+      }
+      if (nextLevel.empty()) {
+        consumed = i;
+        return fail(syntaxError(tokens[i], col, i));
+      }
+      level.swap(nextLevel);
+      if (level.size() == 1) { // the branches met again
+        deterministic = true;
+        base = level[0];
+      }
+      col = column(tokens, ++i);
+    }
+  }
+
+private:
+  template <class Tok>
+  uint32_t column(const Tok* tokens, size_t i) const {
+    size_t k = policy.kindOf(tokens[i]);
+    return kindColumn[Policy::fixedKinds || k < kinds ? k : kinds];
+  }
+
+  bool accept(size_t i) {
+    consumed = i + 1;
+    METRIC_ONLY(ParseCounters stats; stats.steps = shifts + reductions; stats.expansions = reductions;
+                stats.depth(maxTops);)
+    return true;
+  }
+
+  int32_t cell(int32_t state, uint32_t col) const {
+    return actions[actionRow[state] * stride + col];
+  }
+
+  // the dropped conflict actions of state on col
+  const LRTable::ExtraAction* extraBegin(int32_t state, uint32_t col, const LRTable::ExtraAction*& end) const {
+    if (!extraIndex) {
+      end = nullptr;
+      return nullptr;
+    }
+    const LRTable::ExtraAction* b = table.extra.data() + extraIndex[state];
+    const LRTable::ExtraAction* e = table.extra.data() + extraIndex[state + 1];
+    while (b != e && b->column < col) ++b;
+    end = b;
+    while (end != e && end->column == col) ++end;
+    return b;
+  }
+
+  void nextStamp() {
+    if (++stamp == 0) { // wrapped, forget the old marks
+      std::fill(headAt.begin(), headAt.end(), Head{NONE, 0});
+      std::fill(symbols.stamps.begin(), symbols.stamps.end(), 0);
+      std::fill(edgeIndex.stamps.begin(), edgeIndex.stamps.end(), 0);
+      stamp = 1;
+    }
+    symbols.count = edgeIndex.count = 0;
+  }
+
+  uint32_t newNode(int32_t state, uint32_t pos) {
+    gss.push_back(GssNode{state, pos, NONE, 0, false});
+    headAt[state] = Head{(uint32_t)gss.size() - 1, stamp};
+    return (uint32_t)gss.size() - 1;
+  }
+
+  uint32_t addEdge(uint32_t from, uint32_t to, uint32_t label) {
+    edges.push_back(GssEdge{to, label, gss[from].edges});
+    gss[from].edges = (uint32_t)edges.size() - 1;
+    gss[from].edgeCount++;
+    return gss[from].edges;
+  }
+
+  // forest node for nonterminal over start .. pos (the position being reduced at)
+  uint32_t symbolNode(uint32_t nt, uint32_t start, uint32_t pos) {
+    uint64_t key = (uint64_t)nt << 32 | start;
+    uint32_t n = symbols.find(key, stamp);
+    if (n == NONE) {
+      n = forest.addNode(terminalCount + nt, start, pos);
+      symbols.insert(key, n, stamp);
+    }
+    return n;
+  }
+
+  // a reduction on the deterministic stack, false (nothing done) if it would
+  // pop into a graph node with more than one edge
+  bool reduceLinear(uint32_t production, uint32_t pos) {
+    const LRTable::Production& p = prods[production];
+    size_t have = linear.size();
+    int32_t below;
+    uint32_t start;
+    if (p.length <= have) {
+      for (uint32_t k = 0; k < p.length; ++k) kids[k] = linear[have - p.length + k].label;
+      linear.resize(have - p.length);
+    } else {
+      uint32_t u = base;
+      for (uint32_t k = p.length - (uint32_t)have; k-- > 0;) {
+        if (gss[u].edgeCount != 1) return false;
+        kids[k] = edges[gss[u].edges].label;
+        u = edges[gss[u].edges].to;
+      }
+      for (size_t k = 0; k < have; ++k) kids[p.length - have + k] = linear[k].label;
+      linear.clear();
+      base = u;
+    }
+    if (linear.empty()) {
+      below = gss[base].state;
+      start = gss[base].pos;
+    } else {
+      below = linear.back().state;
+      start = linear.back().pos;
+    }
+    uint32_t sym = symbolNode((uint32_t)p.lhs, start, pos);
+    forest.addFamily(sym, production, kids.data(), p.length);
+    linear.push_back(LinearEntry{gotos[gotoRow[below] * ntCount + p.lhs], pos, sym});
+    reductions++;
+    fastReductions++;
+    return true;
+  }
+
+  // the deterministic stack as graph nodes, the ones at pos become the tops.
+  // all but the last already did their only action
+  void toGraph(uint32_t pos) {
+    level.clear();
+    if (gss[base].pos == pos) {
+      gss[base].reduced = !linear.empty();
+      level.push_back(base);
+    }
+    uint32_t below = base;
+    for (size_t k = 0; k < linear.size(); ++k) {
+      uint32_t n;
+      if (linear[k].pos == pos) {
+        n = newNode(linear[k].state, pos);
+        gss[n].reduced = k + 1 < linear.size();
+        level.push_back(n);
+      } else {
+        gss.push_back(GssNode{linear[k].state, linear[k].pos, NONE, 0, false});
+        n = (uint32_t)gss.size() - 1;
+      }
+      addEdge(n, below, linear[k].label);
+      if (linear[k].pos == pos) edgeIndex.insert((uint64_t)n << 32 | below, 1, stamp);
+      below = n;
+    }
+    linear.clear();
+    deterministic = false;
+  }
+
+  // production reduced down to stack node u: kids[0 .. length) are the
+  // popped symbols' forest nodes. the goto state's top is made or reused
+  void reduceTo(uint32_t u, uint32_t production, uint32_t pos) {
+    const LRTable::Production& p = prods[production];
+    int32_t g = gotos[gotoRow[gss[u].state] * ntCount + p.lhs];
+    reductions++;
+    uint32_t sym = symbolNode((uint32_t)p.lhs, gss[u].pos, pos);
+    forest.addFamily(sym, production, kids.data(), p.length);
+    if (headAt[g].stamp != stamp) {
+      uint32_t w = newNode(g, pos);
+      addEdge(w, u, sym);
+      edgeIndex.insert((uint64_t)w << 32 | u, 1, stamp);
+      level.push_back(w);
+      return;
+    }
+    uint32_t w = headAt[g].node;
+    uint64_t key = (uint64_t)w << 32 | u;
+    if (edgeIndex.find(key, stamp) != NONE) return; // same symbol over the same tokens, only a new family
+    edgeIndex.insert(key, 1, stamp);
+    uint32_t e = addEdge(w, u, sym);
+    // paths through the new edge are new for every top that already reduced.
+    // without epsilon rules only w's own paths can start with it
+    if (!hasEmpty) {
+      if (gss[w].reduced) enqueue(w, e);
+      return;
+    }
+    for (size_t k = 0; k < level.size(); ++k) {
+      if (gss[level[k]].reduced) enqueue(level[k], e);
+    }
+  }
+
+  // the reductions of node n on col (only those that pop edges if via is set)
+  void enqueue(uint32_t n, uint32_t via) {
+    int32_t state = gss[n].state;
+    int32_t a = cell(state, col);
+    if (a == 0 && defaults[state] >= 0) a = -defaults[state] - 1;
+    auto add = [&](int32_t action) {
+      uint32_t p = (uint32_t)(-action - 1);
+      if (via == NONE || prods[p].length > 0) work.push_back(Pending{n, p, via});
+    };
+    if (a < 0) add(a);
+    const LRTable::ExtraAction* end;
+    for (const LRTable::ExtraAction* x = extraBegin(state, col, end); x != end; ++x) {
+      if (x->action < 0) add(x->action);
+    }
+  }
+
+  // every reduction at pos, until no top has one left
+  void reduceAll(uint32_t pos) {
+    size_t next = 0;
+    while (true) {
+      if (work.empty()) {
+        while (next < level.size() && gss[level[next]].reduced) next++;
+        if (next == level.size()) return;
+        gss[level[next]].reduced = true;
+        enqueue(level[next], NONE);
+        continue;
+      }
+      Pending job = work.back();
+      work.pop_back();
+      uint32_t len = prods[job.production].length;
+      if (len == 0) {
+        reduceTo(job.node, job.production, pos);
+        continue;
+      }
+      walk(job.node, len, job.production, job.via, job.via == NONE, pos);
+    }
+  }
+
+  // every path of len edges down from n (through via unless found), reducing production at its end
+  void walk(uint32_t n, uint32_t len, uint32_t production, uint32_t via, bool found, uint32_t pos) {
+    for (uint32_t e = gss[n].edges; e != NONE; e = edges[e].next) {
+      kids[len - 1] = edges[e].label;
+      bool through = found || e == via;
+      if (len == 1) {
+        if (through) reduceTo(edges[e].to, production, pos);
+      } else {
+        walk(edges[e].to, len - 1, production, via, through, pos);
+      }
+    }
+  }
+
+  template <class Tok>
+  std::string syntaxError(const Tok& t, uint32_t col, size_t at) const {
+    std::vector<char> expected(terminalCount, 0);
+    for (uint32_t n : level) {
+      const int32_t* row = &table.actions[table.actionRow[gss[n].state] * table.stride()];
+      for (uint32_t c = 0; c < terminalCount; ++c) expected[c] |= row[c] != 0;
+    }
+    std::ostringstream msg;
+    msg << "Syntax Error: Unexpected '" << t.lexeme << "' ("
+        << (col < terminalCount ? table.terminals[col] : std::string("unknown")) << ") at token " << at
+        << ", expected one of:";
+    for (uint32_t c = 0; c < terminalCount; ++c) {
+      if (expected[c]) msg << " '" << table.terminals[c] << "'";
+    }
+    msg << ".\n";
+    return msg.str();
+  }
+};
+
+// string token types (this tree's Lexer), see RuntimeTokenPolicy::defaults()
+using StringGLREngine = GLREngine<RuntimeTokenPolicy>;
+
+#endif // GLR_ENGINE_H
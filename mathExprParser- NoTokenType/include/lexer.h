@@ -7,11 +7,18 @@
 #include <set>
 #include <cctype>
 #include <stdexcept>
+#include <algorithm>
+#include <istream>
+#include <memory_resource>
+#include "metrics.h"
+#include "number_literal.h"
 
 struct Token {
     std::string type;
     std::string lexeme;
+    NumberValue number; // NUMBER tokens: the literal's value, decoded while scanning
 
+    Token() {}
     Token(const std::string& t, const std::string& l) : type(t), lexeme(l) {}
 };
 
@@ -19,6 +26,20 @@ class Lexer {
 private:
     std::string input;
     size_t pos;
+    size_t tokenStart; // offset of the last token returned by next()
+
+    // metrics, published by flushMetrics() (end of input, reset, destruction)
+    size_t flushedPos = 0;
+    size_t pendingTokens = 0;
+    size_t pendingKeywords = 0;
+
+    void flushMetrics() {
+        METRIC_ADD(lexBytes, pos - flushedPos);
+        METRIC_ADD(lexTokens, pendingTokens);
+        METRIC_ADD(keywordHits, pendingKeywords);
+        flushedPos = pos;
+        pendingTokens = pendingKeywords = 0;
+    }
     
     // Maps for token definitions
     std::map<std::string, std::string> operators;
@@ -26,7 +47,7 @@ private:
     std::map<std::string, std::string> keywords;
 
 public:
-    Lexer(const std::string& input) : input(input), pos(0) {
+    Lexer(const std::string& input) : input(input), pos(0), tokenStart(0) {
         // Default token definitions - can be modified
         
         // Basic operators
@@ -48,6 +69,10 @@ public:
         keywords["char"] = "DATATYPE";
     }
 
+    ~Lexer() {
+        METRIC_ONLY(flushMetrics());
+    }
+
     // Configuration methods
     void addOperator(const std::string& symbol, const std::string& type) {
         operators[symbol] = type;
@@ -75,26 +100,18 @@ public:
         
         // Check if it's a keyword
         auto it = keywords.find(text);
+        METRIC_ONLY(if (it != keywords.end()) pendingKeywords++;)
         return (it != keywords.end()) ? Token(it->second, text) : Token("ID", text);
     }
 
-    // Scan a numeric literal
+    // Scan a numeric literal: 12, 3.5, 1., 6e23, 2.5E-3 (value decoded on the way)
     Token scanNumber() {
         size_t start = pos;
-        bool hasDecimal = false;
-        
-        while (pos < input.size()) {
-            if (isdigit(input[pos])) {
-                pos++;
-            } else if (input[pos] == '.' && !hasDecimal) {
-                pos++;
-                hasDecimal = true;
-            } else {
-                break;
-            }
-        }
-        
-        return Token("NUMBER", input.substr(start, pos - start));
+        NumberValue value;
+        pos += scanNumberLiteral(input.data() + pos, input.data() + input.size(), value);
+        Token token("NUMBER", input.substr(start, pos - start));
+        token.number = value;
+        return token;
     }
 
     // Try to match operator or delimiter
@@ -120,10 +137,29 @@ public:
         return false;
     }
 
-    // Convert input to tokens
-    std::vector<Token> tokenize() {
-        std::vector<Token> tokens;
-        
+    // Replace the text being scanned, keeps the token definitions
+    // (used by StreamLexer to feed the input one chunk at a time)
+    void reset(const std::string& text) {
+        METRIC_ONLY(flushMetrics());
+        input = text;
+        pos = 0;
+        flushedPos = 0;
+        tokenStart = 0;
+    }
+
+    // Give back the token next() just returned, it is scanned again
+    void unread() {
+        METRIC_ONLY(pendingTokens--);
+        pos = tokenStart;
+    }
+
+    // Offsets into the current input (for error positions)
+    size_t position() const { return pos; }
+    size_t lastTokenStart() const { return tokenStart; }
+
+    // Scan the next token, returns false once the input is used up
+    // no EOF token is produced here, tokenize() / StreamLexer add it
+    bool next(Token& token) {
         while (pos < input.size()) {
             char c = input[pos];
             
@@ -132,34 +168,132 @@ public:
                 pos++;
                 continue;
             }
+            tokenStart = pos;
+            METRIC_ONLY(pendingTokens++); // every path below returns a token or throws
             
             // Handle identifiers
             if (isalpha(c) || c == '_') {
-                tokens.push_back(scanIdentifier());
-                continue;
+                token = scanIdentifier();
+                return true;
             }
             
             // Handle numbers
             if (isdigit(c)) {
-                tokens.push_back(scanNumber());
-                continue;
+                token = scanNumber();
+                return true;
             }
             
             // Try operators/delimiters
-            Token token("", "");
             if (tryMatch(token)) {
-                tokens.push_back(token);
-                continue;
+                return true;
             }
             
             // Unknown character
+            METRIC_ONLY(pendingTokens--);
             throw std::runtime_error("Unexpected character: " + std::string(1, c));
         }
+        METRIC_ONLY(flushMetrics());
+        return false;
+    }
+
+    // Convert input to tokens
+    std::vector<Token> tokenize() {
+        std::vector<Token> tokens;
+        Token token("", "");
+        while (next(token)) {
+            tokens.push_back(token);
+        }
         
         // Add EOF token
         tokens.emplace_back("EOF", "$");
         return tokens;
     }
+
+    // Same, with the token vector allocated from mr (a ParseArena per parse,
+    // a pool per thread). lexemes up to 15 chars stay inside the std::string
+    std::pmr::vector<Token> tokenize(std::pmr::memory_resource* mr) {
+        std::pmr::vector<Token> tokens(mr);
+        Token token;
+        while (next(token)) {
+            tokens.push_back(token);
+        }
+        tokens.emplace_back("EOF", "$");
+        return tokens;
+    }
+};
+
+// Lexer over a std::istream, reads the input in fixed size chunks so
+// memory stays bounded no matter how big the file is.
+// a token that ends close to the end of a chunk could come out different
+// with the bytes after it ("1e" then "+5"), so it is given back and scanned
+// again together with the next chunk. only that tail is carried over, and
+// a token longer than maxToken is an error instead of an unbounded buffer.
+class StreamLexer {
+private:
+    std::istream& in;
+    Lexer lexer;
+    std::string chunk;   // what the lexer is scanning
+    size_t chunkSize;
+    bool inputDone;
+    bool eofSent;
+
+    // further than any scanner looks past a token's end (a number's "e+5")
+    static constexpr size_t lookahead = 8;
+    static constexpr size_t maxToken = 1 << 20;
+
+    // Keep chunk[keepFrom..] and append the next piece of input
+    void refill(size_t keepFrom) {
+        std::string carry = chunk.substr(keepFrom);
+        if (carry.size() > maxToken) {
+            throw std::runtime_error("Token longer than " + std::to_string(maxToken) + " bytes");
+        }
+        // at least as much as is carried, so a long token is rescanned a few times, not once per chunk
+        size_t want = std::max(chunkSize, carry.size());
+        std::string buf(want, '\0');
+        in.read(&buf[0], want);
+        buf.resize(in.gcount());
+        if (buf.empty()) inputDone = true;
+        chunk = carry + buf;
+        lexer.reset(chunk);
+    }
+
+public:
+    StreamLexer(std::istream& input, size_t chunk = 1 << 16)
+        : in(input), lexer(""), chunkSize(chunk), inputDone(false), eofSent(false) {}
+
+    // access to the wrapped lexer for addOperator / addKeyword etc.
+    Lexer& definitions() {
+        return lexer;
+    }
+
+    // Produce the next token, the last one is EOF ('$'), then returns false
+    bool next(Token& token) {
+        while (true) {
+            bool got;
+            try {
+                got = lexer.next(token);
+            } catch (const std::runtime_error&) {
+                // a cut operator ("<" of "<=") is only unknown until the rest comes in
+                if (inputDone || lexer.lastTokenStart() + lookahead < chunk.size()) throw;
+                refill(lexer.lastTokenStart());
+                continue;
+            }
+            if (got) {
+                if (inputDone || lexer.position() + lookahead < chunk.size()) return true;
+                lexer.unread(); // may go on in the next chunk
+                refill(lexer.lastTokenStart());
+                continue;
+            }
+            if (!inputDone) {
+                refill(chunk.size());
+                continue;
+            }
+            if (eofSent) return false;
+            eofSent = true;
+            token = Token("EOF", "$");
+            return true;
+        }
+    }
 };
 
 #endif // LEXER_H
\ No newline at end of file
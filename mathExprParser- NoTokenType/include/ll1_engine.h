@@ -0,0 +1,334 @@
+#ifndef LL1_ENGINE_H
+#define LL1_ENGINE_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <initializer_list>
+#include <cstdint>
+#include "metrics.h"
+#include "parse_table_layout.h"
+
+// One LL(1) driver for both pipelines, templated on a token type policy.
+// the policy says how many token kinds there are, which grammar terminal
+// each kind is, and the kind of a token:
+//
+//   static constexpr size_t fixedKinds;   // kind count known at compile time, 0 = runtime
+//   size_t kindCount() const;
+//   std::string terminalName(size_t k) const;   // "" = not a grammar terminal
+//   template <class Tok> size_t kindOf(const Tok& t) const;   // kindCount() = unknown
+//
+// EnumTokenPolicy (enum class TokenType, simple_math_expr_parser-A6) turns
+// kindOf into a cast and the table stride into a constant.
+// RuntimeTokenPolicy (string token types, this tree) registers its kinds at
+// runtime and pays one hash lookup per token for it.
+//
+// the string keyed ParseTable is compiled into a [nonterminal][kind] table of
+// production indices, the parse stack holds ints. the table layout is the
+// second parameter (include/parse_table_layout.h): dense by default,
+// CombParseTable for big grammars.
+//
+// both trees' LL1Parser are this engine plus an LL1Trace that prints each step.
+
+using ParseTable = std::map<std::string, std::map<std::string, std::vector<std::string>>>;
+
+// Step by step view of a parse, for the printing front ends. token is the
+// index of the lookahead token, the names are grammar symbols. a mismatch or
+// a missing production ends the parse right after the call.
+class LL1Trace {
+public:
+  virtual ~LL1Trace() {}
+  virtual void step(const std::string& top, size_t token) {}
+  virtual void match(const std::string& terminal, size_t token) {}
+  virtual void expand(const std::string& nonTerminal, const std::vector<std::string>& body, size_t token) {}
+  virtual void mismatch(const std::string& expected, size_t token) {}
+  virtual void noProduction(const std::string& nonTerminal, size_t token) {}
+};
+
+// Traits: using Kind = <enum>; static constexpr size_t count;
+//         static const char* terminal(Kind)   ("" if the kind is not in the grammar)
+template <class Traits>
+struct EnumTokenPolicy {
+  using Kind = typename Traits::Kind;
+  static constexpr size_t fixedKinds = Traits::count;
+
+  size_t kindCount() const { return Traits::count; }
+  std::string terminalName(size_t k) const { return Traits::terminal((Kind)k); }
+
+  template <class Tok>
+  size_t kindOf(const Tok& t) const { return (size_t)t.type; }
+};
+
+class RuntimeTokenPolicy {
+public:
+  static constexpr size_t fixedKinds = 0;
+
+  // tokens of this type are the grammar terminal `terminal`
+  void addKind(const std::string& tokenType, const std::string& terminal) {
+    types[tokenType] = {newKind(terminal), false};
+  }
+
+  // tokens of this type are the terminal named by their lexeme (DATATYPE int -> "int")
+  void addLexemeKind(const std::string& tokenType, std::initializer_list<const char*> lexemes) {
+    types[tokenType] = {SIZE_MAX, true};
+    for (const char* l : lexemes) byLexeme[l] = newKind(l);
+  }
+
+  size_t kindCount() const { return names.size(); }
+  std::string terminalName(size_t k) const { return names[k]; }
+
+  template <class Tok>
+  size_t kindOf(const Tok& t) const {
+    auto it = types.find(t.type);
+    if (it == types.end()) return names.size();
+    if (!it->second.second) return it->second.first;
+    auto l = byLexeme.find(t.lexeme);
+    return l == byLexeme.end() ? names.size() : l->second;
+  }
+
+  // the token types Lexer hands out, mapped like tokenToParserSymbol()
+  static RuntimeTokenPolicy defaults() {
+    RuntimeTokenPolicy p;
+    p.addKind("ID", "id");
+    p.addKind("NUMBER", "num");
+    p.addKind("PLUS", "+");
+    p.addKind("MINUS", "-");
+    p.addKind("TIMES", "*");
+    p.addKind("DIVIDE", "/");
+    p.addKind("LPAREN", "(");
+    p.addKind("RPAREN", ")");
+    p.addKind("COMMA", ",");
+    p.addKind("SEMICOLON", ";");
+    p.addKind("ASSIGN", "=");
+    p.addKind("EOF", "$");
+    p.addLexemeKind("DATATYPE", {"int", "float", "char"});
+    return p;
+  }
+
+private:
+  std::vector<std::string> names; // kind -> terminal
+  std::unordered_map<std::string, std::pair<size_t, bool>> types; // token type -> kind, by lexeme?
+  std::unordered_map<std::string, size_t> byLexeme;
+
+  size_t newKind(const std::string& terminal) {
+    names.push_back(terminal);
+    return names.size() - 1;
+  }
+};
+
+template <class Policy, class Table = DenseParseTable<Policy::fixedKinds ? Policy::fixedKinds + 1 : 0>>
+class LL1Engine {
+private:
+  Policy policy;
+  size_t kinds;                    // columns = kinds + 1, the last one is "unknown token"
+  int terminalCount;               // stack symbols < terminalCount are terminals
+  std::vector<std::string> symbolNames;
+  std::vector<int> kindTerminal;   // kind (+ unknown) -> terminal symbol id, -1 = not in the grammar
+  Table table;                     // [nonterminal][column] -> production, -1 = error
+  std::vector<int> rhs;            // all right hand sides back to back, reversed
+  std::vector<uint32_t> rhsStart;  // production p is rhs[rhsStart[p] .. rhsStart[p + 1])
+  int startSymbol = -1;
+  int endSymbol = -1;              // "$"
+
+  std::vector<int> stack;
+  size_t consumed = 0;
+  std::string error;
+  std::ostream* errOut = &std::cerr;
+  LL1Trace* trace = nullptr;
+
+  bool fail(const std::string& msg) {
+    error = msg;
+    if (errOut) *errOut << msg;
+    return false;
+  }
+
+  template <class Tok>
+  std::string describe(const Tok& t, size_t k) const {
+    std::string name = k < kinds ? policy.terminalName(k) : "";
+    return "'" + t.lexeme + "' (" + (name.empty() ? std::string("unknown") : name) + ")";
+  }
+
+public:
+  LL1Engine(const ParseTable& parseTable,
+            const std::set<std::string>& terms,
+            const std::set<std::string>& nonTerms,
+            const std::string& start,
+            Policy p = Policy())
+    : policy(std::move(p)), kinds(policy.kindCount()) {
+    std::map<std::string, int> ids;
+    for (const auto& t : terms) {
+      if (t == "epsilon") continue;
+      ids[t] = (int)symbolNames.size();
+      symbolNames.push_back(t);
+    }
+    if (!ids.count("$")) {
+      ids["$"] = (int)symbolNames.size();
+      symbolNames.push_back("$");
+    }
+    // symbols used in a production but in neither set: terminals no kind
+    // matches, reported (by name) when one reaches the top of the stack
+    for (const auto& row : parseTable) {
+      for (const auto& cell : row.second) {
+        for (const auto& sym : cell.second) {
+          if (sym != "epsilon" && !ids.count(sym) && !nonTerms.count(sym)) {
+            ids[sym] = (int)symbolNames.size();
+            symbolNames.push_back(sym);
+          }
+        }
+      }
+    }
+    terminalCount = (int)symbolNames.size();
+    for (const auto& nt : nonTerms) {
+      ids[nt] = (int)symbolNames.size();
+      symbolNames.push_back(nt);
+    }
+    endSymbol = ids["$"];
+    auto s = ids.find(start);
+    startSymbol = s == ids.end() ? -1 : s->second;
+
+    kindTerminal.assign(kinds + 1, -1);
+    std::vector<std::vector<uint32_t>> terminalKinds(terminalCount);
+    for (size_t k = 0; k < kinds; ++k) {
+      auto it = ids.find(policy.terminalName(k));
+      if (it != ids.end() && it->second < terminalCount) {
+        kindTerminal[k] = it->second;
+        terminalKinds[it->second].push_back((uint32_t)k);
+      }
+    }
+
+    std::vector<ParseTableCell> cells;
+    rhsStart.push_back(0);
+    for (const auto& row : parseTable) {
+      auto nt = ids.find(row.first);
+      if (nt == ids.end() || nt->second < terminalCount) continue;
+      for (const auto& cell : row.second) {
+        int32_t prod = (int32_t)rhsStart.size() - 1;
+        const std::vector<std::string>& body = cell.second;
+        for (size_t i = body.size(); i-- > 0;) {
+          if (body[i] == "epsilon") continue;
+          rhs.push_back(ids[body[i]]);
+        }
+        rhsStart.push_back((uint32_t)rhs.size());
+        // every kind that is this terminal gets the production
+        auto t = ids.find(cell.first);
+        if (t == ids.end() || t->second >= terminalCount) continue;
+        for (uint32_t k : terminalKinds[t->second]) {
+          cells.push_back({(uint32_t)(nt->second - terminalCount), k, prod});
+        }
+      }
+    }
+    table.build(nonTerms.size(), kinds + 1, cells);
+  }
+
+  // nullptr = only keep the message for getError()
+  void setErrorStream(std::ostream* out) { errOut = out; }
+  // nullptr (the default) = no tracing
+  void setTrace(LL1Trace* t) { trace = t; }
+  const std::string& getError() const { return error; }
+  size_t tokensConsumed() const { return consumed; }
+  const Policy& getPolicy() const { return policy; }
+  const Table& getTable() const { return table; }
+
+  // Parses tokens (ending with the EOF token), true if accepted
+  template <class Tok>
+  bool parse(const std::vector<Tok>& tokens) {
+    return parse(tokens.data(), tokens.size());
+  }
+
+  template <class Tok>
+  bool parse(const Tok* tokens, size_t count) {
+    consumed = 0;
+    error.clear();
+    if (startSymbol < 0) return fail("Error: Cannot parse without a start symbol.\n");
+
+    // with the EOF token last, "$" (bottom of the stack) can only match it,
+    // so the loop never runs past the end and needs no bounds checks
+    if (count == 0 || kindTerminal[kindAt(tokens, count - 1)] != endSymbol) {
+      return fail("Error: Token list does not end with the EOF token.\n");
+    }
+
+    return trace ? run<true>(tokens) : run<false>(tokens);
+  }
+
+  // kind of tokens[i], clamped to the unknown column (the clamp folds away for enum policies)
+  template <class Tok>
+  size_t kindAt(const Tok* tokens, size_t i) const {
+    size_t k = policy.kindOf(tokens[i]);
+    return Policy::fixedKinds || k < kinds ? k : kinds;
+  }
+
+  // right hand side of production p as grammar symbols, {"epsilon"} if empty
+  std::vector<std::string> body(int32_t p) const {
+    std::vector<std::string> out;
+    for (uint32_t j = rhsStart[p + 1]; j-- > rhsStart[p];) out.push_back(symbolNames[rhs[j]]);
+    if (out.empty()) out.push_back("epsilon");
+    return out;
+  }
+
+  std::string symbolName(int id) const {
+    return id >= 0 && id < (int)symbolNames.size() ? symbolNames[id] : "<unknown symbol>";
+  }
+
+private:
+  // the parse loop, Traced = the trace calls are compiled in
+  template <bool Traced, class Tok>
+  bool run(const Tok* tokens) {
+    const int* kt = kindTerminal.data();
+    stack.clear();
+    stack.push_back(endSymbol);
+    stack.push_back(startSymbol);
+
+    size_t i = 0;
+    size_t k = kindAt(tokens, 0);
+    METRIC_ONLY(ParseCounters stats;)
+    while (!stack.empty()) {
+      int top = stack.back();
+      METRIC_ONLY(stats.steps++;)
+      if (Traced) trace->step(symbolNames[top], i);
+      if (top < terminalCount) {
+        if (kt[k] != top) {
+          if (Traced) trace->mismatch(symbolNames[top], i);
+          std::ostringstream msg;
+          msg << "Syntax Error: Expected '" << symbolName(top) << "' but got " << describe(tokens[i], k)
+              << " at token " << i << ".\n";
+          consumed = i;
+          return fail(msg.str());
+        }
+        if (Traced) trace->match(symbolNames[top], i);
+        stack.pop_back();
+        ++i;
+        if (top == endSymbol) {
+          consumed = i;
+          return true;
+        }
+        k = kindAt(tokens, i);
+        continue;
+      }
+
+      int32_t prod = table.at(top - terminalCount, k);
+      if (prod < 0) {
+        if (Traced) trace->noProduction(symbolNames[top], i);
+        std::ostringstream msg;
+        msg << "Syntax Error: No production for '" << symbolName(top) << "' on " << describe(tokens[i], k)
+            << " at token " << i << ".\n";
+        consumed = i;
+        return fail(msg.str());
+      }
+      if (Traced) trace->expand(symbolNames[top], body(prod), i);
+      stack.pop_back();
+      stack.insert(stack.end(), rhs.begin() + rhsStart[prod], rhs.begin() + rhsStart[prod + 1]);
+      METRIC_ONLY(stats.expansions++; stats.depth(stack.size());)
+    }
+    return fail("Syntax Error: Parsing did not complete correctly.\n");
+  }
+};
+
+// string token types (this tree's Lexer), see RuntimeTokenPolicy::defaults()
+using StringLL1Engine = LL1Engine<RuntimeTokenPolicy>;
+using CombLL1Engine = LL1Engine<RuntimeTokenPolicy, CombParseTable>;
+
+#endif // LL1_ENGINE_H
@@ -0,0 +1,159 @@
+#ifndef LR_ENGINE_H
+#define LR_ENGINE_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include "ll1_engine.h"   // token type policies
+#include "lr_table_gen.h" // LRTable
+#include "metrics.h"
+
+// Shift-reduce driver for LRTableGenerator's tables, templated on the same
+// token type policies as LL1Engine. the stack holds only state numbers: a
+// shift pushes one, a reduction pops the production's length and pushes the
+// goto state. one table lookup per step, and a left recursive grammar needs
+// no tail nonterminals, so there are fewer steps per token than LL(1) takes
+// (bench/bench_lr.cpp counts them).
+template <class Policy>
+class LREngine {
+private:
+  const LRTable& table;
+  Policy policy;
+  size_t kinds;
+  std::vector<uint32_t> kindColumn; // kind (+ unknown) -> action column
+  uint32_t endColumn;               // "$"
+  size_t ntCount;
+
+  std::vector<int32_t> stack;
+  size_t consumed = 0;
+  uint64_t shifts = 0, reductions = 0;
+  std::string error;
+  std::ostream* errOut = &std::cerr;
+  size_t maxDepth = 0;
+
+  bool fail(const std::string& msg) {
+    error = msg;
+    if (errOut) *errOut << msg;
+    return false;
+  }
+
+public:
+  LREngine(const LRTable& t, Policy p = Policy())
+    : table(t), policy(std::move(p)), kinds(policy.kindCount()), ntCount(t.nonTerminals.size()) {
+    std::map<std::string, uint32_t> columns;
+    for (uint32_t c = 0; c < table.terminals.size(); ++c) columns[table.terminals[c]] = c;
+    uint32_t unknown = (uint32_t)table.terminals.size(); // the all-error column
+    kindColumn.assign(kinds + 1, unknown);
+    for (size_t k = 0; k < kinds; ++k) {
+      auto it = columns.find(policy.terminalName(k));
+      if (it != columns.end()) kindColumn[k] = it->second;
+    }
+    endColumn = columns.count("$") ? columns["$"] : unknown;
+  }
+
+  // nullptr = only keep the message for getError()
+  void setErrorStream(std::ostream* out) { errOut = out; }
+  const std::string& getError() const { return error; }
+  size_t tokensConsumed() const { return consumed; }
+  uint64_t shiftCount() const { return shifts; }        // of the last parse
+  uint64_t reductionCount() const { return reductions; }
+  size_t maxStackDepth() const { return maxDepth; }
+
+  // Parses tokens (ending with the EOF token), true if accepted
+  template <class Tok>
+  bool parse(const std::vector<Tok>& tokens) {
+    return parse(tokens.data(), tokens.size());
+  }
+
+  template <class Tok>
+  bool parse(const Tok* tokens, size_t count) {
+    consumed = 0;
+    shifts = reductions = 0;
+    error.clear();
+    if (count == 0 || kindColumn[kindAt(tokens, count - 1)] != endColumn) {
+      return fail("Error: Token list does not end with the EOF token.\n");
+    }
+
+    const size_t stride = table.stride();
+    const int32_t* actions = table.actions.data();
+    const uint32_t* actionRow = table.actionRow.data();
+    const int32_t* defaults = table.defaultReduce.data();
+    const int32_t* gotos = table.gotos.data();
+    const uint32_t* gotoRow = table.gotoRow.data();
+    const LRTable::Production* prods = table.productions.data();
+
+    stack.clear();
+    stack.push_back(0);
+    size_t i = 0;
+    uint32_t col = kindColumn[kindAt(tokens, 0)];
+    uint64_t shifted = 0, reduced = 0;
+    size_t depth = 1;
+    while (true) {
+      int32_t state = stack.back();
+      int32_t a = actions[actionRow[state] * stride + col];
+      if (a == 0) {
+        int32_t d = defaults[state];
+        if (d < 0) {
+          tally(shifted, reduced, depth);
+          consumed = i;
+          return fail(syntaxError(state, tokens[i], col, i));
+        }
+        a = -d - 1;
+      }
+      if (a == LR_ACCEPT) {
+        consumed = i + 1;
+        break;
+      }
+      if (a > 0) {
+        stack.push_back(a - 1);
+        ++shifted;
+        col = kindColumn[kindAt(tokens, ++i)]; // never past the EOF token, nothing shifts it
+      } else {
+        const LRTable::Production& p = prods[-a - 1];
+        stack.resize(stack.size() - p.length);
+        stack.push_back(gotos[gotoRow[stack.back()] * ntCount + p.lhs]);
+        ++reduced;
+      }
+      if (stack.size() > depth) depth = stack.size();
+    }
+    tally(shifted, reduced, depth);
+    return true;
+  }
+
+private:
+  // the loop counts in locals, kept here and published once per parse
+  void tally(uint64_t shifted, uint64_t reduced, size_t depth) {
+    shifts = shifted;
+    reductions = reduced;
+    maxDepth = depth;
+    METRIC_ONLY(ParseCounters stats; stats.steps = shifted + reduced; stats.expansions = reduced; stats.depth(depth);)
+  }
+
+  template <class Tok>
+  size_t kindAt(const Tok* tokens, size_t i) const {
+    size_t k = policy.kindOf(tokens[i]);
+    return Policy::fixedKinds || k < kinds ? k : kinds;
+  }
+
+  template <class Tok>
+  std::string syntaxError(int32_t state, const Tok& t, uint32_t col, size_t at) const {
+    std::ostringstream msg;
+    msg << "Syntax Error: Unexpected '" << t.lexeme << "' ("
+        << (col < table.terminals.size() ? table.terminals[col] : std::string("unknown")) << ") at token " << at
+        << ", expected one of:";
+    const int32_t* row = &table.actions[table.actionRow[state] * table.stride()];
+    for (size_t c = 0; c < table.terminals.size(); ++c) {
+      if (row[c] != 0) msg << " '" << table.terminals[c] << "'";
+    }
+    msg << ".\n";
+    return msg.str();
+  }
+};
+
+// string token types (this tree's Lexer), see RuntimeTokenPolicy::defaults()
+using StringLREngine = LREngine<RuntimeTokenPolicy>;
+
+#endif // LR_ENGINE_H
@@ -0,0 +1,597 @@
+#ifndef LR_TABLE_GEN_H
+#define LR_TABLE_GEN_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdint>
+#include "metrics.h"
+
+// SLR(1) / LALR(1) tables from the same grammar files as ParseTableGenerator
+// (first rule's left side is the start symbol, "epsilon" is the empty body).
+// LR grammars may be left recursive, so the expression grammar can stay
+//
+//   E : E + T | E - T | T        T : T * F | T / F | F        F : ( E ) | id
+//
+// instead of the Expr / Termp tails LL(1) needs. steps:
+//   - LR(0) item sets (kernels only, closures are recomputed when needed)
+//   - LALR: lookaheads by propagation (the dragon book's algorithm: the LR(1)
+//     closure of each kernel item with a dummy lookahead tells which
+//     lookaheads are generated and which are passed on), SLR: FOLLOW sets
+//   - conflicts are reported and resolved like yacc: shift over reduce,
+//     the earlier production on reduce / reduce. the losing actions are
+//     kept on the side for the GLR driver (include/glr_engine.h)
+//   - compression: the most common reduction of a state becomes its default
+//     (taken on any token without an entry) and identical action / goto
+//     rows are stored once
+
+// LR action: 0 = error (or the state's default reduction), > 0 = shift to
+// state a - 1, < 0 = reduce production -a - 1
+const int32_t LR_ACCEPT = INT32_MAX;
+
+struct LRTable {
+  struct Production {
+    int lhs;          // nonterminal
+    uint32_t length;  // symbols popped
+  };
+
+  std::vector<std::string> terminals;    // column -> terminal ("$" included)
+  std::vector<std::string> nonTerminals; // 0 is the added start symbol
+  std::vector<Production> productions;   // 0 is start' : start
+  std::vector<std::string> productionText;
+  size_t states = 0;
+
+  // actions[actionRow[state] * stride() + column], the last column is for
+  // tokens that aren't terminals of the grammar (always 0)
+  std::vector<uint32_t> actionRow;
+  std::vector<int32_t> actions;
+  std::vector<int32_t> defaultReduce; // state -> production, -1 = none
+  // gotos[gotoRow[state] * nonTerminals.size() + nonterminal] -> state, -1 = none
+  std::vector<uint32_t> gotoRow;
+  std::vector<int32_t> gotos;
+  // the actions conflict resolution dropped (GLREngine tries them too):
+  // extra[extraBegin[state] .. extraBegin[state + 1]), empty if there were no conflicts
+  struct ExtraAction {
+    uint32_t column;
+    int32_t action;
+  };
+  std::vector<uint32_t> extraBegin;
+  std::vector<ExtraAction> extra;
+
+  size_t stride() const { return terminals.size() + 1; }
+
+  // bytes of the tables as stored vs as plain [state][column] arrays
+  size_t bytes() const {
+    return 4 * (actionRow.size() + actions.size() + defaultReduce.size() + gotoRow.size() + gotos.size() +
+                extraBegin.size()) + sizeof(ExtraAction) * extra.size();
+  }
+  size_t denseBytes() const { return 4 * states * (stride() + nonTerminals.size()); }
+};
+
+class LRTableGenerator {
+public:
+  enum class Mode { SLR, LALR };
+
+  // Load grammar from file (: is the separator), productions keep the file's order
+  bool loadGrammar(const std::string& filename) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+      std::cerr << "Error: Cannot open grammar file.\n";
+      return false;
+    }
+    names.clear();
+    rules.clear();
+    std::vector<std::pair<std::string, std::vector<std::string>>> read;
+    std::string line;
+    while (std::getline(file, line)) {
+      std::istringstream iss(line);
+      std::string nt, colon, sym;
+      iss >> nt >> colon;
+      if (iss.fail() || colon != ":") continue;
+      std::vector<std::string> body;
+      while (iss >> sym) {
+        if (sym != "epsilon") body.push_back(sym);
+      }
+      read.push_back({nt, body});
+    }
+    if (read.empty()) {
+      std::cerr << "Error: Grammar has no rules.\n";
+      return false;
+    }
+
+    // terminals first (every symbol never on a left side, then $), then nonterminals
+    std::map<std::string, int> isNonTerminal;
+    for (const auto& r : read) isNonTerminal[r.first] = 1;
+    std::map<std::string, int> ids;
+    for (const auto& r : read) {
+      for (const std::string& s : r.second) {
+        if (!isNonTerminal.count(s) && !ids.count(s)) {
+          ids[s] = (int)names.size();
+          names.push_back(s);
+        }
+      }
+    }
+    ids["$"] = (int)names.size();
+    names.push_back("$");
+    terminalCount = (int)names.size();
+    start = read[0].first;
+    names.push_back(start + "'");
+    for (const auto& r : read) {
+      if (!ids.count(r.first)) {
+        ids[r.first] = (int)names.size();
+        names.push_back(r.first);
+      }
+    }
+
+    rules.push_back({terminalCount, {ids[start]}});
+    for (const auto& r : read) {
+      Rule rule{ids[r.first], {}};
+      for (const std::string& s : r.second) rule.rhs.push_back(ids[s]);
+      rules.push_back(rule);
+    }
+    return true;
+  }
+
+  // Builds the tables, conflicts go to std::cerr (and conflictMessages())
+  void generateTable(Mode m = Mode::LALR) {
+    mode = m;
+    messages.clear();
+    conflictCount = 0;
+    numberItems();
+    computeFirst();
+    buildStates();
+    if (mode == Mode::LALR) propagateLookaheads();
+    else computeFollow();
+    buildActions();
+  }
+
+  const LRTable& getTable() const { return table; }
+  size_t conflicts() const { return conflictCount; }
+  const std::vector<std::string>& conflictMessages() const { return messages; }
+  const std::string& getStartSymbol() const { return start; }
+
+private:
+  struct Rule {
+    int lhs;              // symbol id
+    std::vector<int> rhs; // symbol ids
+  };
+
+  // a set of terminals, plus one extra bit for the dummy lookahead in LALR closures
+  struct Bits {
+    std::vector<uint64_t> w;
+    explicit Bits(size_t n = 0) : w((n + 63) / 64, 0) {}
+    bool test(size_t i) const { return w[i >> 6] >> (i & 63) & 1; }
+    void set(size_t i) { w[i >> 6] |= uint64_t(1) << (i & 63); }
+    void reset(size_t i) { w[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+    bool merge(const Bits& o) { // |=, true if something was added
+      bool changed = false;
+      for (size_t i = 0; i < w.size(); ++i) {
+        uint64_t n = w[i] | o.w[i];
+        changed |= n != w[i];
+        w[i] = n;
+      }
+      return changed;
+    }
+    template <class F>
+    void forEach(F f) const {
+      for (size_t i = 0; i < w.size(); ++i) {
+        for (uint64_t x = w[i]; x; x &= x - 1) f(i * 64 + __builtin_ctzll(x));
+      }
+    }
+  };
+
+  struct State {
+    std::vector<uint32_t> kernel;                // items, sorted
+    std::vector<std::pair<int, int>> next;       // symbol -> state
+    uint32_t kernelBase = 0;                     // global index of kernel[0]
+  };
+
+  Mode mode = Mode::LALR;
+  std::vector<std::string> names; // symbol id -> name
+  int terminalCount = 0;          // ids below are terminals, "$" is terminalCount - 1
+  std::string start;
+  std::vector<Rule> rules;
+
+  // item = itemBase[rule] + dot
+  std::vector<uint32_t> itemBase, itemRule, itemDot;
+  std::vector<std::vector<uint32_t>> rulesOf; // nonterminal (id - terminalCount) -> rules
+  std::vector<Bits> first;                    // nonterminal -> FIRST, terminals only
+  std::vector<char> nullable;
+  std::vector<Bits> follow;                   // SLR
+  std::vector<State> states;
+  std::vector<Bits> lookahead;                // LALR: per kernel item (global index)
+  // LALR: epsilon rules reduced in a state, with their spontaneous lookaheads
+  // and the kernel items whose lookaheads they inherit
+  struct EmptyReduce {
+    uint32_t rule;
+    Bits spontaneous;
+    std::vector<uint32_t> from;
+  };
+  std::vector<std::vector<EmptyReduce>> emptyReduces;
+
+  LRTable table;
+  size_t conflictCount = 0;
+  std::vector<std::string> messages;
+  std::vector<LRTable::ExtraAction> dropped; // the current state's losing actions
+
+  bool isTerminal(int sym) const { return sym < terminalCount; }
+  int ntIndex(int sym) const { return sym - terminalCount; }
+  int symbolAfterDot(uint32_t item) const {
+    const Rule& r = rules[itemRule[item]];
+    return itemDot[item] < r.rhs.size() ? r.rhs[itemDot[item]] : -1;
+  }
+
+  void numberItems() {
+    itemBase.clear();
+    itemRule.clear();
+    itemDot.clear();
+    rulesOf.assign(names.size() - terminalCount, {});
+    for (uint32_t r = 0; r < rules.size(); ++r) {
+      itemBase.push_back((uint32_t)itemRule.size());
+      for (uint32_t d = 0; d <= rules[r].rhs.size(); ++d) {
+        itemRule.push_back(r);
+        itemDot.push_back(d);
+      }
+      rulesOf[ntIndex(rules[r].lhs)].push_back(r);
+    }
+  }
+
+  void computeFirst() {
+    size_t nts = names.size() - terminalCount;
+    first.assign(nts, Bits(terminalCount + 1));
+    nullable.assign(nts, 0);
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      METRIC_ADD(firstIterations, 1);
+      for (const Rule& r : rules) {
+        int a = ntIndex(r.lhs);
+        bool allNullable = true;
+        for (int s : r.rhs) {
+          if (isTerminal(s)) {
+            if (!first[a].test(s)) {
+              first[a].set(s);
+              changed = true;
+            }
+            allNullable = false;
+            break;
+          }
+          changed |= first[a].merge(first[ntIndex(s)]);
+          if (!nullable[ntIndex(s)]) {
+            allNullable = false;
+            break;
+          }
+        }
+        if (allNullable && !nullable[a]) {
+          nullable[a] = 1;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  // FIRST of rhs[from..] into out, true if all of it can be empty
+  bool firstOfRest(const std::vector<int>& rhs, size_t from, Bits& out) const {
+    for (size_t i = from; i < rhs.size(); ++i) {
+      if (isTerminal(rhs[i])) {
+        out.set(rhs[i]);
+        return false;
+      }
+      out.merge(first[ntIndex(rhs[i])]);
+      if (!nullable[ntIndex(rhs[i])]) return false;
+    }
+    return true;
+  }
+
+  // nonterminals whose rules are in the closure of kernel (their dot 0 items)
+  std::vector<int> closedNonTerminals(const std::vector<uint32_t>& kernel, std::vector<uint32_t>& stamp,
+                                      uint32_t mark) const {
+    std::vector<int> out;
+    auto add = [&](int sym) {
+      if (sym < 0 || isTerminal(sym) || stamp[ntIndex(sym)] == mark) return;
+      stamp[ntIndex(sym)] = mark;
+      out.push_back(sym);
+    };
+    for (uint32_t item : kernel) add(symbolAfterDot(item));
+    for (size_t i = 0; i < out.size(); ++i) {
+      for (uint32_t r : rulesOf[ntIndex(out[i])]) {
+        if (!rules[r].rhs.empty()) add(rules[r].rhs[0]);
+      }
+    }
+    return out;
+  }
+
+  void buildStates() {
+    states.clear();
+    std::map<std::vector<uint32_t>, int> index;
+    states.push_back(State{{itemBase[0]}, {}, 0});
+    index[states[0].kernel] = 0;
+    std::vector<uint32_t> stamp(names.size() - terminalCount, 0);
+    uint32_t kernelItems = 0;
+
+    for (size_t s = 0; s < states.size(); ++s) {
+      states[s].kernelBase = kernelItems;
+      kernelItems += (uint32_t)states[s].kernel.size();
+
+      // all items of the closure, grouped by the symbol after the dot
+      std::map<int, std::vector<uint32_t>> moves;
+      for (uint32_t item : states[s].kernel) {
+        int sym = symbolAfterDot(item);
+        if (sym >= 0) moves[sym].push_back(item + 1);
+      }
+      for (int nt : closedNonTerminals(states[s].kernel, stamp, (uint32_t)s + 1)) {
+        for (uint32_t r : rulesOf[ntIndex(nt)]) {
+          if (!rules[r].rhs.empty()) moves[rules[r].rhs[0]].push_back(itemBase[r] + 1);
+        }
+      }
+      for (auto& m : moves) {
+        std::sort(m.second.begin(), m.second.end());
+        auto it = index.find(m.second);
+        int target;
+        if (it == index.end()) {
+          target = (int)states.size();
+          index.emplace(m.second, target);
+          states.push_back(State{m.second, {}, 0});
+        } else {
+          target = it->second;
+        }
+        states[s].next.push_back({m.first, target});
+      }
+    }
+  }
+
+  int nextState(const State& s, int sym) const {
+    for (const auto& n : s.next) {
+      if (n.first == sym) return n.second;
+    }
+    return -1;
+  }
+
+  // global index of item in state s's kernel
+  uint32_t kernelIndex(const State& s, uint32_t item) const {
+    auto it = std::lower_bound(s.kernel.begin(), s.kernel.end(), item);
+    return s.kernelBase + (uint32_t)(it - s.kernel.begin());
+  }
+
+  void propagateLookaheads() {
+    size_t kernelItems = states.back().kernelBase + states.back().kernel.size();
+    size_t bits = terminalCount + 1;
+    const int dummy = terminalCount; // the extra bit
+    lookahead.assign(kernelItems, Bits(bits));
+    std::vector<std::vector<uint32_t>> passesTo(kernelItems);
+    emptyReduces.assign(states.size(), {});
+    lookahead[0].set(terminalCount - 1); // start' : . start  on $
+
+    // LR(1) closure of one kernel item with the dummy lookahead
+    std::vector<Bits> la(itemRule.size(), Bits(bits));
+    std::vector<uint32_t> inClosure(itemRule.size(), 0);
+    uint32_t mark = 0;
+    std::vector<uint32_t> items;
+
+    for (size_t s = 0; s < states.size(); ++s) {
+      const State& st = states[s];
+      std::map<uint32_t, size_t> emptyAt; // rule -> index in emptyReduces[s]
+      for (uint32_t k = 0; k < st.kernel.size(); ++k) {
+        uint32_t from = st.kernelBase + k;
+        mark++;
+        items.clear();
+        auto add = [&](uint32_t item, const Bits& l) {
+          if (inClosure[item] != mark) {
+            inClosure[item] = mark;
+            la[item] = l;
+            items.push_back(item);
+            return true;
+          }
+          return la[item].merge(l);
+        };
+        Bits seed(bits);
+        seed.set(dummy);
+        add(st.kernel[k], seed);
+        bool changed = true;
+        while (changed) { // lookaheads can grow after an item was expanded
+          changed = false;
+          for (size_t i = 0; i < items.size(); ++i) {
+            uint32_t item = items[i];
+            int sym = symbolAfterDot(item);
+            if (sym < 0 || isTerminal(sym)) continue;
+            const Rule& r = rules[itemRule[item]];
+            Bits l(bits);
+            if (firstOfRest(r.rhs, itemDot[item] + 1, l)) l.merge(la[item]);
+            for (uint32_t rule : rulesOf[ntIndex(sym)]) changed |= add(itemBase[rule], l);
+          }
+        }
+
+        for (uint32_t item : items) {
+          int sym = symbolAfterDot(item);
+          if (sym < 0) {
+            if (itemDot[item] != 0) continue; // a kernel item, reduced with its own lookaheads
+            auto e = emptyAt.find(itemRule[item]);
+            if (e == emptyAt.end()) {
+              e = emptyAt.emplace(itemRule[item], emptyReduces[s].size()).first;
+              emptyReduces[s].push_back(EmptyReduce{itemRule[item], Bits(bits), {}});
+            }
+            EmptyReduce& er = emptyReduces[s][e->second];
+            er.spontaneous.merge(la[item]);
+            if (la[item].test(dummy)) {
+              er.spontaneous.reset(dummy);
+              er.from.push_back(from);
+            }
+            continue;
+          }
+          uint32_t to = kernelIndex(states[nextState(st, sym)], item + 1);
+          Bits l = la[item];
+          if (l.test(dummy)) {
+            l.reset(dummy);
+            passesTo[from].push_back(to);
+          }
+          lookahead[to].merge(l);
+        }
+      }
+    }
+
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      METRIC_ADD(followIterations, 1);
+      for (size_t from = 0; from < kernelItems; ++from) {
+        for (uint32_t to : passesTo[from]) changed |= lookahead[to].merge(lookahead[from]);
+      }
+    }
+  }
+
+  void computeFollow() {
+    size_t nts = names.size() - terminalCount;
+    follow.assign(nts, Bits(terminalCount + 1));
+    follow[0].set(terminalCount - 1);
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      METRIC_ADD(followIterations, 1);
+      for (const Rule& r : rules) {
+        for (size_t i = 0; i < r.rhs.size(); ++i) {
+          if (isTerminal(r.rhs[i])) continue;
+          Bits f(terminalCount + 1);
+          bool rest = firstOfRest(r.rhs, i + 1, f);
+          if (rest) f.merge(follow[ntIndex(r.lhs)]);
+          changed |= follow[ntIndex(r.rhs[i])].merge(f);
+        }
+      }
+    }
+  }
+
+  std::string ruleText(uint32_t r) const {
+    std::string s = names[rules[r].lhs] + " :";
+    for (int sym : rules[r].rhs) s += " " + names[sym];
+    if (rules[r].rhs.empty()) s += " epsilon";
+    return s;
+  }
+
+  void conflict(size_t state, int terminal, int32_t existing, uint32_t rule) {
+    conflictCount++;
+    METRIC_ADD(tableConflicts, 1);
+    std::string kind = existing == LR_ACCEPT ? "accept / reduce" : existing > 0 ? "shift / reduce" : "reduce / reduce";
+    std::string kept = existing == LR_ACCEPT ? "the accept"
+                       : existing > 0        ? "the shift"
+                                             : ruleText((uint32_t)(-existing - 1));
+    std::string msg = std::string("Warning: ") + (mode == Mode::LALR ? "LALR(1)" : "SLR(1)") + " " + kind +
+                      " conflict in state " + std::to_string(state) + " on '" + names[terminal] + "': keeping " +
+                      kept + " over " + ruleText(rule) + ".\n";
+    std::cerr << msg;
+    messages.push_back(msg);
+  }
+
+  void reduce(std::vector<int32_t>& row, size_t state, const Bits& on, uint32_t rule) {
+    on.forEach([&](size_t t) {
+      if ((int)t >= terminalCount) return;
+      int32_t& a = row[t];
+      if (rule == 0) { // start' : start .  on $, the first rule so it wins over a reduction
+        if (a < 0) {
+          conflict(state, (int)t, LR_ACCEPT, (uint32_t)(-a - 1));
+          dropped.push_back({(uint32_t)t, a});
+        }
+        a = LR_ACCEPT;
+      } else if (a == LR_ACCEPT) {
+        conflict(state, (int)t, a, rule);
+        dropped.push_back({(uint32_t)t, -(int32_t)rule - 1});
+      } else if (a == 0) {
+        a = -(int32_t)rule - 1;
+      } else if (a > 0) {
+        conflict(state, (int)t, a, rule); // shift wins
+        dropped.push_back({(uint32_t)t, -(int32_t)rule - 1});
+      } else if (a < 0) {
+        conflict(state, (int)t, a, rule);
+        if ((uint32_t)(-a - 1) > rule) { // earlier rule wins
+          dropped.push_back({(uint32_t)t, a});
+          a = -(int32_t)rule - 1;
+        } else {
+          dropped.push_back({(uint32_t)t, -(int32_t)rule - 1});
+        }
+      }
+    });
+  }
+
+  void buildActions() {
+    size_t nts = names.size() - terminalCount;
+    size_t stride = terminalCount + 1;
+    table = LRTable();
+    table.terminals.assign(names.begin(), names.begin() + terminalCount);
+    table.nonTerminals.assign(names.begin() + terminalCount, names.end());
+    for (uint32_t r = 0; r < rules.size(); ++r) {
+      table.productions.push_back({ntIndex(rules[r].lhs), (uint32_t)rules[r].rhs.size()});
+      table.productionText.push_back(ruleText(r));
+    }
+    table.states = states.size();
+
+    std::map<std::vector<int32_t>, uint32_t> actionRows, gotoRows;
+    std::vector<uint32_t> stamp(nts, 0);
+    std::vector<uint32_t> extraBegin;
+    for (size_t s = 0; s < states.size(); ++s) {
+      const State& st = states[s];
+      dropped.clear();
+      std::vector<int32_t> row(stride, 0), gotoRow(nts, -1);
+      for (const auto& n : st.next) {
+        if (isTerminal(n.first)) row[n.first] = n.second + 1;
+        else gotoRow[ntIndex(n.first)] = n.second;
+      }
+      for (uint32_t k = 0; k < st.kernel.size(); ++k) {
+        uint32_t item = st.kernel[k];
+        if (symbolAfterDot(item) >= 0) continue;
+        uint32_t r = itemRule[item];
+        reduce(row, s, mode == Mode::LALR ? lookahead[st.kernelBase + k] : follow[ntIndex(rules[r].lhs)], r);
+      }
+      if (mode == Mode::LALR) {
+        for (const EmptyReduce& er : emptyReduces[s]) {
+          Bits on = er.spontaneous;
+          for (uint32_t from : er.from) on.merge(lookahead[from]);
+          reduce(row, s, on, er.rule);
+        }
+      } else {
+        for (int nt : closedNonTerminals(st.kernel, stamp, (uint32_t)s + 1)) {
+          for (uint32_t r : rulesOf[ntIndex(nt)]) {
+            if (rules[r].rhs.empty()) reduce(row, s, follow[ntIndex(nt)], r);
+          }
+        }
+      }
+
+      // default reduction: the most common one, its entries are dropped
+      std::map<int32_t, size_t> counts;
+      for (int32_t a : row) {
+        if (a < 0) counts[a]++;
+      }
+      int32_t best = 0;
+      size_t bestCount = 0;
+      for (const auto& c : counts) {
+        if (c.second > bestCount) {
+          best = c.first;
+          bestCount = c.second;
+        }
+      }
+      table.defaultReduce.push_back(best ? -best - 1 : -1);
+      if (best) std::replace(row.begin(), row.end(), best, 0);
+
+      auto a = actionRows.emplace(row, (uint32_t)actionRows.size());
+      if (a.second) table.actions.insert(table.actions.end(), row.begin(), row.end());
+      table.actionRow.push_back(a.first->second);
+      auto g = gotoRows.emplace(gotoRow, (uint32_t)gotoRows.size());
+      if (g.second) table.gotos.insert(table.gotos.end(), gotoRow.begin(), gotoRow.end());
+      table.gotoRow.push_back(g.first->second);
+
+      extraBegin.push_back((uint32_t)table.extra.size());
+      std::sort(dropped.begin(), dropped.end(), [](const LRTable::ExtraAction& x, const LRTable::ExtraAction& y) {
+        return x.column < y.column;
+      });
+      table.extra.insert(table.extra.end(), dropped.begin(), dropped.end());
+    }
+    if (!table.extra.empty()) {
+      extraBegin.push_back((uint32_t)table.extra.size());
+      table.extraBegin = std::move(extraBegin);
+    }
+    METRIC_ADD(tableEntries, table.actions.size() + table.gotos.size());
+  }
+};
+
+#endif // LR_TABLE_GEN_H
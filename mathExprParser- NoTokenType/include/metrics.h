@@ -0,0 +1,237 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <cstdint>
+#include <ctime>
+
+// Process wide counters, gauges and per phase timers for the lexer, the table
+// generator and the parsers. compile with -DPARSER_NO_METRICS and every
+// METRIC_* macro expands to nothing (no atomics, no clock reads).
+//
+// hot loops count into locals / members and publish once (METRIC_ADD at the
+// end of a parse or input), so the shared atomics see a handful of adds per
+// parse, not one per token.
+//
+//   METRIC_ADD(lexTokens, n);         counter += n
+//   METRIC_MAX(maxStackDepth, d);     gauge = max(gauge, d)
+//   METRIC_ONLY(steps++);             statement only compiled with metrics on
+//   METRIC_PHASE("lex");              wall + cpu time until the end of the scope
+//
+// ParserMetrics::global().toJson() / toPrometheus() dump everything.
+
+// name, exported name, help text
+#define PARSER_COUNTERS(X) \
+  X(lexBytes, "lex_bytes", "Input bytes scanned by the lexer") \
+  X(lexTokens, "lex_tokens", "Tokens produced by the lexer") \
+  X(keywordHits, "lex_keyword_hits", "Identifiers that were keywords") \
+  X(firstIterations, "first_iterations", "Passes of the FIRST set fixed point") \
+  X(followIterations, "follow_iterations", "Passes of the FOLLOW set fixed point") \
+  X(tableEntries, "table_entries", "Cells in the generated parse tables") \
+  X(tableConflicts, "table_conflicts", "LL(1) conflicts found while generating tables") \
+  X(parserSteps, "parser_steps", "Parse loop iterations (matches + expansions)") \
+  X(productionsExpanded, "productions_expanded", "Non-terminals replaced by a production") \
+  X(parses, "parses", "Parses run (accepted or not)")
+
+#define PARSER_GAUGES(X) \
+  X(maxStackDepth, "max_stack_depth", "Deepest parse stack seen")
+
+class ParserMetrics {
+public:
+  struct Phase {
+    double wallSeconds = 0;
+    double cpuSeconds = 0;  // process cpu time, so worker threads count too
+    uint64_t calls = 0;
+  };
+
+#define PARSER_METRIC_FIELD(field, name, help) std::atomic<uint64_t> field{0};
+  PARSER_COUNTERS(PARSER_METRIC_FIELD)
+  PARSER_GAUGES(PARSER_METRIC_FIELD)
+#undef PARSER_METRIC_FIELD
+
+  static ParserMetrics& global() {
+    static ParserMetrics m;
+    return m;
+  }
+
+  static void raiseMax(std::atomic<uint64_t>& gauge, uint64_t v) {
+    uint64_t cur = gauge.load(std::memory_order_relaxed);
+    while (v > cur && !gauge.compare_exchange_weak(cur, v, std::memory_order_relaxed)) {}
+  }
+
+  void addPhase(const std::string& name, double wall, double cpu) {
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    Phase& p = phases[name];
+    p.wallSeconds += wall;
+    p.cpuSeconds += cpu;
+    p.calls++;
+  }
+
+  std::map<std::string, Phase> getPhases() const {
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    return phases;
+  }
+
+  void reset() {
+#define PARSER_METRIC_RESET(field, name, help) field = 0;
+    PARSER_COUNTERS(PARSER_METRIC_RESET)
+    PARSER_GAUGES(PARSER_METRIC_RESET)
+#undef PARSER_METRIC_RESET
+    std::lock_guard<std::mutex> lock(phaseMutex);
+    phases.clear();
+  }
+
+  // {"counters": {...}, "gauges": {...}, "phases": {"lex": {"wall_ms": .., "cpu_ms": .., "calls": ..}}}
+  std::string toJson() const {
+    std::ostringstream out;
+    out << "{\"counters\": {";
+    const char* sep = "";
+#define PARSER_METRIC_JSON(field, name, help) \
+    out << sep << "\"" << name << "\": " << field.load(); \
+    sep = ", ";
+    PARSER_COUNTERS(PARSER_METRIC_JSON)
+    out << "}, \"gauges\": {";
+    sep = "";
+    PARSER_GAUGES(PARSER_METRIC_JSON)
+#undef PARSER_METRIC_JSON
+    out << "}, \"phases\": {";
+    sep = "";
+    for (const auto& p : getPhases()) {
+      out << sep << "\"" << p.first << "\": {\"wall_ms\": " << p.second.wallSeconds * 1e3
+          << ", \"cpu_ms\": " << p.second.cpuSeconds * 1e3 << ", \"calls\": " << p.second.calls << "}";
+      sep = ", ";
+    }
+    out << "}}";
+    return out.str();
+  }
+
+  // Prometheus text exposition format, everything prefixed with parser_
+  std::string toPrometheus() const {
+    std::ostringstream out;
+#define PARSER_METRIC_PROM_COUNTER(field, name, help) \
+    out << "# HELP parser_" << name << "_total " << help << "\n# TYPE parser_" << name \
+        << "_total counter\nparser_" << name << "_total " << field.load() << "\n";
+#define PARSER_METRIC_PROM_GAUGE(field, name, help) \
+    out << "# HELP parser_" << name << " " << help << "\n# TYPE parser_" << name \
+        << " gauge\nparser_" << name << " " << field.load() << "\n";
+    PARSER_COUNTERS(PARSER_METRIC_PROM_COUNTER)
+    PARSER_GAUGES(PARSER_METRIC_PROM_GAUGE)
+#undef PARSER_METRIC_PROM_COUNTER
+#undef PARSER_METRIC_PROM_GAUGE
+    std::map<std::string, Phase> ph = getPhases();
+    const char* series[][2] = {
+      {"phase_wall_seconds_total", "Wall time spent in each phase"},
+      {"phase_cpu_seconds_total", "Process CPU time spent in each phase"},
+      {"phase_calls_total", "Times each phase ran"},
+    };
+    for (int s = 0; s < 3; ++s) {
+      out << "# HELP parser_" << series[s][0] << " " << series[s][1] << "\n# TYPE parser_"
+          << series[s][0] << " counter\n";
+      for (const auto& p : ph) {
+        out << "parser_" << series[s][0] << "{phase=\"" << p.first << "\"} ";
+        if (s == 0) out << p.second.wallSeconds;
+        else if (s == 1) out << p.second.cpuSeconds;
+        else out << p.second.calls;
+        out << "\n";
+      }
+    }
+    return out.str();
+  }
+
+  // one line, "read 0.02 ms, lex 0.01 ms, ..." in phase name order
+  std::string phaseSummary() const {
+    std::ostringstream out;
+    const char* sep = "";
+    for (const auto& p : getPhases()) {
+      out << sep << p.first << " " << p.second.wallSeconds * 1e3 << " ms";
+      sep = ", ";
+    }
+    return out.str();
+  }
+
+private:
+  mutable std::mutex phaseMutex;
+  std::map<std::string, Phase> phases;
+};
+
+// times a scope (or until stop()) into the named phase, an empty shell with PARSER_NO_METRICS
+class PhaseTimer {
+public:
+#ifndef PARSER_NO_METRICS
+  explicit PhaseTimer(const std::string& phaseName)
+    : name(phaseName), wallStart(std::chrono::steady_clock::now()), cpuStart(cpuNow()) {}
+
+  ~PhaseTimer() { stop(); }
+
+  void stop() {
+    if (stopped) return;
+    stopped = true;
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    ParserMetrics::global().addPhase(name, wall, cpuNow() - cpuStart);
+  }
+#else
+  explicit PhaseTimer(const std::string&) {}
+  void stop() {}
+#endif
+
+private:
+#ifndef PARSER_NO_METRICS
+  std::string name;
+  std::chrono::steady_clock::time_point wallStart;
+  double cpuStart;
+  bool stopped = false;
+#endif
+
+  static double cpuNow() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+  }
+};
+
+// per parse tallies, published when the parse ends (whichever return it takes)
+struct ParseCounters {
+  uint64_t steps = 0;
+  uint64_t expansions = 0;
+  uint64_t maxDepth = 0;
+
+  void depth(uint64_t d) {
+    if (d > maxDepth) maxDepth = d;
+  }
+
+  void publish(); // adds to the global counters and zeroes these
+  ~ParseCounters() { publish(); }
+};
+
+#define PARSER_METRIC_CONCAT2(a, b) a##b
+#define PARSER_METRIC_CONCAT(a, b) PARSER_METRIC_CONCAT2(a, b)
+
+#ifndef PARSER_NO_METRICS
+#define METRIC_ADD(field, n) ParserMetrics::global().field.fetch_add((n), std::memory_order_relaxed)
+#define METRIC_MAX(field, v) ParserMetrics::raiseMax(ParserMetrics::global().field, (v))
+#define METRIC_ONLY(stmt) stmt
+#define METRIC_PHASE(name) PhaseTimer PARSER_METRIC_CONCAT(phaseTimer_, __LINE__)(name)
+#define PARSER_METRICS_ENABLED 1
+#else
+#define METRIC_ADD(field, n) ((void)0)
+#define METRIC_MAX(field, v) ((void)0)
+#define METRIC_ONLY(stmt)
+#define METRIC_PHASE(name) ((void)0)
+#define PARSER_METRICS_ENABLED 0
+#endif
+
+inline void ParseCounters::publish() {
+  if (steps == 0) return; // nothing since the last publish
+  METRIC_ADD(parserSteps, steps);
+  METRIC_ADD(productionsExpanded, expansions);
+  METRIC_MAX(maxStackDepth, maxDepth);
+  METRIC_ADD(parses, 1);
+  steps = expansions = maxDepth = 0;
+}
+
+#endif // METRICS_H
@@ -0,0 +1,174 @@
+#ifndef NUMBER_LITERAL_H
+#define NUMBER_LITERAL_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <charconv>
+#include <string>
+
+// Numeric literals decoded while the lexer scans them, so NUMBER tokens carry
+// their value and nobody calls stod on the lexeme later. used by both trees'
+// lexers (simple_math_expr_parser-A6 includes it from here).
+//
+//   digits [ . [digits] ] [ (e|E) [+|-] digits ]
+//
+// digits are taken 8 at a time with SWAR (one 64 bit load, a digit check and
+// three multiplies). a float whose digits fit 53 bits with a power of ten up
+// to 1e22 is exact in a double, so one multiply or divide rounds it correctly
+// (Clinger's fast path). anything else goes to std::from_chars, which is
+// correctly rounded (libstdc++ 12+ and MSVC do it with Eisel-Lemire).
+// integers that don't fit int64_t become floats.
+
+struct NumberValue {
+  bool isFloat = false;
+  union {
+    int64_t intValue = 0;
+    double floatValue;
+  };
+
+  double asDouble() const { return isFloat ? floatValue : (double)intValue; }
+};
+
+namespace number_literal {
+
+inline bool isDigit(char c) { return (unsigned char)(c - '0') < 10; }
+
+// all 8 bytes of v are '0'..'9'
+inline bool isEightDigits(uint64_t v) {
+  return (((v & 0xF0F0F0F0F0F0F0F0ull) |
+           (((v + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) >> 4)) == 0x3333333333333333ull);
+}
+
+// value of 8 ascii digits loaded little endian (first digit in the low byte)
+inline uint32_t parseEightDigits(uint64_t v) {
+  v -= 0x3030303030303030ull;
+  v = (v * 10) + (v >> 8);                                             // pairs
+  v = (((v & 0x000000FF000000FFull) * 0x000F424000000064ull) +         // 100, 1000000
+       (((v >> 16) & 0x000000FF000000FFull) * 0x0000271000000001ull)) >> 32; // 1, 10000
+  return (uint32_t)v;
+}
+
+// Adds the digit run at p to mant while it fits, returns the end of the run.
+// digits that no longer fit are counted in dropped (nonzero ones set inexact)
+inline const char* accumulateDigits(const char* p, const char* end, uint64_t& mant,
+                                    int64_t& dropped, bool& inexact) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  while (end - p >= 8 && mant < 100000000000ull) { // mant * 1e8 + 99999999 still fits
+    uint64_t v;
+    std::memcpy(&v, p, 8);
+    if (!isEightDigits(v)) break;
+    mant = mant * 100000000 + parseEightDigits(v);
+    p += 8;
+  }
+#endif
+  for (; p < end && isDigit(*p); ++p) {
+    unsigned d = *p - '0';
+    if (mant <= (UINT64_MAX - 9) / 10) {
+      mant = mant * 10 + d;
+    } else {
+      dropped++;
+      if (d) inexact = true;
+    }
+  }
+  return p;
+}
+
+// value of a float literal from its text (slow path)
+inline double slowParse(const char* start, const char* end, int64_t exp10) {
+  double d = 0;
+#if defined(__cpp_lib_to_chars) || (defined(__GNUC__) && __GNUC__ >= 11)
+  auto r = std::from_chars(start, end, d);
+  if (r.ec == std::errc::result_out_of_range) d = exp10 > 0 ? HUGE_VAL : 0.0;
+#else
+  d = std::strtod(std::string(start, end).c_str(), nullptr);
+#endif
+  return d;
+}
+
+inline double pow10Exact(int e) {
+  static const double table[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+  };
+  return table[e];
+}
+
+// mant * 10^exp10 rounded to a double, start..end is the literal for the slow path
+inline double toDouble(uint64_t mant, int64_t exp10, bool inexact, const char* start, const char* end) {
+  if (mant == 0) return 0.0;
+  if (!inexact && mant <= (1ull << 53) && exp10 >= -22 && exp10 <= 22) {
+    double m = (double)mant;
+    return exp10 < 0 ? m / pow10Exact((int)-exp10) : m * pow10Exact((int)exp10);
+  }
+  return slowParse(start, end, exp10);
+}
+
+} // namespace number_literal
+
+// Scans a plain integer literal (digits only) at p, *p must be a digit.
+// returns the number of chars used
+inline size_t scanIntegerLiteral(const char* p, const char* end, NumberValue& out) {
+  using namespace number_literal;
+  uint64_t mant = 0;
+  int64_t dropped = 0;
+  bool inexact = false;
+  const char* stop = accumulateDigits(p, end, mant, dropped, inexact);
+  if (dropped == 0 && mant <= (uint64_t)INT64_MAX) {
+    out.isFloat = false;
+    out.intValue = (int64_t)mant;
+  } else {
+    out.isFloat = true;
+    out.floatValue = toDouble(mant, dropped, inexact, p, stop);
+  }
+  return stop - p;
+}
+
+// Scans digits [. [digits]] [(e|E) [+|-] digits] at p, *p must be a digit.
+// an e not followed by digits is left for the next token. returns the chars used
+inline size_t scanNumberLiteral(const char* p, const char* end, NumberValue& out) {
+  using namespace number_literal;
+  const char* start = p;
+  uint64_t mant = 0;
+  int64_t dropped = 0;
+  bool inexact = false;
+  bool isFloat = false;
+
+  p = accumulateDigits(p, end, mant, dropped, inexact);
+  int64_t exp10 = dropped; // integer digits that didn't fit still scale the value
+
+  if (p < end && *p == '.') {
+    isFloat = true;
+    const char* frac = ++p;
+    int64_t fracDropped = 0;
+    p = accumulateDigits(p, end, mant, fracDropped, inexact);
+    exp10 -= (p - frac) - fracDropped;
+  }
+
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char* q = p + 1;
+    bool negative = false;
+    if (q < end && (*q == '+' || *q == '-')) negative = *q++ == '-';
+    if (q < end && isDigit(*q)) {
+      int64_t e = 0;
+      for (; q < end && isDigit(*q); ++q) {
+        if (e < 100000) e = e * 10 + (*q - '0'); // far past any double either way
+      }
+      exp10 += negative ? -e : e;
+      isFloat = true;
+      p = q;
+    }
+  }
+
+  if (!isFloat && exp10 == 0 && mant <= (uint64_t)INT64_MAX) {
+    out.isFloat = false;
+    out.intValue = (int64_t)mant;
+  } else {
+    out.isFloat = true;
+    out.floatValue = toDouble(mant, exp10, inexact, start, p);
+  }
+  return p - start;
+}
+
+#endif // NUMBER_LITERAL_H
@@ -0,0 +1,475 @@
+#ifndef PARSE_SERVER_H
+#define PARSE_SERVER_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <map>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "lexer.h"
+#include "LL1_push_parser.h"
+#include "parse_table_gen.h"
+#include "metrics.h"
+
+// Resident parse server: grammars are loaded + their tables generated once,
+// then requests come in over a Unix domain socket.
+//
+// Request, one per line:
+//   PARSE <grammar> <text>     -> OK <tokens>          | ERR <message>
+//   TREE <grammar> <text>      -> OK <tokens> <tree>   | ERR <message>
+//   PING                       -> OK PONG
+//   METRICS                    -> OK <ParserMetrics JSON>
+// or length-prefixed, for texts with newlines in them:
+//   #<n>\n<n bytes: same command as above>   -> #<n>\n<response>
+// <tree> is the parse tree as an s-expression, see LL1PushParser::setTreeOutput.
+// responses on a connection come back in request order, clients may pipeline.
+// a line (or frame header) over 1 MiB or a bad frame header gets an ERR after
+// the responses before it, then the connection is closed.
+//
+// one epoll thread accepts and reads, complete requests go to a fixed pool of
+// workers. a worker writes its response itself when it is the next one due on
+// its connection, only a full socket buffer goes back through the epoll thread.
+
+struct LoadedGrammar {
+  ParseTable table;
+  std::set<std::string> terminals;
+  std::set<std::string> nonTerminals;
+  std::string startSymbol;
+};
+
+class ParseServer {
+private:
+  struct Connection {
+    int fd;
+    std::string in;                   // bytes read, not yet a full request (epoll thread only)
+    size_t nextSeq = 0;               // sequence number of the next request (epoll thread only)
+    std::mutex m;                     // guards everything below
+    size_t sendSeq = 0;               // next response due
+    std::map<size_t, std::string> ready; // finished responses waiting for an earlier one
+    std::string out;                  // due, not written yet (socket was full)
+    bool waitingWritable = false;     // EPOLLOUT armed
+
+    explicit Connection(int f) : fd(f) {}
+    ~Connection() { ::close(fd); }    // last reference gone, no worker can still write
+  };
+
+  struct Job {
+    std::shared_ptr<Connection> conn;
+    size_t seq;
+    bool framed;                      // reply length-prefixed
+    std::string request;
+  };
+
+  std::string socketPath;
+  size_t workerCount;
+  std::map<std::string, LoadedGrammar> grammars;
+
+  int listenFd = -1;
+  int epollFd = -1;
+  int wakeFd = -1;                    // eventfd: stop() and "arm EPOLLOUT" requests
+  std::atomic<bool> stopping{false};
+  std::map<int, std::shared_ptr<Connection>> connections;
+
+  std::mutex jobMutex;
+  std::condition_variable jobReady;
+  std::deque<Job> jobs;
+  std::vector<std::thread> workers;
+
+  std::mutex blockedMutex;
+  std::vector<std::shared_ptr<Connection>> blocked; // need EPOLLOUT
+
+  std::atomic<uint64_t> served{0};
+
+  static const size_t maxLine = 1 << 20; // an unframed request or a frame header
+
+  static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+  }
+
+  // one line of text, no embedded newlines (unframed responses)
+  static std::string oneLine(std::string s) {
+    while (!s.empty() && (s.back() == '\n' || s.back() == '\r')) s.pop_back();
+    for (char& c : s) {
+      if (c == '\n' || c == '\r') c = ' ';
+    }
+    return s;
+  }
+
+  // ---- workers ----
+
+  struct WorkerState {
+    std::pmr::unsynchronized_pool_resource heap; // this worker's parse stacks, outlives the parsers
+    Lexer lexer{""};
+    std::map<std::string, std::unique_ptr<LL1PushParser>> parsers; // one per grammar
+    std::string tree;
+  };
+
+  std::string handle(const std::string& request, WorkerState& ws) const {
+    size_t cmdEnd = request.find(' ');
+    std::string cmd = request.substr(0, cmdEnd);
+    if (cmd == "PING") return "OK PONG";
+    if (cmd == "METRICS") return "OK " + ParserMetrics::global().toJson();
+    if (cmd != "PARSE" && cmd != "TREE") return "ERR Unknown command: " + cmd;
+    if (cmdEnd == std::string::npos) return "ERR Missing grammar name";
+
+    size_t nameEnd = request.find(' ', cmdEnd + 1);
+    std::string name = request.substr(cmdEnd + 1, nameEnd == std::string::npos ? std::string::npos : nameEnd - cmdEnd - 1);
+    auto g = grammars.find(name);
+    if (g == grammars.end()) return "ERR Unknown grammar: " + name;
+
+    auto& slot = ws.parsers[name];
+    if (!slot) {
+      slot.reset(new LL1PushParser(g->second.table, g->second.terminals,
+                                   g->second.nonTerminals, g->second.startSymbol, &ws.heap));
+      slot->setErrorStream(nullptr);
+    }
+    LL1PushParser& parser = *slot;
+    parser.reset();
+    parser.setTreeOutput(cmd == "TREE" ? &ws.tree : nullptr);
+
+    // lexer works on its own copy, the text is usually a few bytes
+    ws.lexer.reset(nameEnd == std::string::npos ? std::string() : request.substr(nameEnd + 1));
+    try {
+      Token token;
+      while (ws.lexer.next(token)) {
+        if (!parser.feed(token)) break;
+      }
+    } catch (const std::exception& e) {
+      return std::string("ERR Lexer Error: ") + e.what();
+    }
+    if (!parser.finish()) return "ERR " + parser.getError();
+    std::string resp = "OK " + std::to_string(parser.tokensConsumed() - 1); // minus the EOF
+    if (cmd == "TREE") resp += " " + ws.tree;
+    return resp;
+  }
+
+  // queue the response and write out whatever is due on this connection
+  void respond(Job& job, std::string resp) {
+    if (job.framed) resp = "#" + std::to_string(resp.size()) + "\n" + resp;
+    else resp = oneLine(std::move(resp)) + "\n";
+
+    Connection& c = *job.conn;
+    std::lock_guard<std::mutex> lock(c.m);
+    c.ready[job.seq] = std::move(resp);
+    for (auto it = c.ready.begin(); it != c.ready.end() && it->first == c.sendSeq; it = c.ready.erase(it)) {
+      c.out += it->second;
+      c.sendSeq++;
+    }
+    if (!c.waitingWritable && flush(c)) {
+      // socket full, let the epoll thread wait for it
+      c.waitingWritable = true;
+      {
+        std::lock_guard<std::mutex> b(blockedMutex);
+        blocked.push_back(job.conn);
+      }
+      wake();
+    }
+  }
+
+  // writes c.out (c.m held), returns true if some of it is still left
+  static bool flush(Connection& c) {
+    size_t done = 0;
+    while (done < c.out.size()) {
+      ssize_t n = ::send(c.fd, c.out.data() + done, c.out.size() - done, MSG_NOSIGNAL);
+      if (n > 0) {
+        done += n;
+        continue;
+      }
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+      done = c.out.size(); // peer gone, drop the output
+    }
+    c.out.erase(0, done);
+    return !c.out.empty();
+  }
+
+  void workerLoop() {
+    WorkerState ws;
+    while (true) {
+      Job job;
+      {
+        std::unique_lock<std::mutex> lock(jobMutex);
+        jobReady.wait(lock, [&]() { return !jobs.empty() || stopping.load(); });
+        if (jobs.empty()) return;
+        job = std::move(jobs.front());
+        jobs.pop_front();
+      }
+      respond(job, handle(job.request, ws));
+      served.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // ---- epoll thread ----
+
+  void wake() {
+    uint64_t one = 1;
+    ssize_t n = ::write(wakeFd, &one, sizeof(one));
+    (void)n;
+  }
+
+  void closeConnection(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    connections.erase(fd); // fd itself closes once queued jobs are done with it
+  }
+
+  void acceptAll() {
+    while (true) {
+      int fd = ::accept(listenFd, nullptr, nullptr);
+      if (fd < 0) return; // EAGAIN, or an error we can't do anything about
+      setNonBlocking(fd);
+      epoll_event ev{};
+      ev.events = EPOLLIN | EPOLLRDHUP;
+      ev.data.fd = fd;
+      if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        ::close(fd);
+        continue;
+      }
+      connections[fd] = std::make_shared<Connection>(fd);
+    }
+  }
+
+  // cuts complete requests off the front of c.in, returns false (with the
+  // reply in error) on a bad frame or a line longer than maxLine
+  bool extractRequests(const std::shared_ptr<Connection>& c, std::vector<Job>& out, std::string& error) {
+    std::string& in = c->in;
+    size_t pos = 0;
+    bool ok = true;
+    while (pos < in.size()) {
+      size_t nl = in.find('\n', pos);
+      if ((nl == std::string::npos ? in.size() : nl) - pos > maxLine) {
+        error = "ERR Request line longer than " + std::to_string(maxLine) + " bytes, send it as a #<n> frame";
+        ok = false;
+        break;
+      }
+      if (nl == std::string::npos) break;
+      if (in[pos] == '#') {
+        size_t len = 0;
+        for (size_t i = pos + 1; i < nl && ok; ++i) {
+          if (in[i] < '0' || in[i] > '9' || len > (64u << 20)) ok = false;
+          len = len * 10 + (in[i] - '0');
+        }
+        if (!ok) {
+          error = "ERR Bad frame header";
+          break;
+        }
+        if (in.size() - (nl + 1) < len) break; // rest of the payload not here yet
+        out.push_back({c, c->nextSeq++, true, in.substr(nl + 1, len)});
+        pos = nl + 1 + len;
+      } else {
+        size_t end = nl;
+        if (end > pos && in[end - 1] == '\r') end--;
+        if (end > pos) out.push_back({c, c->nextSeq++, false, in.substr(pos, end - pos)});
+        pos = nl + 1;
+      }
+    }
+    in.erase(0, pos);
+    return ok;
+  }
+
+  void readFrom(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+    std::shared_ptr<Connection> c = it->second;
+
+    // requests are cut off after every read, so c.in never holds much more
+    // than one maxLine line or frame
+    char buf[1 << 16];
+    std::vector<Job> batch;
+    std::string error;
+    bool closed = false;
+    while (true) {
+      ssize_t n = ::read(fd, buf, sizeof(buf));
+      if (n > 0) {
+        c->in.append(buf, n);
+        if (!extractRequests(c, batch, error)) break;
+        continue;
+      }
+      if (n < 0 && errno == EINTR) continue;
+      if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) closed = true;
+      break;
+    }
+
+    if (!batch.empty()) {
+      std::lock_guard<std::mutex> lock(jobMutex);
+      for (auto& j : batch) jobs.push_back(std::move(j));
+    }
+    if (batch.size() == 1) jobReady.notify_one();
+    else if (!batch.empty()) jobReady.notify_all();
+
+    if (!error.empty()) {
+      // the error goes out after the responses to the requests before it,
+      // the fd closes when the last of those is written
+      std::cerr << "Connection " << fd << ": " << error.substr(4) << ", closing it.\n";
+      Job last{c, c->nextSeq++, false, ""};
+      respond(last, error);
+      closeConnection(fd);
+      return;
+    }
+    if (closed) closeConnection(fd); // queued responses are dropped quietly
+  }
+
+  void writeTo(int fd) {
+    auto it = connections.find(fd);
+    if (it == connections.end()) return;
+    Connection& c = *it->second;
+    std::lock_guard<std::mutex> lock(c.m);
+    if (flush(c)) return; // still full, keep waiting
+    c.waitingWritable = false;
+    epoll_event ev{};
+    ev.events = EPOLLIN | EPOLLRDHUP;
+    ev.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+  }
+
+  void armBlocked() {
+    uint64_t count;
+    ssize_t n = ::read(wakeFd, &count, sizeof(count));
+    (void)n;
+    std::vector<std::shared_ptr<Connection>> list;
+    {
+      std::lock_guard<std::mutex> lock(blockedMutex);
+      list.swap(blocked);
+    }
+    for (auto& c : list) {
+      if (!connections.count(c->fd)) continue; // closed meanwhile
+      epoll_event ev{};
+      ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP;
+      ev.data.fd = c->fd;
+      epoll_ctl(epollFd, EPOLL_CTL_MOD, c->fd, &ev);
+    }
+  }
+
+public:
+  ParseServer(const std::string& path, size_t threads)
+    : socketPath(path), workerCount(threads ? threads : 1) {}
+
+  ~ParseServer() {
+    stop();
+    jobReady.notify_all();
+    for (auto& t : workers) {
+      if (t.joinable()) t.join();
+    }
+    connections.clear();
+    if (listenFd >= 0) {
+      ::close(listenFd);
+      ::unlink(socketPath.c_str());
+    }
+    if (epollFd >= 0) ::close(epollFd);
+    if (wakeFd >= 0) ::close(wakeFd);
+  }
+
+  // Load a grammar file under name, generating its table. call before run()
+  bool addGrammar(const std::string& name, const std::string& file) {
+    ParseTableGenerator gen;
+    std::streambuf* coutBuf = std::cout.rdbuf(nullptr); // the generator prints its tables
+    bool loaded = gen.loadGrammar(file);
+    if (loaded) gen.generateTable();
+    std::cout.rdbuf(coutBuf);
+    if (!loaded) {
+      std::cerr << "Failed to load grammar " << name << " from " << file << "\n";
+      return false;
+    }
+    LoadedGrammar& g = grammars[name];
+    g.table = gen.getParseTable();
+    g.terminals = gen.getTerminals();
+    g.nonTerminals = gen.getNonTerminals();
+    g.startSymbol = gen.getStartSymbol();
+    return true;
+  }
+
+  const std::map<std::string, LoadedGrammar>& getGrammars() const {
+    return grammars;
+  }
+
+  // Bind the socket (replacing a stale one) and start the workers
+  bool start() {
+    if (socketPath.size() >= sizeof(sockaddr_un::sun_path)) {
+      std::cerr << "Socket path too long: " << socketPath << "\n";
+      return false;
+    }
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strcpy(addr.sun_path, socketPath.c_str());
+    ::unlink(socketPath.c_str());
+    if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+        ::listen(listenFd, SOMAXCONN) < 0 || !setNonBlocking(listenFd)) {
+      std::cerr << "Could not listen on " << socketPath << ": " << std::strerror(errno) << "\n";
+      return false;
+    }
+
+    epollFd = epoll_create1(0);
+    wakeFd = eventfd(0, EFD_NONBLOCK);
+    if (epollFd < 0 || wakeFd < 0) {
+      std::cerr << "epoll / eventfd setup failed: " << std::strerror(errno) << "\n";
+      return false;
+    }
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    ev.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+
+    for (size_t i = 0; i < workerCount; ++i) {
+      workers.emplace_back([this]() { workerLoop(); });
+    }
+    return true;
+  }
+
+  // Event loop, returns after stop()
+  void run() {
+    epoll_event events[64];
+    while (!stopping.load()) {
+      int n = epoll_wait(epollFd, events, 64, -1);
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        std::cerr << "epoll_wait failed: " << std::strerror(errno) << "\n";
+        break;
+      }
+      for (int i = 0; i < n; ++i) {
+        int fd = events[i].data.fd;
+        uint32_t e = events[i].events;
+        if (fd == listenFd) acceptAll();
+        else if (fd == wakeFd) armBlocked();
+        else {
+          if (e & EPOLLOUT) writeTo(fd);
+          if (e & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR)) readFrom(fd);
+        }
+      }
+    }
+    stopping = true;
+    jobReady.notify_all();
+  }
+
+  // Safe to call from a signal handler (only sets a flag and writes the eventfd)
+  void stop() {
+    stopping = true;
+    if (wakeFd >= 0) wake();
+  }
+
+  uint64_t requestsServed() const {
+    return served.load();
+  }
+
+  size_t workerThreads() const {
+    return workerCount;
+  }
+};
+
+#endif // PARSE_SERVER_H
@@ -8,18 +8,62 @@
 #include <map>
 #include <set>
 #include <string>
-#include "LL1_parser_ET.h" // for ParseTable and token types
+#include <algorithm>
+#include <memory_resource>
+#include "metrics.h"
+
+// same as in LL1_parser_ET.h / ll1_engine.h, this header is shared with the
+// enum typed tree and can't pull in either lexer
+using ParseTable = std::map<std::string, std::map<std::string, std::vector<std::string>>>;
+
+// one production added to (add) or removed from the loaded grammar
+struct GrammarEdit {
+  bool add;
+  std::string nt;
+  std::vector<std::string> body;
+};
+
+// what applyEdits() / reloadGrammar() changed
+struct TableUpdate {
+  std::vector<std::pair<std::string, std::string>> conflictsAdded;   // (nonterminal, terminal)
+  std::vector<std::pair<std::string, std::string>> conflictsRemoved;
+  size_t firstChanged = 0, followChanged = 0, rowsRebuilt = 0;
+  bool fullRebuild = false; // a symbol went from terminal to nonterminal or back, or the start symbol changed
+};
 
 class ParseTableGenerator {
 private:
-  std::map<std::string, std::set<std::string>> first;   // first sets
-  std::map<std::string, std::set<std::string>> follow;  // follow sets
+  // the set nodes (most of what generating allocates) come from the resource
+  // given to the constructor, e.g. a ParseArena dropped once the table is built
+  std::pmr::map<std::string, std::pmr::set<std::string>> first;   // first sets
+  std::pmr::map<std::string, std::pmr::set<std::string>> follow;  // follow sets
   std::map<std::string, std::vector<std::vector<std::string>>> prods; // productions
   ParseTable table; // parse table
   std::set<std::string> terms, nonterms; // terminals and non-terminals
   std::string startSymbol; // start symbol
+  bool verbose = true;     // print the sets and the table
+  std::map<std::string, std::set<std::string>> conflictCells; // nt -> terminals two productions claim
+
+  // for applyEdits: who depends on what, built on first use. only
+  // nonterminal occurrences are indexed
+  bool indexed = false;
+  std::map<std::string, std::map<std::string, int>> firstUsers; // X -> A with a production starting with X
+  std::map<std::string, std::map<std::string, int>> precededBy; // X -> B with an occurrence of "B X"
+  std::map<std::string, std::map<std::pair<std::string, std::string>, int>> uses; // B -> (lhs, next symbol, "" = last)
+  std::map<std::string, int> symbolUses;                        // right hand side occurrences of every symbol
+
+  // one update: the sets as they were before it first touched them, the
+  // (FIRST, FOLLOW) elements over-deleted, the rows to rebuild
+  enum SetKind { FIRST_SET, FOLLOW_SET };
+  using SetKey = std::pair<SetKind, std::string>;
+  std::map<SetKey, std::set<std::string>> before;
+  std::vector<std::pair<SetKey, std::string>> deleted;
+  std::set<std::string> dirtyRows;
 
 public:
+  explicit ParseTableGenerator(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+    : first(mr), follow(mr) {}
+
   // Load grammar from file (: is the separator)
   bool loadGrammar(const std::string& filename) {
     std::ifstream file(filename);
@@ -53,19 +97,14 @@ public:
     }
     file.close();
 
-    // finds terminals
-    for (const auto& rule : prods) { // Changed loop variable name for clarity
-      for (const auto& prod_vec : rule.second) { // Changed loop variable name for clarity
-        for (const auto& sym : prod_vec) { // Changed loop variable name for clarity
-          if (sym != "epsilon" && !nonterms.count(sym)) terms.insert(sym);
-        }
-      }
-    }
-    terms.insert("$"); // Add eof
-
+    classify();
     return true;
   }
 
+  // printing the sets and the table (on by default) is most of the time of
+  // a big grammar's generateTable
+  void setVerbose(bool on) { verbose = on; }
+
   // Compute first sets
   void computeFirst() {
     for (const auto& nt : nonterms) first[nt] = {}; // empties/intializes the first set for nonterminal nt
@@ -73,6 +112,7 @@ public:
     bool changed = true;
     while (changed) {
       changed = false;
+      METRIC_ADD(firstIterations, 1);
       for (const auto& rule : prods) { // Changed loop variable name for clarity
         const std::string& nt = rule.first;
         for (const auto& prod : rule.second) {
@@ -92,6 +132,7 @@ public:
       }
     }
 
+    if (!verbose) return;
     // Print first sets
     std::cout << "\nFirst Sets:\n";
     for (const auto& nt : first) {
@@ -113,6 +154,7 @@ public:
     bool changed = true;
     while (changed) {
       changed = false;
+      METRIC_ADD(followIterations, 1);
       for (const auto& rule : prods) { // Changed loop variable name for clarity
         const std::string& nt_lhs = rule.first; // Non-terminal on the left-hand side
         for (const auto& prod : rule.second) {
@@ -143,6 +185,7 @@ public:
       }
     }
 
+    if (!verbose) return;
     // Print follow sets
     std::cout << "\nFollow Sets:\n";
     for (const auto& nt : follow) {
@@ -157,49 +200,14 @@ public:
     computeFirst();
     computeFollow();
     table.clear(); // Ensure table is empty
+    conflictCells.clear();
+    indexed = false;
 
-    for (const auto& rule : prods) { // Changed loop variable name for clarity
-      const std::string& nt = rule.first;
-      for (const auto& prod : rule.second) {
-        std::set<std::string> firsts;
-        bool hasEpsilon = false;
-
-        if (prod.size() == 1 && prod[0] == "epsilon") {
-          hasEpsilon = true;
-        } else {
-          auto sym = prod[0];
-          if (terms.count(sym)) firsts.insert(sym);
-          else if (nonterms.count(sym)) {
-            for (const auto& t : first[sym]) {
-              if (t != "epsilon") firsts.insert(t);
-              else hasEpsilon = true; // If first symbol derives epsilon
-                                      // Note: Does not correctly handle productions with sequences like A -> BC where B derives epsilon
-            }
-          }
-        }
+    for (const auto& rule : prods) buildRow(rule.first, true);
 
-        // Add production for each terminal in first set
-        for (const auto& t : firsts) {
-            if (table.count(nt) && table.at(nt).count(t)) {
-                 std::cerr << "Warning: LL(1) conflict for '" << nt << "' on '" << t << "'. Overwriting.\n";
-            }
-            table[nt][t] = prod;
-        }
-
-        // If production can derive epsilon, add for follow set
-        if (hasEpsilon) {
-          if (follow.count(nt)) { // Check if follow set exists
-             for (const auto& t : follow[nt]) {
-                if (table.count(nt) && table.at(nt).count(t)) {
-                   std::cerr << "Warning: LL(1) conflict for '" << nt << "' on '" << t << "'. Overwriting with epsilon rule.\n";
-                }
-                table[nt][t] = prod;
-             }
-          }
-        }
-      }
-    }
+    METRIC_ONLY(for (const auto& row : table) METRIC_ADD(tableEntries, row.second.size());)
 
+    if (!verbose) return;
     // Print parse table
     std::cout << "\nParse Table:\n";
     for (const auto& nt_pair : table) { // Changed loop variable name for clarity
@@ -229,6 +237,546 @@ public:
   std::string getStartSymbol() const {
       return startSymbol;
   }
+
+  // productions as loaded (nonterminal -> list of right hand sides)
+  const std::map<std::string, std::vector<std::vector<std::string>>>& getProductions() const {
+      return prods;
+  }
+
+  // first / follow set of a nonterminal (empty if there is none)
+  std::set<std::string> getFirst(const std::string& nt) const {
+      auto it = first.find(nt);
+      return it == first.end() ? std::set<std::string>() : std::set<std::string>(it->second.begin(), it->second.end());
+  }
+  std::set<std::string> getFollow(const std::string& nt) const {
+      auto it = follow.find(nt);
+      return it == follow.end() ? std::set<std::string>() : std::set<std::string>(it->second.begin(), it->second.end());
+  }
+
+  // cells of the last table that more than one production claimed
+  const std::map<std::string, std::set<std::string>>& getConflicts() const {
+      return conflictCells;
+  }
+
+  // Applies production additions (appended to the nonterminal's list) and
+  // removals to a generated table, recomputing only what they reach:
+  //   - FIRST / FOLLOW elements: an added production's contributions are
+  //     pushed along the dependency index (firstUsers, precededBy, uses) as
+  //     long as they are new somewhere. a removed one's contributions are
+  //     deleted from everything they could have reached, then put back where
+  //     another derivation still gives them (delete and rederive, so support
+  //     that only went around a cycle doesn't survive). what another
+  //     production still carries from the same source isn't deleted at all
+  //   - table rows: the edited nonterminals', the ones whose FOLLOW changed,
+  //     and the users of a changed FIRST
+  // the result is what generateTable() would give for the edited grammar,
+  // conflicts included, which come in the report instead of as warnings. a
+  // symbol that turns from terminal to nonterminal or back needs a full
+  // generateTable(), done quietly. false if a removed production doesn't
+  // exist (the edits before it are applied)
+  bool applyEdits(const std::vector<GrammarEdit>& edits, TableUpdate& report) {
+    report = TableUpdate();
+    beginUpdate();
+    bool ok = true;
+    size_t e = 0;
+    for (; e < edits.size(); ++e) {
+      if (needsFullRebuild(edits[e])) break;
+      if (!(edits[e].add ? addProduction(edits[e].nt, edits[e].body) : removeProduction(edits[e].nt, edits[e].body))) {
+        ok = false;
+        break;
+      }
+    }
+    if (ok && e < edits.size()) {
+      for (; e < edits.size(); ++e) {
+        const GrammarEdit& ed = edits[e];
+        if (ed.add) {
+          prods[ed.nt].push_back(ed.body);
+          continue;
+        }
+        if (!eraseProduction(ed.nt, ed.body)) {
+          ok = false;
+          break;
+        }
+        if (prods[ed.nt].empty()) prods.erase(ed.nt);
+      }
+      rebuildAll(report);
+      return ok;
+    }
+    finishUpdate(report);
+    return ok;
+  }
+
+  // Rereads the grammar file and applies the difference to the loaded one as
+  // applyEdits() does. a nonterminal keeps the new file's production order
+  bool reloadGrammar(const std::string& filename, TableUpdate& report) {
+    std::ifstream file(filename);
+    if (!file.is_open()) {
+      std::cerr << "Error: Cannot open grammar file.\n";
+      return false;
+    }
+    std::map<std::string, std::vector<std::vector<std::string>>> next;
+    std::string nextStart, line;
+    while (std::getline(file, line)) {
+      std::istringstream iss(line);
+      std::string nt, colon, sym;
+      iss >> nt >> colon;
+      if (iss.fail() || colon != ":") continue;
+      if (nextStart.empty()) nextStart = nt;
+      std::vector<std::string> prod;
+      while (iss >> sym) prod.push_back(sym);
+      next[nt].push_back(prod);
+    }
+    if (nextStart != startSymbol) {
+      report = TableUpdate();
+      prods = next;
+      startSymbol = nextStart;
+      rebuildAll(report);
+      return true;
+    }
+
+    // per nonterminal: what's only in the old list goes, what's only in the new one comes
+    std::vector<GrammarEdit> adds, removes;
+    std::set<std::string> all;
+    for (const auto& r : prods) all.insert(r.first);
+    for (const auto& r : next) all.insert(r.first);
+    for (const std::string& nt : all) {
+      static const std::vector<std::vector<std::string>> none;
+      auto o = prods.find(nt), n = next.find(nt);
+      std::vector<std::vector<std::string>> oldList = o == prods.end() ? none : o->second;
+      std::vector<std::vector<std::string>> newList = n == next.end() ? none : n->second;
+      std::map<std::vector<std::string>, int> count;
+      for (const auto& b : oldList) count[b]++;
+      for (const auto& b : newList) count[b]--;
+      for (const auto& b : newList) {
+        if (count[b] < 0) {
+          adds.push_back({true, nt, b});
+          count[b]++;
+        }
+      }
+      for (const auto& b : oldList) {
+        if (count[b] > 0) {
+          removes.push_back({false, nt, b});
+          count[b]--;
+        }
+      }
+    }
+    // additions first, so a nonterminal whose every line changed never runs out of productions
+    std::vector<GrammarEdit> edits = adds;
+    edits.insert(edits.end(), removes.begin(), removes.end());
+    if (!applyEdits(edits, report)) return false;
+    if (report.fullRebuild) return true;
+
+    // same productions in another order: the row is rebuilt in the file's order
+    beginUpdate();
+    for (const auto& r : next) {
+      if (prods[r.first] != r.second) {
+        prods[r.first] = r.second;
+        dirtyRows.insert(r.first);
+      }
+    }
+    TableUpdate order;
+    finishUpdate(order);
+    report.rowsRebuilt += order.rowsRebuilt;
+    report.conflictsAdded.insert(report.conflictsAdded.end(), order.conflictsAdded.begin(), order.conflictsAdded.end());
+    report.conflictsRemoved.insert(report.conflictsRemoved.end(), order.conflictsRemoved.begin(),
+                                   order.conflictsRemoved.end());
+    return true;
+  }
+
+private:
+  // terminals: every symbol that isn't a nonterminal (or epsilon), and $
+  void classify() {
+    for (const auto& rule : prods) { // Changed loop variable name for clarity
+      for (const auto& prod_vec : rule.second) { // Changed loop variable name for clarity
+        for (const auto& sym : prod_vec) { // Changed loop variable name for clarity
+          if (sym != "epsilon" && !nonterms.count(sym)) terms.insert(sym);
+        }
+      }
+    }
+    terms.insert("$"); // Add eof
+  }
+
+  // the table row of nt from its productions and the current sets, warn =
+  // print (and count) its conflicts
+  void buildRow(const std::string& nt, bool warn) {
+    table.erase(nt);
+    conflictCells.erase(nt);
+    for (const auto& prod : prods[nt]) {
+      std::pmr::set<std::string> firsts(first.get_allocator().resource());
+      bool hasEpsilon = false;
+
+      if (prod.size() == 1 && prod[0] == "epsilon") {
+        hasEpsilon = true;
+      } else {
+        auto sym = prod[0];
+        if (terms.count(sym)) firsts.insert(sym);
+        else if (nonterms.count(sym)) {
+          for (const auto& t : first[sym]) {
+            if (t != "epsilon") firsts.insert(t);
+            else hasEpsilon = true; // If first symbol derives epsilon
+                                    // Note: Does not correctly handle productions with sequences like A -> BC where B derives epsilon
+          }
+        }
+      }
+
+      // Add production for each terminal in first set
+      for (const auto& t : firsts) {
+          if (table.count(nt) && table.at(nt).count(t)) {
+               conflictCells[nt].insert(t);
+               if (warn) {
+                 METRIC_ADD(tableConflicts, 1);
+                 std::cerr << "Warning: LL(1) conflict for '" << nt << "' on '" << t << "'. Overwriting.\n";
+               }
+          }
+          table[nt][t] = prod;
+      }
+
+      // If production can derive epsilon, add for follow set
+      if (hasEpsilon) {
+        if (follow.count(nt)) { // Check if follow set exists
+           for (const auto& t : follow[nt]) {
+              if (table.count(nt) && table.at(nt).count(t)) {
+                 conflictCells[nt].insert(t);
+                 if (warn) {
+                   METRIC_ADD(tableConflicts, 1);
+                   std::cerr << "Warning: LL(1) conflict for '" << nt << "' on '" << t << "'. Overwriting with epsilon rule.\n";
+                 }
+              }
+              table[nt][t] = prod;
+           }
+        }
+      }
+    }
+  }
+
+  // ---- incremental updates ----
+
+  void buildIndex() {
+    firstUsers.clear();
+    precededBy.clear();
+    uses.clear();
+    symbolUses.clear();
+    for (const auto& rule : prods) {
+      for (const auto& body : rule.second) index(rule.first, body, 1);
+    }
+    indexed = true;
+  }
+
+  static void bump(std::map<std::string, int>& m, const std::string& key, int delta) {
+    if ((m[key] += delta) == 0) m.erase(key);
+  }
+
+  void index(const std::string& nt, const std::vector<std::string>& body, int delta) {
+    for (size_t i = 0; i < body.size(); ++i) {
+      if (body[i] != "epsilon") bump(symbolUses, body[i], delta);
+      if (!nonterms.count(body[i])) continue;
+      if (i == 0) bump(firstUsers[body[i]], nt, delta);
+      std::string next = i + 1 < body.size() ? body[i + 1] : "";
+      auto& u = uses[body[i]];
+      if ((u[{nt, next}] += delta) == 0) u.erase({nt, next});
+      if (nonterms.count(next)) bump(precededBy[next], body[i], delta);
+    }
+  }
+
+  // a symbol changing sides, or a nonterminal losing its last production
+  bool needsFullRebuild(const GrammarEdit& e) const {
+    if (e.add) return !nonterms.count(e.nt) && terms.count(e.nt);
+    auto it = prods.find(e.nt);
+    return it != prods.end() && it->second.size() == 1 && it->second[0] == e.body;
+  }
+
+  void beginUpdate() {
+    if (!indexed) buildIndex();
+    before.clear();
+    deleted.clear();
+    dirtyRows.clear();
+  }
+
+  std::pmr::set<std::string>& setOf(const SetKey& k) {
+    return k.first == FIRST_SET ? first[k.second] : follow[k.second];
+  }
+
+  void touch(const SetKey& k) {
+    if (!before.count(k)) {
+      const auto& s = setOf(k);
+      before[k] = std::set<std::string>(s.begin(), s.end());
+    }
+  }
+
+  bool nullable(const std::string& sym) {
+    return nonterms.count(sym) && first[sym].count("epsilon");
+  }
+
+  // calls f(B) for every B in nt's productions whose FOLLOW gets FOLLOW(nt)
+  template <class F>
+  void followHeirs(const std::string& nt, F f) {
+    auto it = prods.find(nt);
+    if (it == prods.end()) return;
+    for (const auto& body : it->second) {
+      for (size_t i = 0; i < body.size(); ++i) {
+        if (nonterms.count(body[i]) && (i + 1 == body.size() || nullable(body[i + 1]))) f(body[i]);
+      }
+    }
+  }
+
+  // calls f(B, A) for every occurrence "B X" in a production of A
+  template <class F>
+  void occurrencesBefore(const std::string& x, F f) {
+    auto p = precededBy.find(x);
+    if (p == precededBy.end()) return;
+    for (const auto& b : p->second) {
+      for (const auto& u : uses[b.first]) {
+        if (u.first.second == x) f(b.first, u.first.first);
+      }
+    }
+  }
+
+  // adds e to a set and everything that copies it
+  void insert(const SetKey& start, const std::string& start_e) {
+    std::vector<std::pair<SetKey, std::string>> work{{start, start_e}};
+    while (!work.empty()) {
+      SetKey k = work.back().first;
+      std::string e = work.back().second;
+      work.pop_back();
+      touch(k);
+      if (!setOf(k).insert(e).second) continue;
+      if (k.first == FOLLOW_SET) {
+        followHeirs(k.second, [&](const std::string& b) { work.push_back({{FOLLOW_SET, b}, e}); });
+      } else if (e == "epsilon") { // FOLLOW(A) now reaches B in "B X"
+        occurrencesBefore(k.second, [&](const std::string& b, const std::string& a) {
+          for (const auto& t : follow[a]) work.push_back({{FOLLOW_SET, b}, t});
+        });
+      } else {
+        for (const auto& a : firstUsers[k.second]) work.push_back({{FIRST_SET, a.first}, e});
+        for (const auto& b : precededBy[k.second]) work.push_back({{FOLLOW_SET, b.first}, e});
+      }
+    }
+  }
+
+  // deletes e from a set and from everything that could have copied it
+  void overDelete(const SetKey& start, const std::string& start_e) {
+    std::vector<std::pair<SetKey, std::string>> work{{start, start_e}};
+    while (!work.empty()) {
+      SetKey k = work.back().first;
+      std::string e = work.back().second;
+      work.pop_back();
+      touch(k);
+      if (!setOf(k).erase(e)) continue;
+      deleted.push_back({k, e});
+      if (k.first == FOLLOW_SET) {
+        followHeirs(k.second, [&](const std::string& b) { work.push_back({{FOLLOW_SET, b}, e}); });
+      } else if (e == "epsilon") {
+        occurrencesBefore(k.second, [&](const std::string& b, const std::string& a) {
+          for (const auto& t : follow[a]) work.push_back({{FOLLOW_SET, b}, t});
+        });
+      } else {
+        for (const auto& a : firstUsers[k.second]) work.push_back({{FIRST_SET, a.first}, e});
+        for (const auto& b : precededBy[k.second]) work.push_back({{FOLLOW_SET, b.first}, e});
+      }
+    }
+  }
+
+  // does something other than an over-deleted element still give e to the set
+  bool derivable(const SetKey& k, const std::string& e) {
+    if (k.first == FIRST_SET) {
+      for (const auto& body : prods[k.second]) {
+        if (body.size() == 1 && body[0] == "epsilon") {
+          if (e == "epsilon") return true;
+        } else if (body[0] == e && terms.count(e)) {
+          return true;
+        } else if (e != "epsilon" && nonterms.count(body[0]) && first[body[0]].count(e)) {
+          return true;
+        }
+      }
+      return false;
+    }
+    if (k.second == startSymbol && e == "$") return true;
+    for (const auto& u : uses[k.second]) {
+      const std::string& a = u.first.first;
+      const std::string& next = u.first.second;
+      if (next.empty() || nullable(next)) {
+        if (follow[a].count(e)) return true;
+      }
+      if (next == e && terms.count(e)) return true;
+      if (e != "epsilon" && nonterms.count(next) && first[next].count(e)) return true;
+    }
+    return false;
+  }
+
+  // where a production's contribution comes from: its first symbol (for
+  // FIRST(nt)), the symbol after the occurrence, or FOLLOW(nt)
+  enum Source { FROM_START, FROM_NEXT, FROM_FOLLOW };
+
+  // calls f(set, element, source, source symbol) for what one production gives the sets
+  template <class F>
+  void contributions(const std::string& nt, const std::vector<std::string>& body, F f) {
+    if (body.empty()) return;
+    if (body.size() == 1 && body[0] == "epsilon") {
+      f(SetKey{FIRST_SET, nt}, std::string("epsilon"), FROM_START, body[0]);
+    } else if (terms.count(body[0])) {
+      f(SetKey{FIRST_SET, nt}, body[0], FROM_START, body[0]);
+    } else if (nonterms.count(body[0])) {
+      std::vector<std::string> fs(first[body[0]].begin(), first[body[0]].end());
+      for (const auto& t : fs) if (t != "epsilon") f(SetKey{FIRST_SET, nt}, t, FROM_START, body[0]);
+    }
+    for (size_t i = 0; i < body.size(); ++i) {
+      if (!nonterms.count(body[i])) continue;
+      SetKey k{FOLLOW_SET, body[i]};
+      std::vector<std::pair<std::string, Source>> give;
+      if (i + 1 < body.size()) {
+        const std::string& next = body[i + 1];
+        if (terms.count(next)) give.push_back({next, FROM_NEXT});
+        else if (nonterms.count(next)) {
+          for (const auto& t : first[next]) if (t != "epsilon") give.push_back({t, FROM_NEXT});
+        }
+      }
+      if (i + 1 == body.size() || nullable(body[i + 1])) {
+        for (const auto& t : follow[nt]) give.push_back({t, FROM_FOLLOW});
+      }
+      for (const auto& g : give) f(k, g.first, g.second, g.second == FROM_NEXT ? body[i + 1] : nt);
+    }
+  }
+
+  // after a production of nt is gone: does another one still carry the
+  // source into the set the same way (then what it gave still flows, and
+  // the source shrinking later goes down that edge anyway)
+  bool edgeRemains(const std::string& nt, const SetKey& k, Source from, const std::string& sym) {
+    if (from == FROM_START) {
+      if (nonterms.count(sym)) return firstUsers[sym].count(nt) > 0;
+      for (const auto& body : prods[nt]) {
+        if (sym == "epsilon" ? body.size() == 1 && body[0] == sym : body[0] == sym) return true;
+      }
+      return false;
+    }
+    for (const auto& u : uses[k.second]) {
+      const std::string& next = u.first.second;
+      if (from == FROM_NEXT ? next == sym : u.first.first == nt && (next.empty() || nullable(next))) return true;
+    }
+    return false;
+  }
+
+  bool addProduction(const std::string& nt, const std::vector<std::string>& body) {
+    if (nonterms.insert(nt).second) {
+      first[nt];
+      follow[nt];
+    }
+    for (const auto& sym : body) {
+      if (sym != "epsilon" && !nonterms.count(sym)) terms.insert(sym);
+    }
+    prods[nt].push_back(body);
+    index(nt, body, 1);
+    dirtyRows.insert(nt);
+    contributions(nt, body, [&](const SetKey& k, const std::string& e, Source, const std::string&) { insert(k, e); });
+    return true;
+  }
+
+  bool eraseProduction(const std::string& nt, const std::vector<std::string>& body) {
+    auto it = prods.find(nt);
+    if (it != prods.end()) {
+      auto& list = it->second;
+      for (size_t i = list.size(); i-- > 0;) {
+        if (list[i] == body) {
+          list.erase(list.begin() + i);
+          return true;
+        }
+      }
+    }
+    std::cerr << "Error: No production '" << nt << " :";
+    for (const auto& sym : body) std::cerr << " " << sym;
+    std::cerr << "' to remove.\n";
+    return false;
+  }
+
+  bool removeProduction(const std::string& nt, const std::vector<std::string>& body) {
+    // what it gave, taken while it's still there (FOLLOW(nt) may go with it)
+    struct Gave {
+      SetKey k;
+      std::string e;
+      Source from;
+      std::string sym;
+    };
+    std::vector<Gave> gave;
+    contributions(nt, body, [&](const SetKey& k, const std::string& e, Source from, const std::string& sym) {
+      gave.push_back({k, e, from, sym});
+    });
+    if (!eraseProduction(nt, body)) return false;
+    index(nt, body, -1);
+    gave.erase(std::remove_if(gave.begin(), gave.end(),
+                              [&](const Gave& g) { return edgeRemains(nt, g.k, g.from, g.sym); }),
+               gave.end());
+    for (const auto& sym : body) {
+      if (!nonterms.count(sym) && sym != "$" && !symbolUses.count(sym)) terms.erase(sym);
+    }
+    dirtyRows.insert(nt);
+    size_t from = deleted.size();
+    for (const auto& g : gave) overDelete(g.k, g.e);
+    // rederive: put back whatever still has a derivation, which may give others theirs back
+    for (size_t i = from; i < deleted.size(); ++i) {
+      if (!setOf(deleted[i].first).count(deleted[i].second) && derivable(deleted[i].first, deleted[i].second)) {
+        insert(deleted[i].first, deleted[i].second);
+      }
+    }
+    return true;
+  }
+
+  // rows reached by the changed sets are rebuilt, conflicts compared
+  void finishUpdate(TableUpdate& report) {
+    for (const auto& b : before) {
+      const auto& now = setOf(b.first);
+      if (std::set<std::string>(now.begin(), now.end()) == b.second) continue;
+      if (b.first.first == FIRST_SET) {
+        report.firstChanged++;
+        for (const auto& a : firstUsers[b.first.second]) dirtyRows.insert(a.first);
+      } else {
+        report.followChanged++;
+        dirtyRows.insert(b.first.second);
+      }
+    }
+    for (const std::string& nt : dirtyRows) {
+      std::set<std::string> old;
+      auto c = conflictCells.find(nt);
+      if (c != conflictCells.end()) old = c->second;
+      buildRow(nt, false);
+      c = conflictCells.find(nt);
+      std::set<std::string> now = c == conflictCells.end() ? std::set<std::string>() : c->second;
+      for (const auto& t : now) if (!old.count(t)) report.conflictsAdded.push_back({nt, t});
+      for (const auto& t : old) if (!now.count(t)) report.conflictsRemoved.push_back({nt, t});
+    }
+    report.rowsRebuilt += dirtyRows.size();
+    before.clear();
+    deleted.clear();
+    dirtyRows.clear();
+  }
+
+  // everything again from prods (quietly), conflicts compared over all rows
+  void rebuildAll(TableUpdate& report) {
+    std::map<std::string, std::set<std::string>> old = conflictCells;
+    nonterms.clear();
+    terms.clear();
+    for (const auto& rule : prods) nonterms.insert(rule.first);
+    classify();
+    first.clear();
+    follow.clear();
+    bool wasVerbose = verbose;
+    verbose = false;
+    computeFirst();
+    computeFollow();
+    verbose = wasVerbose;
+    table.clear();
+    conflictCells.clear();
+    indexed = false;
+    for (const auto& rule : prods) buildRow(rule.first, false);
+    for (const auto& row : conflictCells) {
+      for (const auto& t : row.second) if (!old.count(row.first) || !old[row.first].count(t)) report.conflictsAdded.push_back({row.first, t});
+    }
+    for (const auto& row : old) {
+      for (const auto& t : row.second) {
+        if (!conflictCells.count(row.first) || !conflictCells[row.first].count(t)) report.conflictsRemoved.push_back({row.first, t});
+      }
+    }
+    report.fullRebuild = true;
+    report.rowsRebuilt = prods.size();
+  }
 };
 
 #endif // PARSE_TABLE_GEN_H
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef PARSE_TABLE_LAYOUT_H
+#define PARSE_TABLE_LAYOUT_H
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <cstdint>
+
+// How LL1Engine stores its [nonterminal][kind] -> production table (-1 =
+// error). both are built from the filled cells only:
+//
+//   void build(size_t rows, size_t cols, const std::vector<ParseTableCell>& cells);
+//   int32_t at(size_t row, size_t col) const;
+//   size_t bytes() const;
+//
+// DenseParseTable is the plain array, the stride a constant for enum
+// policies. CombParseTable is for big grammars, where a row has a handful of
+// cells out of thousands of columns and the plain array spills out of L2.
+
+struct ParseTableCell {
+  uint32_t row, col;
+  int32_t prod;
+};
+
+// FixedStride 0 = the column count is only known at runtime
+template <size_t FixedStride = 0>
+class DenseParseTable {
+public:
+  void build(size_t rows, size_t cols, const std::vector<ParseTableCell>& cells) {
+    columns = cols;
+    cells_.assign(rows * stride(), -1);
+    for (const ParseTableCell& c : cells) cells_[c.row * stride() + c.col] = c.prod;
+  }
+  int32_t at(size_t row, size_t col) const { return cells_[row * stride() + col]; }
+  size_t bytes() const { return cells_.size() * sizeof(int32_t); }
+
+private:
+  std::vector<int32_t> cells_;
+  size_t columns = 0;
+
+  // compile time stride for enum policies, so (nt * stride + kind) folds
+  size_t stride() const { return FixedStride ? FixedStride : columns; }
+};
+
+// Row displacement ("comb vector") packing plus a default per row:
+//   - the most common production of a row becomes its default, taken on any
+//     column without an entry of its own (errors included). a valid input
+//     never reaches an empty cell of an LL(1) table, and every expansion is
+//     still a production of the grammar, so nothing wrong gets accepted: a
+//     bad token is only reported a few expansions later, as a terminal
+//     mismatch or at a row without a default
+//   - the rest of each row is slid over one shared array until its entries
+//     land on free slots (first fit, fullest rows first), the slot keeps the
+//     row it belongs to for the check
+// a lookup is the row's (base, default) and then one 8 byte slot: two loads.
+class CombParseTable {
+public:
+  void build(size_t rows, size_t cols, const std::vector<ParseTableCell>& cells) {
+    rowInfo.assign(rows, Row{0, -1});
+    std::vector<std::vector<ParseTableCell>> byRow(rows);
+    for (const ParseTableCell& c : cells) byRow[c.row].push_back(c);
+
+    std::vector<uint32_t> order;
+    for (uint32_t r = 0; r < rows; ++r) {
+      std::vector<ParseTableCell>& row = byRow[r];
+      std::map<int32_t, size_t> uses;
+      for (const ParseTableCell& c : row) uses[c.prod]++;
+      int32_t def = -1;
+      size_t most = 0;
+      for (const auto& u : uses) {
+        if (u.second > most) {
+          def = u.first;
+          most = u.second;
+        }
+      }
+      rowInfo[r].def = def;
+      row.erase(std::remove_if(row.begin(), row.end(), [&](const ParseTableCell& c) { return c.prod == def; }),
+                row.end());
+      std::sort(row.begin(), row.end(), [](const ParseTableCell& a, const ParseTableCell& b) { return a.col < b.col; });
+      if (!row.empty()) order.push_back(r);
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return byRow[a].size() > byRow[b].size(); });
+
+    // every slot a lookup can reach exists: base + cols for the largest base
+    slots.assign(cols, Slot{-1, -1});
+    size_t firstFree = 0; // slots below are all taken
+    for (uint32_t r : order) {
+      const std::vector<ParseTableCell>& row = byRow[r];
+      while (firstFree < slots.size() && slots[firstFree].check >= 0) ++firstFree;
+      // the first entry on the first free slot at the earliest, base >= 0
+      size_t base = firstFree > row[0].col ? firstFree - row[0].col : 0;
+      for (;; ++base) {
+        if (base + cols > slots.size()) slots.resize(base + cols, Slot{-1, -1});
+        bool fits = true;
+        for (const ParseTableCell& c : row) {
+          if (slots[base + c.col].check >= 0) {
+            fits = false;
+            break;
+          }
+        }
+        if (fits) break;
+      }
+      rowInfo[r].base = (uint32_t)base;
+      for (const ParseTableCell& c : row) slots[base + c.col] = Slot{(int32_t)r, c.prod};
+      entries += row.size();
+    }
+  }
+
+  int32_t at(size_t row, size_t col) const {
+    const Row& r = rowInfo[row];
+    const Slot& s = slots[r.base + col];
+    return s.check == (int32_t)row ? s.prod : r.def;
+  }
+  size_t bytes() const { return rowInfo.size() * sizeof(Row) + slots.size() * sizeof(Slot); }
+
+  size_t slotCount() const { return slots.size(); }
+  size_t entryCount() const { return entries; } // cells that aren't their row's default
+
+private:
+  struct Row {
+    uint32_t base;
+    int32_t def; // -1 = none
+  };
+  struct Slot {
+    int32_t check; // row the slot belongs to, -1 = free
+    int32_t prod;
+  };
+  std::vector<Row> rowInfo;
+  std::vector<Slot> slots;
+  size_t entries = 0;
+};
+
+#endif // PARSE_TABLE_LAYOUT_H
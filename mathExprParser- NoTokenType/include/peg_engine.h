@@ -0,0 +1,469 @@
+#ifndef PEG_ENGINE_H
+#define PEG_ENGINE_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_set>
+#include <algorithm>
+#include <cstdint>
+#include "ll1_engine.h"      // token type policies
+#include "parse_table_gen.h" // the grammar loader
+#include "metrics.h"
+
+// PEG grammar read by ParseTableGenerator's loadGrammar, so the symbols are
+// the same: a left side is a nonterminal, the first rule's left side is the
+// start, everything else but "epsilon" is a terminal. the lines of one
+// nonterminal are its ordered choice, tried in file order, the first one
+// that matches wins (so epsilon goes last). a symbol written &X or !X is a
+// syntactic predicate: it looks at the input without consuming it and goes
+// on if X matches (&) or doesn't (!), e.g.
+//
+//   Stmt : id = Exp ;
+//   Stmt : !datatype Exp ;
+//
+// left recursion would loop forever, loadGrammar rejects it.
+class PEGGrammar {
+public:
+  enum Op : uint8_t { MATCH, AND, NOT };
+  struct Item {
+    int32_t sym; // < terminalCount: terminal
+    Op op;
+  };
+  struct Alt {
+    uint32_t begin, end; // items[begin .. end)
+  };
+
+  std::vector<std::string> names; // symbol id -> name, terminals first ("$" included)
+  int32_t terminalCount = 0;
+  std::vector<uint32_t> ruleAlts;  // nonterminal r has alts[ruleAlts[r] .. ruleAlts[r + 1])
+  std::vector<Alt> alts;
+  std::vector<Item> items;
+  uint32_t start = 0;              // nonterminal index (symbol id - terminalCount)
+
+  // Load grammar from file (: is the separator)
+  bool loadGrammar(const std::string& filename) {
+    ParseTableGenerator gen;
+    if (!gen.loadGrammar(filename)) return false;
+    return build(gen.getProductions(), gen.getStartSymbol());
+  }
+
+  // from loaded productions (nonterminal -> right hand sides in file order)
+  bool build(const std::map<std::string, std::vector<std::vector<std::string>>>& prods,
+             const std::string& startSymbol) {
+    names.clear();
+    ruleAlts.clear();
+    alts.clear();
+    items.clear();
+    if (!prods.count(startSymbol)) {
+      std::cerr << "Error: Grammar has no rules.\n";
+      return false;
+    }
+    auto bare = [](const std::string& s) {
+      return s.size() > 1 && (s[0] == '&' || s[0] == '!') ? s.substr(1) : s;
+    };
+    std::map<std::string, int32_t> ids;
+    for (const auto& rule : prods) {
+      for (const auto& body : rule.second) {
+        for (const std::string& s : body) {
+          std::string b = bare(s);
+          if (b != "epsilon" && !prods.count(b) && !ids.count(b)) {
+            ids[b] = (int32_t)names.size();
+            names.push_back(b);
+          }
+        }
+      }
+    }
+    if (!ids.count("$")) {
+      ids["$"] = (int32_t)names.size();
+      names.push_back("$");
+    }
+    terminalCount = (int32_t)names.size();
+    for (const auto& rule : prods) {
+      ids[rule.first] = (int32_t)names.size();
+      names.push_back(rule.first);
+    }
+    start = (uint32_t)(ids[startSymbol] - terminalCount);
+
+    for (const auto& rule : prods) {
+      ruleAlts.push_back((uint32_t)alts.size());
+      for (const auto& body : rule.second) {
+        Alt a{(uint32_t)items.size(), 0};
+        for (const std::string& s : body) {
+          if (s == "epsilon") continue;
+          Op op = s.size() > 1 && s[0] == '&' ? AND : s.size() > 1 && s[0] == '!' ? NOT : MATCH;
+          items.push_back({ids[bare(s)], op});
+        }
+        a.end = (uint32_t)items.size();
+        alts.push_back(a);
+      }
+    }
+    ruleAlts.push_back((uint32_t)alts.size());
+    return checkLeftRecursion();
+  }
+
+  size_t ruleCount() const { return ruleAlts.size() - 1; }
+  const std::string& ruleName(size_t r) const { return names[terminalCount + r]; }
+
+private:
+  // a rule that can call itself without consuming a token never returns.
+  // the calls at the same position are the ones up to the first item that
+  // must consume something (predicates never do)
+  bool checkLeftRecursion() {
+    size_t n = ruleCount();
+    std::vector<char> nullable(n, 0);
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (size_t r = 0; r < n; ++r) {
+        if (nullable[r]) continue;
+        for (uint32_t a = ruleAlts[r]; a < ruleAlts[r + 1] && !nullable[r]; ++a) {
+          bool all = true;
+          for (uint32_t i = alts[a].begin; i < alts[a].end && all; ++i) all = consumesNothing(items[i], nullable);
+          if (all) nullable[r] = changed = true;
+        }
+      }
+    }
+    std::vector<std::vector<uint32_t>> calls(n);
+    for (size_t r = 0; r < n; ++r) {
+      for (uint32_t a = ruleAlts[r]; a < ruleAlts[r + 1]; ++a) {
+        for (uint32_t i = alts[a].begin; i < alts[a].end; ++i) {
+          if (items[i].sym >= terminalCount) calls[r].push_back(items[i].sym - terminalCount);
+          if (!consumesNothing(items[i], nullable)) break;
+        }
+      }
+    }
+    // iterative dfs, 1 = on the path, 2 = done
+    std::vector<char> mark(n, 0);
+    std::vector<std::pair<uint32_t, size_t>> path;
+    for (uint32_t root = 0; root < n; ++root) {
+      if (mark[root]) continue;
+      path.push_back({root, 0});
+      mark[root] = 1;
+      while (!path.empty()) {
+        auto& top = path.back();
+        if (top.second == calls[top.first].size()) {
+          mark[top.first] = 2;
+          path.pop_back();
+          continue;
+        }
+        uint32_t next = calls[top.first][top.second++];
+        if (mark[next] == 1) {
+          std::cerr << "Error: PEG grammar is left recursive through '" << ruleName(next) << "'.\n";
+          return false;
+        }
+        if (!mark[next]) {
+          mark[next] = 1;
+          path.push_back({next, 0});
+        }
+      }
+    }
+    return true;
+  }
+
+  bool consumesNothing(const Item& it, const std::vector<char>& nullable) const {
+    if (it.op != MATCH) return true;
+    return it.sym >= terminalCount && nullable[it.sym - terminalCount];
+  }
+};
+
+// Packrat driver for PEGGrammar, templated on the same token type policies
+// as LL1Engine. the rules run on an explicit frame stack (a right recursive
+// rule over a long input would overflow the C++ one), and rule results go
+// into a fixed size memo instead of the usual [rule][position] table:
+// 2 way sets hashed on (rule, position), a full set drops the entry that
+// covers fewer tokens (a failure counts as none), as that one is the cheaper
+// to reparse. memory is memoSlots * 16 bytes whatever the input, and an
+// evicted result only costs reparsing it. only the rules marked
+// memoized use the memo (all of them at first), profile() + memoizeReentered()
+// narrow that to the rules that really get called twice at one position.
+template <class Policy>
+class PEGEngine {
+public:
+  struct RuleProfile {
+    uint64_t calls = 0;
+    uint64_t reentries = 0; // calls at a position the rule was already called at
+  };
+
+private:
+  static constexpr int32_t FAIL = -1;
+  static constexpr int32_t PENDING = -2; // a frame was pushed
+
+  struct Frame {
+    uint32_t rule;
+    uint32_t alt;   // index into grammar.alts
+    uint32_t item;  // next item of the alt
+    uint32_t start; // token position the rule was called at
+    uint32_t pos;
+  };
+  struct MemoEntry {
+    uint32_t pos;
+    uint32_t rule;
+    int32_t end;    // FAIL or the position after the match
+    uint32_t stamp; // parse it was stored in
+  };
+
+  const PEGGrammar& grammar;
+  Policy policy;
+  size_t kinds;
+  std::vector<int32_t> kindTerminal; // kind (+ unknown) -> terminal id, -1 = not in the grammar
+  int32_t endTerminal;
+
+  std::vector<MemoEntry> memo;       // sets of 2
+  uint32_t setMask;
+  uint32_t stamp = 0;
+  std::vector<char> memoized;        // per rule
+
+  std::vector<Frame> frames;
+  std::vector<int32_t> terms;        // token position -> terminal id, looked up once per parse
+  bool profiling = false;
+  std::vector<RuleProfile> profiles;
+  std::unordered_set<uint64_t> seen; // (rule, position) called, while profiling
+
+  uint64_t calls = 0, hits = 0, stores = 0, evictions = 0;
+  size_t maxDepth = 0;
+  uint32_t farthest = 0;             // furthest position a terminal failed at
+  std::vector<char> expected;        // terminals tried there
+  size_t consumed = 0;
+  std::string error;
+  std::ostream* errOut = &std::cerr;
+
+  bool fail(const std::string& msg) {
+    error = msg;
+    if (errOut) *errOut << msg;
+    return false;
+  }
+
+public:
+  // memoSlots is rounded up to a power of two, at least 2
+  PEGEngine(const PEGGrammar& g, Policy p = Policy(), size_t memoSlots = 4096)
+    : grammar(g), policy(std::move(p)), kinds(policy.kindCount()) {
+    std::map<std::string, int32_t> ids;
+    for (int32_t t = 0; t < grammar.terminalCount; ++t) ids[grammar.names[t]] = t;
+    kindTerminal.assign(kinds + 1, -1);
+    for (size_t k = 0; k < kinds; ++k) {
+      auto it = ids.find(policy.terminalName(k));
+      if (it != ids.end()) kindTerminal[k] = it->second;
+    }
+    endTerminal = ids.count("$") ? ids["$"] : -1;
+    size_t slots = 2;
+    while (slots < memoSlots) slots *= 2;
+    memo.assign(slots, MemoEntry{0, 0, 0, 0});
+    setMask = (uint32_t)(slots / 2 - 1);
+    memoized.assign(grammar.ruleCount(), 1);
+    profiles.resize(grammar.ruleCount());
+    expected.assign(grammar.terminalCount, 0);
+  }
+
+  // nullptr = only keep the message for getError()
+  void setErrorStream(std::ostream* out) { errOut = out; }
+  const std::string& getError() const { return error; }
+  size_t tokensConsumed() const { return consumed; }
+
+  void setMemoized(size_t rule, bool on) { memoized[rule] = on; }
+  bool isMemoized(size_t rule) const { return memoized[rule]; }
+  void memoizeAll(bool on = true) { std::fill(memoized.begin(), memoized.end(), on); }
+  size_t memoBytes() const { return memo.size() * sizeof(MemoEntry); }
+
+  // of the last parse
+  uint64_t callCount() const { return calls; }
+  uint64_t memoHits() const { return hits; }
+  uint64_t memoStores() const { return stores; }
+  uint64_t memoEvictions() const { return evictions; }
+  size_t maxFrameDepth() const { return maxDepth; }
+
+  // parses with every call counted: a rule called twice at one position is
+  // worth memoizing, one that never is only fills the memo. keeps adding up
+  // over several inputs until clearProfile()
+  template <class Tok>
+  bool profile(const std::vector<Tok>& tokens) {
+    profiling = true;
+    bool ok = parse(tokens);
+    profiling = false;
+    seen.clear();
+    return ok;
+  }
+  const std::vector<RuleProfile>& getProfile() const { return profiles; }
+  void clearProfile() { profiles.assign(grammar.ruleCount(), RuleProfile()); }
+
+  // memoizes the rules with at least minShare of their calls reentries,
+  // returns how many that is
+  size_t memoizeReentered(double minShare = 0.01) {
+    size_t n = 0;
+    for (size_t r = 0; r < profiles.size(); ++r) {
+      const RuleProfile& p = profiles[r];
+      memoized[r] = p.reentries > 0 && p.reentries >= minShare * p.calls;
+      n += memoized[r];
+    }
+    return n;
+  }
+
+  // Parses tokens (ending with the EOF token), true if the start rule
+  // matches all of them
+  template <class Tok>
+  bool parse(const std::vector<Tok>& tokens) {
+    consumed = 0;
+    error.clear();
+    size_t count = tokens.size();
+    if (count == 0 || kindTerminal[kindAt(tokens[count - 1])] != endTerminal || endTerminal < 0) {
+      return fail("Error: Token list does not end with the EOF token.\n");
+    }
+    terms.resize(count + 1);
+    for (size_t i = 0; i < count; ++i) terms[i] = kindTerminal[kindAt(tokens[i])];
+    terms[count] = -1; // nothing matches past $
+    if (++stamp == 0) { // wrapped, old entries could look current
+      std::fill(memo.begin(), memo.end(), MemoEntry{0, 0, 0, 0});
+      stamp = 1;
+    }
+    calls = hits = stores = evictions = 0;
+    maxDepth = 0;
+    farthest = 0;
+    std::fill(expected.begin(), expected.end(), 0);
+
+    int32_t end = run();
+    METRIC_ONLY(ParseCounters stats; stats.steps = calls; stats.expansions = calls - hits; stats.depth(maxDepth);)
+    // up to the EOF token, or through it when the start rule matches "$" itself
+    if (end >= 0 && ((size_t)end == count - 1 || (size_t)end == count)) {
+      consumed = count;
+      return true;
+    }
+    if (end >= 0) expect((uint32_t)end, endTerminal); // matched a prefix, the rest is the error
+    size_t at = std::min<size_t>(farthest, count - 1); // a rule after "$" fails past the last token
+    consumed = at;
+    return fail(syntaxError(tokens[at], at));
+  }
+
+private:
+  template <class Tok>
+  size_t kindAt(const Tok& t) const {
+    size_t k = policy.kindOf(t);
+    return Policy::fixedKinds || k < kinds ? k : kinds;
+  }
+
+  MemoEntry* memoSet(uint32_t rule, uint32_t pos) {
+    uint32_t h = pos * 0x9E3779B1u ^ rule * 0x85EBCA77u;
+    return &memo[((h ^ h >> 15) & setMask) * 2];
+  }
+
+  // the result if it's known, else pushes a frame for the rule and returns PENDING
+  int32_t call(uint32_t rule, uint32_t pos) {
+    ++calls;
+    if (profiling) {
+      profiles[rule].calls++;
+      if (!seen.insert((uint64_t)rule << 32 | pos).second) profiles[rule].reentries++;
+    }
+    if (memoized[rule]) {
+      MemoEntry* set = memoSet(rule, pos);
+      for (int w = 0; w < 2; ++w) {
+        if (set[w].stamp == stamp && set[w].pos == pos && set[w].rule == rule) {
+          ++hits;
+          return set[w].end;
+        }
+      }
+    }
+    uint32_t alt = grammar.ruleAlts[rule];
+    frames.push_back({rule, alt, grammar.alts[alt].begin, pos, pos});
+    if (frames.size() > maxDepth) maxDepth = frames.size();
+    return PENDING;
+  }
+
+  void store(uint32_t rule, uint32_t pos, int32_t end) {
+    MemoEntry* set = memoSet(rule, pos);
+    // an empty (old stamp) way, else the one that is cheaper to reparse
+    MemoEntry* w = set[0].stamp != stamp ? &set[0] : set[1].stamp != stamp ? &set[1]
+                 : span(set[0]) <= span(set[1]) ? &set[0] : &set[1];
+    evictions += w->stamp == stamp;
+    *w = MemoEntry{pos, rule, end, stamp};
+    ++stores;
+  }
+
+  // tokens the match covers, what a hit saves (failures count as nothing)
+  static int64_t span(const MemoEntry& e) { return (int64_t)e.end - (int64_t)e.pos; }
+
+  // moves the frame to its next alternative, false if it has none
+  bool nextAlt(Frame& f) {
+    if (++f.alt == grammar.ruleAlts[f.rule + 1]) return false;
+    f.item = grammar.alts[f.alt].begin;
+    f.pos = f.start;
+    return true;
+  }
+
+  int32_t run() {
+    const PEGGrammar::Item* items = grammar.items.data();
+    const PEGGrammar::Alt* alts = grammar.alts.data();
+    const int32_t tc = grammar.terminalCount;
+    frames.clear();
+    int32_t result = call(grammar.start, 0);
+    while (true) {
+      if (result != PENDING) {
+        // a rule finished: hand its result to the caller's item
+        if (frames.empty()) return result;
+        Frame& f = frames.back();
+        const PEGGrammar::Item& it = items[f.item];
+        bool ok = (result >= 0) != (it.op == PEGGrammar::NOT);
+        if (ok) {
+          if (it.op == PEGGrammar::MATCH) f.pos = (uint32_t)result;
+          f.item++;
+        } else if (!nextAlt(f)) {
+          result = finish(FAIL);
+          continue;
+        }
+        result = PENDING;
+      }
+      Frame& f = frames.back();
+      if (f.item == alts[f.alt].end) {
+        result = finish((int32_t)f.pos);
+        continue;
+      }
+      const PEGGrammar::Item& it = items[f.item];
+      if (it.sym < tc) {
+        bool match = terms[f.pos] == it.sym;
+        if (!match && it.op == PEGGrammar::MATCH) expect(f.pos, it.sym);
+        if (match != (it.op == PEGGrammar::NOT)) {
+          if (it.op == PEGGrammar::MATCH) f.pos++;
+          f.item++;
+        } else if (!nextAlt(f)) {
+          result = finish(FAIL);
+        }
+        continue;
+      }
+      result = call((uint32_t)(it.sym - tc), f.pos);
+    }
+  }
+
+  // pops the top frame with its result
+  int32_t finish(int32_t end) {
+    const Frame& f = frames.back();
+    if (memoized[f.rule]) store(f.rule, f.start, end);
+    frames.pop_back();
+    return end;
+  }
+
+  void expect(uint32_t pos, int32_t sym) {
+    if (pos < farthest) return;
+    if (pos > farthest) {
+      farthest = pos;
+      std::fill(expected.begin(), expected.end(), 0);
+    }
+    expected[sym] = 1;
+  }
+
+  template <class Tok>
+  std::string syntaxError(const Tok& t, size_t at) const {
+    std::ostringstream msg;
+    msg << "Syntax Error: Unexpected '" << t.lexeme << "' ("
+        << (terms[at] >= 0 ? grammar.names[terms[at]] : std::string("unknown")) << ") at token " << at
+        << ", expected one of:";
+    for (int32_t s = 0; s < grammar.terminalCount; ++s) {
+      if (expected[s]) msg << " '" << grammar.names[s] << "'";
+    }
+    msg << ".\n";
+    return msg.str();
+  }
+};
+
+// string token types (this tree's Lexer), see RuntimeTokenPolicy::defaults()
+using StringPEGEngine = PEGEngine<RuntimeTokenPolicy>;
+
+#endif // PEG_ENGINE_H
@@ -0,0 +1,149 @@
+#ifndef PROGRAM_PARSER_H
+#define PROGRAM_PARSER_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <stdexcept>
+#include <algorithm>
+#include <cctype>
+#include "lexer.h"
+#include "LL1_push_parser.h"
+#include "work_stealing_pool.h"
+
+// "Program" mode: the grammar describes one statement (e.g. Decl : datatype id L ;)
+// and the input holds many of them. the text is cut at statement boundaries
+// and every statement is parsed on its own, in parallel.
+
+// Where one statement sits in the input
+struct StatementSpan {
+  size_t begin;  // byte offset of the first char
+  size_t end;    // one past the last char (terminator included for ';')
+  size_t line;   // 1-based line of begin
+};
+
+// Parse result of one statement, positions are global (whole input)
+struct StatementResult {
+  bool ok;
+  size_t offset;  // byte offset of the error, or of the statement if ok
+  size_t line;
+  size_t column;
+  std::string error;
+};
+
+// Find statement boundaries directly in the text.
+// terminator ';' : each statement ends with (and includes) ';'
+// terminator '\n': one statement per non-blank line
+std::vector<StatementSpan> splitStatements(const std::string& text, char terminator) {
+  std::vector<StatementSpan> spans;
+  size_t line = 1;
+  size_t begin = 0;
+  size_t beginLine = 1;
+  bool blank = true; // only whitespace since begin
+
+  for (size_t i = 0; i < text.size(); ++i) {
+    char c = text[i];
+    if (c == terminator) {
+      size_t end = (terminator == '\n') ? i : i + 1;
+      if (blank && terminator != '\n') {
+        begin = i; // empty statement, just the ';'
+        beginLine = line;
+      }
+      if (!blank || terminator != '\n') spans.push_back({begin, end, beginLine});
+      begin = i + 1;
+      beginLine = line + (c == '\n');
+      blank = true;
+    } else if (blank && !isspace(static_cast<unsigned char>(c))) {
+      // start the statement at its first real char so positions line up
+      blank = false;
+      begin = i;
+      beginLine = line;
+    }
+    if (c == '\n') line++;
+  }
+  // leftover text without a terminator is still a (probably broken) statement
+  if (!blank) spans.push_back({begin, text.size(), beginLine});
+  return spans;
+}
+
+class ProgramParser {
+private:
+  const ParseTable& table;
+  const std::set<std::string>& terminals;
+  const std::set<std::string>& nonTerminals;
+  std::string startSymbol;
+
+  // turn a global offset into line / column, scanning from the statement start
+  void locate(const std::string& text, const StatementSpan& span, size_t offset, StatementResult& r) const {
+    r.offset = offset;
+    r.line = span.line;
+    size_t lineStart = span.begin;
+    while (lineStart > 0 && text[lineStart - 1] != '\n') lineStart--;
+    for (size_t i = span.begin; i < offset && i < text.size(); ++i) {
+      if (text[i] == '\n') {
+        r.line++;
+        lineStart = i + 1;
+      }
+    }
+    r.column = offset - lineStart + 1;
+  }
+
+  void parseOne(const std::string& text, const StatementSpan& span,
+                Lexer& lexer, LL1PushParser& parser, StatementResult& r) const {
+    parser.reset();
+    lexer.reset(text.substr(span.begin, span.end - span.begin));
+    r.ok = false;
+    try {
+      Token token;
+      while (lexer.next(token)) {
+        if (!parser.feed(token)) {
+          r.error = parser.getError();
+          locate(text, span, span.begin + lexer.lastTokenStart(), r);
+          return;
+        }
+      }
+    } catch (const std::exception& e) {
+      r.error = std::string("Lexer Error: ") + e.what() + "\n";
+      locate(text, span, span.begin + lexer.position(), r);
+      return;
+    }
+    if (!parser.finish()) {
+      r.error = parser.getError();
+      locate(text, span, span.end, r);
+      return;
+    }
+    r.ok = true;
+    r.offset = span.begin;
+    r.line = span.line;
+    r.column = 0;
+  }
+
+public:
+  ProgramParser(const ParseTable& parseTable,
+                const std::set<std::string>& terms,
+                const std::set<std::string>& nonTerms,
+                const std::string& startSym)
+    : table(parseTable), terminals(terms), nonTerminals(nonTerms), startSymbol(startSym) {}
+
+  // Parse every statement, results come back in source order.
+  // statements are grouped in batches so each task amortizes its lexer/parser setup
+  std::vector<StatementResult> parse(const std::string& text, char terminator,
+                                     WorkStealingPool& pool, size_t batchSize = 512) const {
+    std::vector<StatementSpan> spans = splitStatements(text, terminator);
+    std::vector<StatementResult> results(spans.size());
+    size_t batches = (spans.size() + batchSize - 1) / batchSize;
+
+    pool.parallelFor(batches, [&](size_t b) {
+      Lexer lexer("");
+      LL1PushParser parser(table, terminals, nonTerminals, startSymbol);
+      parser.setErrorStream(nullptr); // errors are reported in order by the caller
+      size_t last = std::min(spans.size(), (b + 1) * batchSize);
+      for (size_t i = b * batchSize; i < last; ++i) {
+        parseOne(text, spans[i], lexer, parser, results[i]);
+      }
+    });
+    return results;
+  }
+};
+
+#endif // PROGRAM_PARSER_H
@@ -0,0 +1,123 @@
+#ifndef SEMANTIC_CHECK_H
+#define SEMANTIC_CHECK_H
+
+#include <string>
+#include <vector>
+#include "lexer.h"
+#include "symbol_table.h"
+
+// Semantic checks for programs of declarations and assignments
+// (ex_input/program_grammar.txt):
+//
+//   int x , y ;  float z ;  x = y * ( z + 2 ) ;
+//
+// runs in the same pass as the parser: feed it every token the parser
+// accepted. the syntax is already right by then, so a small state machine
+// over the tokens is enough:
+//   - declarations go into the SymbolTable, a second declaration of a name is an error
+//   - every id used in an assignment must be declared before
+//   - the type of an expression is the widest of its operands (char < int < float,
+//     as + - * / all promote), a float value can't be assigned to an int / char
+class SemanticChecker {
+public:
+  struct Counts {
+    size_t statements = 0;
+    size_t declarations = 0;
+    size_t redeclarations = 0;
+    size_t undeclared = 0;
+    size_t narrowing = 0;
+  };
+
+  explicit SemanticChecker(SymbolTable& table, size_t maxMessages = 100)
+    : symbols(table), keepMessages(maxMessages) {}
+
+  // call after parser.feed(token) returned true
+  void feed(const Token& token) {
+    const std::string& type = token.type;
+    switch (state) {
+      case State::STATEMENT:
+        if (type == "DATATYPE") {
+          declType = dataTypeFromName(token.lexeme);
+          state = State::DECL;
+        } else if (type == "ID") {
+          target = token.lexeme;
+          targetType = use(token.lexeme);
+          exprType = DataType::NONE;
+          state = State::ASSIGN;
+        }
+        break;
+
+      case State::DECL:
+        if (type == "ID") {
+          DataType previous;
+          counts.declarations++;
+          if (!symbols.declare(token.lexeme, declType, &previous)) {
+            error(counts.redeclarations, "'" + token.lexeme + "' redeclared as " + dataTypeName(declType) +
+                                         " (already declared as " + dataTypeName(previous) + ")");
+          }
+        } else if (type == "SEMICOLON") {
+          endStatement();
+        }
+        break;
+
+      case State::ASSIGN:
+        if (type == "ID") {
+          widen(use(token.lexeme));
+        } else if (type == "NUMBER") {
+          widen(token.number.isFloat ? DataType::FLOAT : DataType::INT);
+        } else if (type == "SEMICOLON") {
+          if (exprType == DataType::FLOAT && (targetType == DataType::INT || targetType == DataType::CHAR)) {
+            error(counts.narrowing, std::string("assigning a float value to ") + dataTypeName(targetType) +
+                                    " '" + target + "'");
+          }
+          endStatement();
+        }
+        break;
+    }
+  }
+
+  bool ok() const { return errorCount == 0; }
+  size_t errors() const { return errorCount; }
+  const Counts& getCounts() const { return counts; }
+
+  // "statement 3: 'x' redeclared ...", the first maxMessages of them
+  const std::vector<std::string>& messages() const { return kept; }
+
+private:
+  enum class State { STATEMENT, DECL, ASSIGN };
+
+  SymbolTable& symbols;
+  State state = State::STATEMENT;
+  DataType declType = DataType::NONE;
+  std::string target;
+  DataType targetType = DataType::NONE;
+  DataType exprType = DataType::NONE;
+  Counts counts;
+  size_t errorCount = 0;
+  size_t keepMessages;
+  std::vector<std::string> kept;
+
+  // type of an id in an expression (or assignment target), reports undeclared ones
+  DataType use(const std::string& name) {
+    DataType t = symbols.lookup(name);
+    if (t == DataType::NONE) error(counts.undeclared, "'" + name + "' used before it was declared");
+    return t;
+  }
+
+  void widen(DataType t) {
+    if ((uint8_t)t > (uint8_t)exprType) exprType = t;
+  }
+
+  void endStatement() {
+    counts.statements++;
+    state = State::STATEMENT;
+  }
+
+  void error(size_t& counter, const std::string& msg) {
+    counter++;
+    errorCount++;
+    if (kept.size() < keepMessages) kept.push_back("statement " + std::to_string(counts.statements + 1) + ": " + msg);
+  }
+};
+
+#endif // SEMANTIC_CHECK_H
@@ -0,0 +1,223 @@
+#ifndef SENTENCE_GEN_H
+#define SENTENCE_GEN_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+// Random sentence generator driven by a loaded grammar (ParseTableGenerator
+// productions). picks productions by weight, and once a sentence hits the
+// depth or size limit it only takes the production that ends soonest, so
+// every sentence is finite and (before mutation) valid.
+
+using ProductionMap = std::map<std::string, std::vector<std::vector<std::string>>>;
+
+struct GenOptions {
+  size_t maxDepth = 12;       // nesting limit (derivation tree height)
+  size_t targetTokens = 32;   // soft size limit per sentence
+  double mutateRate = 0.0;    // chance a sentence gets one token mutation
+  uint64_t seed = 1;
+};
+
+class SentenceGenerator {
+private:
+  // grammar copied into integer form so the hot loop never touches a map
+  std::vector<std::string> symbols;          // id -> text
+  std::vector<char> nonTerminal;             // id -> is nonterminal
+  std::vector<std::vector<std::vector<int>>> rules; // nt id -> productions
+  std::vector<std::vector<double>> weights;  // nt id -> production weights
+  std::vector<size_t> shortestProd;          // nt id -> production that terminates soonest
+  std::vector<int> terminals;                // for substitution mutations
+  std::map<std::string, int> ids;
+  int startId;
+  int idTerminal;                            // the 'id' terminal, -1 if none
+  int numTerminal;                           // the 'num' terminal, -1 if none
+  GenOptions opts;
+  uint64_t state;
+
+  // splitmix64, fast and reproducible across platforms
+  uint64_t nextRand() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  double nextUnit() {
+    return (nextRand() >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  int symbolId(const std::string& sym) {
+    auto it = ids.find(sym);
+    if (it != ids.end()) return it->second;
+    int id = (int)symbols.size();
+    ids[sym] = id;
+    symbols.push_back(sym);
+    nonTerminal.push_back(0);
+    rules.emplace_back();
+    weights.emplace_back();
+    return id;
+  }
+
+  // height of the smallest derivation tree for every nonterminal (fixed point),
+  // remembers which production reaches it
+  void computeShortest() {
+    const size_t INF = std::numeric_limits<size_t>::max();
+    std::vector<size_t> height(symbols.size(), INF);
+    shortestProd.assign(symbols.size(), 0);
+
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (size_t nt = 0; nt < symbols.size(); ++nt) {
+        for (size_t p = 0; p < rules[nt].size(); ++p) {
+          size_t h = 1;
+          for (int sym : rules[nt][p]) {
+            if (!nonTerminal[sym]) continue;
+            if (height[sym] == INF) { h = INF; break; }
+            h = std::max(h, height[sym] + 1);
+          }
+          if (h < height[nt]) {
+            height[nt] = h;
+            shortestProd[nt] = p;
+            changed = true;
+          }
+        }
+      }
+    }
+    for (size_t nt = 0; nt < symbols.size(); ++nt) {
+      if (nonTerminal[nt] && height[nt] == INF) {
+        throw std::runtime_error("Nonterminal '" + symbols[nt] + "' never derives a finite sentence");
+      }
+    }
+  }
+
+  size_t pickProduction(int nt) {
+    const std::vector<double>& w = weights[nt];
+    if (w.size() == 1) return 0;
+    double total = 0;
+    for (double x : w) total += x;
+    double r = nextUnit() * total;
+    for (size_t i = 0; i < w.size(); ++i) {
+      if (r < w[i]) return i;
+      r -= w[i];
+    }
+    return w.size() - 1;
+  }
+
+  // text for one terminal, 'id' becomes a fresh identifier, 'num' a number
+  void renderTerminal(int term, std::string& out) {
+    if (term != idTerminal && term != numTerminal) {
+      out += symbols[term];
+      return;
+    }
+    uint64_t r = nextRand();
+    char digits[24];
+    int n = 0;
+    uint64_t v = term == numTerminal ? (r >> 8) % 1000 : (r >> 8) % 100000;
+    do { digits[n++] = char('0' + v % 10); v /= 10; } while (v);
+    if (term == idTerminal) out += 'v';
+    while (n) out += digits[--n];
+  }
+
+  void mutate(std::vector<int>& toks) {
+    if (toks.empty()) return;
+    size_t i = nextRand() % toks.size();
+    switch (nextRand() % 4) {
+      case 0: toks.erase(toks.begin() + i); break;                    // drop
+      case 1: toks.insert(toks.begin() + i, toks[i]); break;         // duplicate
+      case 2: toks[i] = terminals[nextRand() % terminals.size()]; break; // replace
+      case 3:                                                         // swap with next
+        if (i + 1 < toks.size()) std::swap(toks[i], toks[i + 1]);
+        else toks.erase(toks.begin() + i);
+        break;
+    }
+  }
+
+  std::vector<int> toks;                           // terminals of the current sentence
+  std::vector<std::pair<int, size_t>> stack;       // (symbol, depth) work stack
+
+public:
+  SentenceGenerator(const ProductionMap& prods,
+                    const std::set<std::string>& terms,
+                    const std::string& startSym,
+                    const GenOptions& options = GenOptions())
+    : idTerminal(-1), numTerminal(-1), opts(options), state(options.seed)
+  {
+    if (!prods.count(startSym)) throw std::runtime_error("Start symbol '" + startSym + "' has no productions");
+    for (const auto& rule : prods) nonTerminal[symbolId(rule.first)] = 1;
+    for (const auto& rule : prods) {
+      int nt = ids[rule.first];
+      for (const auto& rhs : rule.second) {
+        std::vector<int> prod;
+        for (const auto& sym : rhs) {
+          if (sym != "epsilon") prod.push_back(symbolId(sym));
+        }
+        rules[nt].push_back(prod);
+        weights[nt].push_back(1.0);
+      }
+    }
+    for (const auto& t : terms) {
+      if (t != "$" && t != "epsilon") terminals.push_back(symbolId(t));
+    }
+    if (terminals.empty()) terminals.push_back(symbolId("id"));
+    if (ids.count("id")) idTerminal = ids["id"];
+    if (ids.count("num")) numTerminal = ids["num"];
+    startId = ids[startSym];
+    computeShortest();
+  }
+
+  // Relative weight of production index of nt (default 1 each)
+  void setWeight(const std::string& nt, size_t index, double w) {
+    auto it = ids.find(nt);
+    if (it == ids.end() || index >= weights[it->second].size()) {
+      throw std::runtime_error("No production " + std::to_string(index) + " for '" + nt + "'");
+    }
+    weights[it->second][index] = w;
+  }
+
+  // Derive one sentence and append it to out as one line (tokens separated
+  // by spaces). returns true if the sentence was mutated
+  bool generateLine(std::string& out) {
+    toks.clear();
+    stack.clear();
+    stack.push_back({startId, 0});
+    size_t pending = 0; // terminals still on the stack
+
+    // leftmost derivation with an explicit stack
+    while (!stack.empty()) {
+      int sym = stack.back().first;
+      size_t depth = stack.back().second;
+      stack.pop_back();
+
+      if (!nonTerminal[sym]) {
+        pending--;
+        toks.push_back(sym);
+        continue;
+      }
+      bool limit = depth >= opts.maxDepth || toks.size() + pending >= opts.targetTokens;
+      const std::vector<int>& rhs = rules[sym][limit ? shortestProd[sym] : pickProduction(sym)];
+      for (size_t i = rhs.size(); i-- > 0;) {
+        stack.push_back({rhs[i], depth + 1});
+        if (!nonTerminal[rhs[i]]) pending++;
+      }
+    }
+
+    bool mutated = opts.mutateRate > 0 && nextUnit() < opts.mutateRate;
+    if (mutated) mutate(toks);
+
+    for (size_t i = 0; i < toks.size(); ++i) {
+      if (i) out += ' ';
+      renderTerminal(toks[i], out);
+    }
+    out += '\n';
+    return mutated;
+  }
+};
+
+#endif // SENTENCE_GEN_H
@@ -0,0 +1,56 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <vector>
+#include <thread>
+#include <cstddef>
+
+// Bounded single producer / single consumer ring buffer.
+// one thread calls push(), one other thread calls pop(), no locks.
+// capacity is rounded up to a power of two so the index wraps with a mask.
+template <typename T>
+class SpscQueue {
+private:
+  std::vector<T> slots;
+  size_t mask;
+  alignas(64) std::atomic<size_t> head; // next slot to read (consumer)
+  alignas(64) std::atomic<size_t> tail; // next slot to write (producer)
+
+public:
+  explicit SpscQueue(size_t capacity = 4096) : head(0), tail(0) {
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    slots.resize(cap);
+    mask = cap - 1;
+  }
+
+  bool tryPush(T&& item) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == slots.size()) return false; // full
+    slots[t & mask] = std::move(item);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool tryPop(T& item) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return false; // empty
+    item = std::move(slots[h & mask]);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // blocking versions, yield while the queue is full / empty
+  void push(T&& item) {
+    while (!tryPush(std::move(item))) std::this_thread::yield();
+  }
+
+  void pop(T& item) {
+    while (!tryPop(item)) std::this_thread::yield();
+  }
+
+  size_t capacity() const { return slots.size(); }
+};
+
+#endif // SPSC_QUEUE_H
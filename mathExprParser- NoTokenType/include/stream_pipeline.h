@@ -0,0 +1,73 @@
+#ifndef STREAM_PIPELINE_H
+#define STREAM_PIPELINE_H
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include "lexer.h"
+#include "LL1_push_parser.h"
+#include "spsc_queue.h"
+
+// Lex + parse in a single pass over a stream, no token vector in between.
+// memory is bounded by the lexer chunk size and the parse stack depth.
+// tokenOut (optional) gets the same "TYPE\t\t'lexeme'" lines as writeTokens()
+bool parseStream(std::istream& in, LL1PushParser& parser, std::ostream* tokenOut = nullptr) {
+  StreamLexer lexer(in);
+  Token token("", "");
+  while (lexer.next(token)) {
+    if (tokenOut) *tokenOut << token.type << "\t\t'" << token.lexeme << "'\n";
+    if (!parser.feed(token)) return false;
+  }
+  return parser.finish();
+}
+
+// Same as parseStream but the lexer runs on its own thread and hands tokens
+// to the parser (this thread) through a bounded SPSC queue.
+bool parseStreamThreaded(std::istream& in, LL1PushParser& parser,
+                         std::ostream* tokenOut = nullptr, size_t queueSize = 4096) {
+  static const char* lexFailedType = "LEX_FAILED"; // not a type the lexer makes
+  SpscQueue<Token> queue(queueSize);
+  std::atomic<bool> stop(false);
+  std::exception_ptr lexError; // producer only, until it is joined
+
+  std::thread producer([&]() {
+    try {
+      StreamLexer lexer(in);
+      Token token("", "");
+      while (!stop.load(std::memory_order_relaxed) && lexer.next(token)) {
+        while (!queue.tryPush(std::move(token))) {
+          if (stop.load(std::memory_order_relaxed)) return;
+          std::this_thread::yield();
+        }
+      }
+    } catch (...) {
+      lexError = std::current_exception();
+      // tell the consumer in the queue, it reads lexError only after join
+      Token failed(lexFailedType, "");
+      while (!queue.tryPush(std::move(failed))) {
+        if (stop.load(std::memory_order_relaxed)) return;
+        std::this_thread::yield();
+      }
+    }
+  });
+
+  bool ok = true;
+  Token token("", "");
+  while (true) {
+    queue.pop(token);
+    if (token.type == lexFailedType) break; // lexError is set, rethrown after join
+    if (tokenOut) *tokenOut << token.type << "\t\t'" << token.lexeme << "'\n";
+    if (!parser.feed(token)) { ok = false; break; }
+    if (token.type == "EOF") break;
+  }
+  stop.store(true, std::memory_order_relaxed);
+  producer.join();
+
+  if (lexError) std::rethrow_exception(lexError);
+  return ok && parser.finish();
+}
+
+#endif // STREAM_PIPELINE_H
@@ -0,0 +1,221 @@
+#ifndef SYMBOL_TABLE_H
+#define SYMBOL_TABLE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory_resource>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+// Symbol table for the declaration grammar: identifier -> datatype.
+// names are interned into 1 MB arena blocks as [type][length][bytes], the
+// table is open addressing (linear probing) over 8 byte slots holding the
+// name's hash and a 32 bit reference into the arena, so lookups only touch
+// the arena on a hash match and growing never rehashes a name.
+// memory: the identifier bytes + 2 per name in the arena, plus the 8 byte
+// slots (the table is kept 3/8 to 3/4 full).
+
+enum class DataType : uint8_t { NONE, CHAR, INT, FLOAT }; // NONE = not declared
+
+inline DataType dataTypeFromName(std::string_view name) {
+  if (name == "int") return DataType::INT;
+  if (name == "float") return DataType::FLOAT;
+  if (name == "char") return DataType::CHAR;
+  return DataType::NONE;
+}
+
+inline const char* dataTypeName(DataType t) {
+  switch (t) {
+    case DataType::CHAR: return "char";
+    case DataType::INT: return "int";
+    case DataType::FLOAT: return "float";
+    default: return "undeclared";
+  }
+}
+
+// Bump allocator for interned names. blocks double from 4 KB up to 1 MB (or
+// are as big as a long name), so the waste is at most one block.
+// a reference is (block << 20) | offset
+class NameArena {
+public:
+  static constexpr uint32_t blockBits = 20;
+  static constexpr size_t blockSize = size_t(1) << blockBits;
+  static constexpr size_t maxName = 0xFFFF;
+
+  explicit NameArena(std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+    : resource(mr), blocks(mr), sizes(mr) {}
+
+  ~NameArena() {
+    for (size_t i = 0; i < blocks.size(); ++i) resource->deallocate(blocks[i], sizes[i], 1);
+  }
+
+  NameArena(const NameArena&) = delete;
+  NameArena& operator=(const NameArena&) = delete;
+
+  // copies the name in, returns its reference
+  uint32_t store(DataType type, std::string_view name) {
+    if (name.size() > maxName) throw std::length_error("identifier longer than 65535 bytes");
+    size_t need = 1 + (name.size() < 255 ? 1 : 3) + name.size();
+    if (blocks.empty() || used + need > sizes.back()) {
+      if (blocks.size() >= (size_t(1) << (32 - blockBits))) throw std::length_error("symbol table full (4 GB of names)");
+      // 4 KB << 8 is blockSize, don't shift any further (past 63 it's undefined)
+      size_t size = std::max(need, blocks.size() < 8 ? size_t(4096) << blocks.size() : blockSize);
+      blocks.push_back((char*)resource->allocate(size, 1));
+      sizes.push_back((uint32_t)size);
+      used = 0;
+    }
+    char* rec = blocks.back() + used;
+    uint32_t ref = (uint32_t)((blocks.size() - 1) << blockBits | used);
+    used += need;
+
+    *rec++ = (char)type;
+    if (name.size() < 255) {
+      *rec++ = (char)name.size();
+    } else {
+      *rec++ = (char)255;
+      uint16_t len = (uint16_t)name.size();
+      std::memcpy(rec, &len, 2);
+      rec += 2;
+    }
+    std::memcpy(rec, name.data(), name.size());
+    return ref;
+  }
+
+  DataType type(uint32_t ref) const {
+    return (DataType)*record(ref);
+  }
+
+  std::string_view name(uint32_t ref) const {
+    const char* rec = record(ref) + 1;
+    size_t len = (unsigned char)*rec++;
+    if (len == 255) {
+      uint16_t l;
+      std::memcpy(&l, rec, 2);
+      len = l;
+      rec += 2;
+    }
+    return std::string_view(rec, len);
+  }
+
+  size_t memoryBytes() const {
+    size_t total = 0;
+    for (uint32_t size : sizes) total += size;
+    return total;
+  }
+
+private:
+  std::pmr::memory_resource* resource;
+  std::pmr::vector<char*> blocks;
+  std::pmr::vector<uint32_t> sizes;
+  size_t used = 0; // bytes taken in the last block
+
+  const char* record(uint32_t ref) const {
+    return blocks[ref >> blockBits] + (ref & (blockSize - 1));
+  }
+};
+
+class SymbolTable {
+public:
+  explicit SymbolTable(size_t expectedNames = 1024,
+                       std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+    : names(mr), slots(mr) {
+    size_t cap = 16;
+    while (cap * 3 < expectedNames * 4) cap <<= 1; // at most 3/4 full
+    slots.assign(cap, Slot{0, EMPTY});
+  }
+
+  // Adds name with its type. false if it was already declared,
+  // previous (optional) then gets the type it was declared with
+  bool declare(std::string_view name, DataType type, DataType* previous = nullptr) {
+    uint32_t h = hash(name);
+    size_t i = find(name, h);
+    if (slots[i].ref != EMPTY) {
+      if (previous) *previous = names.type(slots[i].ref);
+      return false;
+    }
+    slots[i] = Slot{h, names.store(type, name)};
+    count++;
+    nameBytes += name.size();
+    if (count * 4 > slots.size() * 3) grow();
+    return true;
+  }
+
+  // declared type of name, DataType::NONE if it never was
+  DataType lookup(std::string_view name) const {
+    size_t i = find(name, hash(name));
+    return slots[i].ref == EMPTY ? DataType::NONE : names.type(slots[i].ref);
+  }
+
+  size_t size() const { return count; }
+  size_t identifierBytes() const { return nameBytes; }
+  size_t memoryBytes() const { return names.memoryBytes() + slots.size() * sizeof(Slot); }
+
+  // calls f(name, type) for every symbol, in no particular order
+  template <class F>
+  void forEach(F f) const {
+    for (const Slot& s : slots) {
+      if (s.ref != EMPTY) f(names.name(s.ref), names.type(s.ref));
+    }
+  }
+
+private:
+  struct Slot {
+    uint32_t hash;
+    uint32_t ref;
+  };
+  static constexpr uint32_t EMPTY = 0xFFFFFFFF; // no record can sit at the very end of the last block
+
+  NameArena names;
+  std::pmr::vector<Slot> slots;
+  size_t count = 0;
+  size_t nameBytes = 0;
+
+  // 8 bytes at a time, mixed like splitmix64
+  static uint32_t hash(std::string_view s) {
+    const char* p = s.data();
+    size_t n = s.size();
+    uint64_t h = 0x9E3779B97F4A7C15ull ^ n;
+    for (; n >= 8; p += 8, n -= 8) {
+      uint64_t v;
+      std::memcpy(&v, p, 8);
+      h = (h ^ v) * 0xBF58476D1CE4E5B9ull;
+      h ^= h >> 31;
+    }
+    if (n) {
+      uint64_t v = 0;
+      std::memcpy(&v, p, n);
+      h = (h ^ v) * 0x94D049BB133111EBull;
+    }
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ull;
+    return (uint32_t)(h >> 32);
+  }
+
+  // slot holding name, or the empty slot where it would go
+  size_t find(std::string_view name, uint32_t h) const {
+    size_t mask = slots.size() - 1;
+    size_t i = h & mask;
+    while (slots[i].ref != EMPTY) {
+      if (slots[i].hash == h && names.name(slots[i].ref) == name) return i;
+      i = (i + 1) & mask;
+    }
+    return i;
+  }
+
+  void grow() {
+    std::pmr::vector<Slot> old(slots.size() * 2, Slot{0, EMPTY}, slots.get_allocator());
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (const Slot& s : old) {
+      if (s.ref == EMPTY) continue;
+      size_t i = s.hash & mask;
+      while (slots[i].ref != EMPTY) i = (i + 1) & mask;
+      slots[i] = s;
+    }
+  }
+};
+
+#endif // SYMBOL_TABLE_H
@@ -0,0 +1,278 @@
+#ifndef TAC_IR_H
+#define TAC_IR_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <charconv>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <stdexcept>
+#include "lexer.h"
+#include "symbol_table.h"     // DataType
+#include "LL1_push_parser.h"  // ParseActions
+
+// Three address code for programs of declarations and assignments
+// (ex_input/program_grammar.txt) or single expressions (expr_grammar.txt):
+//
+//   int x , y ;  x = y * ( x + 2 ) ;   ->   decl int x
+//                                          decl int y
+//                                          t0 = x + 2
+//                                          t1 = y * t0
+//                                          x = t1
+//
+// instructions are 16 bytes in one flat vector. an operand is 32 bits: a
+// 2 bit kind (virtual register, variable, constant) and an index. variable
+// names and constants are interned once per program, so the code itself
+// holds no strings and t3 is just register 3.
+
+enum class TacOp : uint8_t {
+  DECL,           // declare variable a with type
+  COPY,           // dst = a
+  ADD, SUB, MUL, DIV, // dst = a op b
+  RET             // value of the expression is a
+};
+
+struct TacOperand {
+  enum Kind : uint32_t { NONE = 0, REG = 1, VAR = 2, CONST = 3 };
+  uint32_t bits = 0;
+
+  static TacOperand make(Kind k, uint32_t index) {
+    if (index >= (1u << 30)) throw std::length_error("IR operand index out of range");
+    return TacOperand{(uint32_t)k << 30 | index};
+  }
+  static TacOperand reg(uint32_t r) { return make(REG, r); }
+  static TacOperand var(uint32_t v) { return make(VAR, v); }
+  static TacOperand constant(uint32_t c) { return make(CONST, c); }
+
+  Kind kind() const { return (Kind)(bits >> 30); }
+  uint32_t index() const { return bits & ((1u << 30) - 1); }
+  bool operator==(TacOperand o) const { return bits == o.bits; }
+  bool operator!=(TacOperand o) const { return bits != o.bits; }
+};
+
+struct TacInstr {
+  TacOp op;
+  DataType type; // DECL only
+  TacOperand dst, a, b;
+};
+
+struct TacProgram {
+  std::vector<TacInstr> code;
+  std::vector<std::string> variables; // VAR index -> name
+  std::vector<double> constants;      // CONST index -> value
+  uint32_t registers = 0;             // t0 .. t(registers-1)
+
+  void clear() {
+    code.clear();
+    variables.clear();
+    constants.clear();
+    registers = 0;
+  }
+
+  std::string operandText(TacOperand o) const {
+    switch (o.kind()) {
+      case TacOperand::REG: return "t" + std::to_string(o.index());
+      case TacOperand::VAR: return variables[o.index()];
+      case TacOperand::CONST: return constantText(constants[o.index()]);
+      default: return "_";
+    }
+  }
+
+  // one instruction per line: "t1 = y * t0", "x = t1", "decl int x", "ret t1"
+  std::string dump() const {
+    std::string out;
+    for (const TacInstr& in : code) {
+      switch (in.op) {
+        case TacOp::DECL:
+          out += std::string("decl ") + dataTypeName(in.type) + " " + operandText(in.a);
+          break;
+        case TacOp::COPY:
+          out += operandText(in.dst) + " = " + operandText(in.a);
+          break;
+        case TacOp::RET:
+          out += "ret " + operandText(in.a);
+          break;
+        default:
+          out += operandText(in.dst) + " = " + operandText(in.a) + " " + opSymbol(in.op) + " " + operandText(in.b);
+          break;
+      }
+      out += '\n';
+    }
+    return out;
+  }
+
+  static const char* opSymbol(TacOp op) {
+    switch (op) {
+      case TacOp::ADD: return "+";
+      case TacOp::SUB: return "-";
+      case TacOp::MUL: return "*";
+      case TacOp::DIV: return "/";
+      default: return "?";
+    }
+  }
+
+  // shortest text that reads back as the same double
+  static std::string constantText(double d) {
+    char buf[32];
+#if defined(__cpp_lib_to_chars) || (defined(__GNUC__) && __GNUC__ >= 11)
+    auto r = std::to_chars(buf, buf + sizeof(buf), d);
+    return std::string(buf, r.ptr);
+#else
+    std::snprintf(buf, sizeof(buf), "%.17g", d);
+    return buf;
+#endif
+  }
+};
+
+// Runs prog: vars[i] is the value of variable i going in and coming out
+// (resized to prog.variables, new ones start at 0). returns the RET value, 0 without one
+inline double runTac(const TacProgram& prog, std::vector<double>& vars) {
+  vars.resize(prog.variables.size(), 0.0);
+  std::vector<double> regs(prog.registers);
+  auto value = [&](TacOperand o) {
+    switch (o.kind()) {
+      case TacOperand::REG: return regs[o.index()];
+      case TacOperand::VAR: return vars[o.index()];
+      case TacOperand::CONST: return prog.constants[o.index()];
+      default: return 0.0;
+    }
+  };
+  for (const TacInstr& in : prog.code) {
+    double r;
+    switch (in.op) {
+      case TacOp::DECL: continue;
+      case TacOp::RET: return value(in.a);
+      case TacOp::COPY: r = value(in.a); break;
+      case TacOp::ADD: r = value(in.a) + value(in.b); break;
+      case TacOp::SUB: r = value(in.a) - value(in.b); break;
+      case TacOp::MUL: r = value(in.a) * value(in.b); break;
+      case TacOp::DIV: r = value(in.a) / value(in.b); break;
+      default: throw std::runtime_error("Unknown IR instruction");
+    }
+    (in.dst.kind() == TacOperand::REG ? regs[in.dst.index()] : vars[in.dst.index()]) = r;
+  }
+  return 0.0;
+}
+
+// Emits TacProgram while LL1PushParser parses (parser.setActions(&emitter)),
+// no tree is built. operands go on a value stack when their token is matched,
+// operators on an operator stack. the grammar's tails (Expr : + Term Expr)
+// are right recursive but + - * / are left associative, so an operator is
+// emitted as soon as its right operand is complete: '*' / '/' when a Factor
+// is reduced, '+' / '-' when a Term is, which gives a - b - c = (a - b) - c.
+// '(' sits on the operator stack so nothing inside it pairs with an outer operator.
+//
+// statements: "datatype id , id ;" emits a DECL per id, "id = Exp ;" a COPY
+// into the id when ';' is matched. an expression left over at the end (the
+// expression grammar has no statements) is returned by finish() as RET.
+class TacEmitter : public ParseActions {
+public:
+  // factor / term: the grammar's nonterminals for operands of * / and + -
+  explicit TacEmitter(std::string factor = "Factor", std::string term = "Term")
+    : factorName(std::move(factor)), termName(std::move(term)) {}
+
+  void shift(const Token& token) override {
+    const std::string& type = token.type;
+    if (type == "ID") {
+      if (inDecl) emitDecl(variable(token.lexeme));
+      else values.push_back(variable(token.lexeme));
+    } else if (type == "NUMBER") {
+      values.push_back(constant(token.number.asDouble()));
+    } else if (type == "DATATYPE") {
+      inDecl = true;
+      declType = dataTypeFromName(token.lexeme);
+    } else if (type == "PLUS" || type == "MINUS" || type == "TIMES" || type == "DIVIDE" || type == "LPAREN") {
+      ops.push_back(token.lexeme[0]);
+    } else if (type == "RPAREN") {
+      ops.pop_back(); // the '(', the inner Exp is already emitted
+    } else if (type == "ASSIGN") {
+      target = pop();
+      if (target.kind() != TacOperand::VAR) throw std::runtime_error("IR: can only assign to a variable");
+      haveTarget = true;
+    } else if (type == "SEMICOLON") {
+      if (haveTarget) add(TacOp::COPY, target, pop());
+      inDecl = false;
+      haveTarget = false;
+    }
+  }
+
+  void reduce(const std::string& nonTerminal) override {
+    if (ops.empty()) return;
+    char op = ops.back();
+    if (((op == '*' || op == '/') && nonTerminal == factorName) ||
+        ((op == '+' || op == '-') && nonTerminal == termName)) {
+      ops.pop_back();
+      TacOperand rhs = pop();
+      TacOperand lhs = pop();
+      TacOperand dst = TacOperand::reg(prog.registers++);
+      add(op == '+' ? TacOp::ADD : op == '-' ? TacOp::SUB : op == '*' ? TacOp::MUL : TacOp::DIV, dst, lhs, rhs);
+      values.push_back(dst);
+    }
+  }
+
+  // after the parser accepted: a value still on the stack becomes RET
+  const TacProgram& finish() {
+    if (!values.empty()) {
+      add(TacOp::RET, TacOperand(), values.back());
+      values.clear();
+    }
+    return prog;
+  }
+
+  const TacProgram& program() const { return prog; }
+
+  // forget everything, for the next input
+  void reset() {
+    prog.clear();
+    varIds.clear();
+    constIds.clear();
+    values.clear();
+    ops.clear();
+    inDecl = haveTarget = false;
+  }
+
+private:
+  std::string factorName, termName;
+  TacProgram prog;
+  std::unordered_map<std::string, uint32_t> varIds;
+  std::unordered_map<uint64_t, uint32_t> constIds; // keyed by the double's bits
+  std::vector<TacOperand> values;
+  std::vector<char> ops; // + - * / (
+  bool inDecl = false;
+  DataType declType = DataType::NONE;
+  bool haveTarget = false;
+  TacOperand target;
+
+  TacOperand variable(const std::string& name) {
+    auto it = varIds.emplace(name, (uint32_t)prog.variables.size());
+    if (it.second) prog.variables.push_back(name);
+    return TacOperand::var(it.first->second);
+  }
+
+  TacOperand constant(double d) {
+    uint64_t bits;
+    std::memcpy(&bits, &d, 8);
+    auto it = constIds.emplace(bits, (uint32_t)prog.constants.size());
+    if (it.second) prog.constants.push_back(d);
+    return TacOperand::constant(it.first->second);
+  }
+
+  TacOperand pop() {
+    if (values.empty()) throw std::runtime_error("IR: missing operand");
+    TacOperand v = values.back();
+    values.pop_back();
+    return v;
+  }
+
+  void add(TacOp op, TacOperand dst, TacOperand a, TacOperand b = TacOperand()) {
+    prog.code.push_back(TacInstr{op, DataType::NONE, dst, a, b});
+  }
+
+  void emitDecl(TacOperand v) {
+    prog.code.push_back(TacInstr{TacOp::DECL, declType, TacOperand(), v, TacOperand()});
+  }
+};
+
+#endif // TAC_IR_H
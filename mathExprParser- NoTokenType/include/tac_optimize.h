@@ -0,0 +1,530 @@
+#ifndef TAC_OPTIMIZE_H
+#define TAC_OPTIMIZE_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>
+#include <unordered_map>
+#include <chrono>
+#include "tac_ir.h"
+
+// Optimization passes over the three address code (tac_ir.h):
+//   - local value numbering: a computation already held by a register or
+//     variable becomes a copy of it
+//   - constant propagation + folding, on reaching definitions
+//   - copy propagation, on available copies
+//   - dead code elimination, on liveness (variables are live at the end,
+//     registers only if read)
+//
+// the global facts are solved per basic block with a worklist over dense
+// bitsets (gen / kill / in / out), the passes then walk each block's
+// instructions once. sets per instruction would be quadratic in the
+// program size. the IR has no jumps yet, so a program is one block; the
+// solver and the passes don't rely on that.
+
+// fixed size bitset, 64 bits per word
+class BitSet {
+public:
+  explicit BitSet(size_t n = 0) : bits(n), words((n + 63) / 64, 0) {}
+
+  size_t size() const { return bits; }
+  bool test(size_t i) const { return words[i >> 6] >> (i & 63) & 1; }
+  void set(size_t i) { words[i >> 6] |= uint64_t(1) << (i & 63); }
+  void reset(size_t i) { words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+  void clear() { std::fill(words.begin(), words.end(), 0); }
+
+  void fill() {
+    std::fill(words.begin(), words.end(), ~uint64_t(0));
+    if (bits & 63) words.back() = (uint64_t(1) << (bits & 63)) - 1;
+  }
+
+  bool any() const {
+    for (uint64_t w : words) if (w) return true;
+    return false;
+  }
+
+  void orWith(const BitSet& o) {
+    for (size_t i = 0; i < words.size(); ++i) words[i] |= o.words[i];
+  }
+
+  void andWith(const BitSet& o) {
+    for (size_t i = 0; i < words.size(); ++i) words[i] &= o.words[i];
+  }
+
+  // *this = gen | (in & ~kill), true if that changed it
+  bool transfer(const BitSet& gen, const BitSet& in, const BitSet& kill) {
+    bool changed = false;
+    for (size_t i = 0; i < words.size(); ++i) {
+      uint64_t w = gen.words[i] | (in.words[i] & ~kill.words[i]);
+      changed |= w != words[i];
+      words[i] = w;
+    }
+    return changed;
+  }
+
+private:
+  size_t bits;
+  std::vector<uint64_t> words;
+};
+
+struct TacBlock {
+  uint32_t begin, end; // instructions [begin, end)
+  std::vector<uint32_t> pred, succ;
+};
+
+// basic blocks of prog: a new block would start at a jump target or after a
+// jump, the IR has none so far, so it's one block (none for an empty program)
+inline std::vector<TacBlock> buildBlocks(const TacProgram& prog) {
+  std::vector<TacBlock> blocks;
+  if (!prog.code.empty()) blocks.push_back(TacBlock{0, (uint32_t)prog.code.size(), {}, {}});
+  return blocks;
+}
+
+enum class FlowDirection { FORWARD, BACKWARD };
+enum class FlowMeet { UNION, INTERSECT };
+
+// one gen / kill problem: out = gen | (in & ~kill) forward, in = gen | (out & ~kill) backward
+struct FlowProblem {
+  FlowDirection direction;
+  FlowMeet meet;
+  std::vector<BitSet> gen, kill; // per block
+  BitSet boundary;               // in of the entry block / out of the exit blocks
+};
+
+struct FlowSolution {
+  std::vector<BitSet> in, out;
+  size_t visits = 0; // blocks taken off the worklist
+};
+
+// Worklist solver: a block is revisited when the set it feeds its neighbours changes
+inline FlowSolution solveFlow(const std::vector<TacBlock>& blocks, const FlowProblem& p) {
+  size_t n = blocks.size(), bits = p.boundary.size();
+  bool forward = p.direction == FlowDirection::FORWARD;
+  FlowSolution s;
+  s.in.assign(n, BitSet(bits));
+  s.out.assign(n, BitSet(bits));
+  std::vector<BitSet>& result = forward ? s.out : s.in; // what the transfer writes
+  std::vector<BitSet>& meetInto = forward ? s.in : s.out;
+  if (p.meet == FlowMeet::INTERSECT) {
+    for (BitSet& b : result) b.fill(); // top, lowered by the meets
+  }
+
+  std::deque<uint32_t> work;
+  std::vector<char> queued(n, 1);
+  for (uint32_t b = 0; b < n; ++b) work.push_back(forward ? b : (uint32_t)(n - 1 - b));
+
+  while (!work.empty()) {
+    uint32_t b = work.front();
+    work.pop_front();
+    queued[b] = 0;
+    s.visits++;
+
+    const std::vector<uint32_t>& from = forward ? blocks[b].pred : blocks[b].succ;
+    BitSet& m = meetInto[b];
+    bool edge = forward ? b == 0 : blocks[b].succ.empty(); // sees the boundary
+    if (p.meet == FlowMeet::INTERSECT) m.fill(); else m.clear();
+    if (edge) {
+      if (p.meet == FlowMeet::INTERSECT) m.andWith(p.boundary); else m.orWith(p.boundary);
+    }
+    for (uint32_t o : from) {
+      if (p.meet == FlowMeet::INTERSECT) m.andWith(result[o]); else m.orWith(result[o]);
+    }
+    if (from.empty() && !edge) m.clear(); // unreachable
+
+    if (result[b].transfer(p.gen[b], m, p.kill[b])) {
+      for (uint32_t next : forward ? blocks[b].succ : blocks[b].pred) {
+        if (!queued[next]) {
+          queued[next] = 1;
+          work.push_back(next);
+        }
+      }
+    }
+  }
+  return s;
+}
+
+struct PassStats {
+  std::string name;
+  size_t before = 0;   // instructions
+  size_t after = 0;
+  size_t rewrites = 0; // operands replaced / instructions rewritten or removed
+  size_t visits = 0;   // worklist visits of the dataflow solve
+  double ms = 0;
+};
+
+class TacOptimizer {
+public:
+  explicit TacOptimizer(TacProgram& p) : prog(p) {
+    for (uint32_t i = 0; i < prog.constants.size(); ++i) {
+      constIds.emplace(bitsOf(prog.constants[i]), i);
+    }
+  }
+
+  // value numbering, constants, copies, dead code, repeated until a round
+  // changes nothing (at most maxRounds). one PassStats per pass run
+  std::vector<PassStats> run(int maxRounds = 4) {
+    std::vector<PassStats> all;
+    for (int round = 0; round < maxRounds; ++round) {
+      size_t changes = 0;
+      for (PassStats s : {valueNumbering(), constantPropagation(), copyPropagation(), deadCodeElimination()}) {
+        changes += s.rewrites;
+        all.push_back(s);
+      }
+      if (changes == 0) break;
+    }
+    return all;
+  }
+
+  PassStats valueNumbering() {
+    Timer t(stats("value-numbering"));
+    size_t values = valueCount();
+    std::vector<uint32_t> vn(values), stamp(values, 0);
+    std::vector<TacOperand> holder; // value number -> operand holding it
+    std::unordered_map<uint32_t, uint32_t> constVn;
+    std::unordered_map<uint64_t, uint32_t> exprVn;
+    uint32_t block = 0;
+
+    // value number of o, a fresh one if o wasn't seen in this block
+    auto number = [&](TacOperand o) -> uint32_t {
+      if (o.kind() == TacOperand::CONST) {
+        auto it = constVn.emplace(o.index(), (uint32_t)holder.size());
+        if (it.second) holder.push_back(o);
+        return it.first->second;
+      }
+      uint32_t v = valueId(o);
+      if (stamp[v] != block) {
+        stamp[v] = block;
+        vn[v] = (uint32_t)holder.size();
+        holder.push_back(o);
+      }
+      return vn[v];
+    };
+    auto assign = [&](TacOperand dst, uint32_t h) {
+      uint32_t v = valueId(dst);
+      stamp[v] = block;
+      vn[v] = h;
+      if (holder[h] != dst && number(holder[h]) != h) holder[h] = dst; // the old holder was overwritten
+    };
+
+    for (const TacBlock& b : buildBlocks(prog)) {
+      block++;
+      holder.clear();
+      constVn.clear();
+      exprVn.clear();
+      exprVn.reserve(b.end - b.begin);
+      for (uint32_t i = b.begin; i < b.end; ++i) {
+        TacInstr& in = prog.code[i];
+        if (in.op == TacOp::COPY) {
+          assign(in.dst, number(in.a));
+          continue;
+        }
+        if (!isArith(in.op)) continue;
+        uint64_t na = number(in.a), nb = number(in.b);
+        if ((in.op == TacOp::ADD || in.op == TacOp::MUL) && na > nb) std::swap(na, nb);
+        uint64_t key = (uint64_t)in.op << 60 | na << 30 | nb;
+        auto it = exprVn.find(key);
+        if (it != exprVn.end() && holder[it->second] != in.dst && number(holder[it->second]) == it->second) {
+          in = TacInstr{TacOp::COPY, DataType::NONE, in.dst, holder[it->second], TacOperand()};
+          t.s.rewrites++;
+          assign(in.dst, it->second);
+          continue;
+        }
+        uint32_t h;
+        if (it != exprVn.end()) {
+          h = it->second;
+        } else {
+          h = (uint32_t)holder.size();
+          holder.push_back(in.dst);
+          exprVn.emplace(key, h);
+        }
+        assign(in.dst, h);
+        holder[h] = in.dst;
+      }
+    }
+    return t.done(prog);
+  }
+
+  PassStats constantPropagation() {
+    Timer t(stats("const-propagation"));
+    std::vector<TacBlock> blocks = buildBlocks(prog);
+    size_t values = valueCount(), sites = prog.code.size();
+    std::vector<std::vector<uint32_t>> defsOf(values);
+    for (uint32_t i = 0; i < sites; ++i) {
+      if (defines(prog.code[i])) defsOf[valueId(prog.code[i].dst)].push_back(i);
+    }
+
+    // reaching definitions: bit i = the definition at instruction i,
+    // bit sites + v = v still holds its value from before the program
+    FlowProblem p{FlowDirection::FORWARD, FlowMeet::UNION, {}, {}, BitSet(sites + values)};
+    for (size_t v = 0; v < values; ++v) p.boundary.set(sites + v);
+    std::vector<int64_t> lastDef(values, -1);
+    for (const TacBlock& b : blocks) {
+      BitSet gen(sites + values), kill(sites + values);
+      for (uint32_t i = b.begin; i < b.end; ++i) {
+        if (defines(prog.code[i])) lastDef[valueId(prog.code[i].dst)] = i;
+      }
+      for (uint32_t i = b.begin; i < b.end; ++i) {
+        if (!defines(prog.code[i])) continue;
+        uint32_t v = valueId(prog.code[i].dst);
+        if (lastDef[v] != (int64_t)i) continue; // each defined value once
+        gen.set(i);
+        kill.set(sites + v);
+        for (uint32_t d : defsOf[v]) kill.set(d);
+      }
+      p.gen.push_back(std::move(gen));
+      p.kill.push_back(std::move(kill));
+    }
+    FlowSolution flow = solveFlow(blocks, p);
+    t.s.visits = flow.visits;
+
+    std::vector<int64_t> definedAt(values, -1);
+    bool changed = true;
+    while (changed) { // more than once only if a fold reaches back over a loop
+      changed = false;
+      std::fill(definedAt.begin(), definedAt.end(), -1);
+      for (size_t bi = 0; bi < blocks.size(); ++bi) {
+        const TacBlock& b = blocks[bi];
+        // the constant v holds at instruction i, NONE if it isn't one
+        auto constantOf = [&](uint32_t v) {
+          if (definedAt[v] >= b.begin) return constCopy(prog.code[definedAt[v]]);
+          if (flow.in[bi].test(sites + v)) return TacOperand();
+          TacOperand c;
+          for (uint32_t d : defsOf[v]) {
+            if (!flow.in[bi].test(d)) continue;
+            TacOperand k = constCopy(prog.code[d]);
+            if (k.kind() != TacOperand::CONST || (c.kind() == TacOperand::CONST && c != k)) return TacOperand();
+            c = k;
+          }
+          return c;
+        };
+        for (uint32_t i = b.begin; i < b.end; ++i) {
+          TacInstr& in = prog.code[i];
+          if (in.op != TacOp::DECL) {
+            for (TacOperand* o : {&in.a, &in.b}) {
+              if (!isValue(*o)) continue;
+              TacOperand c = constantOf(valueId(*o));
+              if (c.kind() == TacOperand::CONST) {
+                *o = c;
+                t.s.rewrites++;
+                changed = true;
+              }
+            }
+          }
+          if (isArith(in.op) && in.a.kind() == TacOperand::CONST && in.b.kind() == TacOperand::CONST) {
+            in = TacInstr{TacOp::COPY, DataType::NONE, in.dst, constant(fold(in)), TacOperand()};
+            t.s.rewrites++;
+            changed = true;
+          }
+          if (defines(in)) definedAt[valueId(in.dst)] = i;
+        }
+      }
+      if (blocks.size() == 1) break; // a second walk can't find more
+    }
+    return t.done(prog);
+  }
+
+  PassStats copyPropagation() {
+    Timer t(stats("copy-propagation"));
+    std::vector<TacBlock> blocks = buildBlocks(prog);
+    size_t values = valueCount(), sites = prog.code.size();
+    std::vector<std::vector<uint32_t>> touching(values), withDst(values); // copies per value
+    std::vector<TacOperand> source(sites); // copy sources the flow sets are about, the walk rewrites them
+    for (uint32_t i = 0; i < sites; ++i) {
+      if (!isCopy(prog.code[i])) continue;
+      source[i] = prog.code[i].a;
+      uint32_t d = valueId(prog.code[i].dst), s = valueId(prog.code[i].a);
+      touching[d].push_back(i);
+      touching[s].push_back(i);
+      withDst[d].push_back(i);
+    }
+
+    // available copies: bit i = the copy at instruction i still holds
+    FlowProblem p{FlowDirection::FORWARD, FlowMeet::INTERSECT, {}, {}, BitSet(sites)};
+    std::vector<uint32_t> seen(values, 0);
+    uint32_t stampNo = 0;
+    for (const TacBlock& b : blocks) {
+      BitSet gen(sites), kill(sites);
+      stampNo++;
+      for (uint32_t i = b.end; i-- > b.begin;) { // a copy is generated if nothing after it redefines its ends
+        const TacInstr& in = prog.code[i];
+        if (isCopy(in) && seen[valueId(in.dst)] != stampNo && seen[valueId(in.a)] != stampNo) gen.set(i);
+        if (defines(in)) seen[valueId(in.dst)] = stampNo;
+      }
+      stampNo++;
+      for (uint32_t i = b.begin; i < b.end; ++i) {
+        if (!defines(prog.code[i])) continue;
+        uint32_t v = valueId(prog.code[i].dst);
+        if (seen[v] == stampNo) continue;
+        seen[v] = stampNo;
+        for (uint32_t c : touching[v]) kill.set(c);
+      }
+      p.gen.push_back(std::move(gen));
+      p.kill.push_back(std::move(kill));
+    }
+    FlowSolution flow = solveFlow(blocks, p);
+    t.s.visits = flow.visits;
+
+    std::vector<int64_t> definedAt(values, -1);
+    for (size_t bi = 0; bi < blocks.size(); ++bi) {
+      const TacBlock& b = blocks[bi];
+      bool incoming = flow.in[bi].any();
+      // what v is a copy of at this point, NONE if nothing
+      auto sourceOf = [&](uint32_t v) {
+        if (definedAt[v] >= b.begin) {
+          const TacInstr& c = prog.code[definedAt[v]];
+          if (isCopy(c) && definedAt[valueId(c.a)] < definedAt[v]) return c.a;
+          return TacOperand();
+        }
+        if (!incoming) return TacOperand();
+        for (uint32_t c : withDst[v]) {
+          if (flow.in[bi].test(c) && definedAt[valueId(source[c])] < b.begin) return source[c];
+        }
+        return TacOperand();
+      };
+      for (uint32_t i = b.begin; i < b.end; ++i) {
+        TacInstr& in = prog.code[i];
+        if (in.op != TacOp::DECL) {
+          for (TacOperand* o : {&in.a, &in.b}) {
+            if (!isValue(*o)) continue;
+            TacOperand s = sourceOf(valueId(*o));
+            if (s.kind() != TacOperand::NONE) {
+              *o = s;
+              t.s.rewrites++;
+            }
+          }
+        }
+        if (defines(in)) definedAt[valueId(in.dst)] = i;
+      }
+    }
+    return t.done(prog);
+  }
+
+  PassStats deadCodeElimination() {
+    Timer t(stats("dead-code"));
+    std::vector<TacBlock> blocks = buildBlocks(prog);
+    size_t values = valueCount();
+
+    // liveness: bit v = value v is read later. variables are the program's result
+    FlowProblem p{FlowDirection::BACKWARD, FlowMeet::UNION, {}, {}, BitSet(values)};
+    for (size_t v = 0; v < prog.variables.size(); ++v) p.boundary.set(v);
+    for (const TacBlock& b : blocks) {
+      BitSet gen(values), kill(values);
+      for (uint32_t i = b.end; i-- > b.begin;) {
+        const TacInstr& in = prog.code[i];
+        if (defines(in)) {
+          gen.reset(valueId(in.dst));
+          kill.set(valueId(in.dst));
+        }
+        forEachUse(in, [&](uint32_t v) { gen.set(v); });
+      }
+      p.gen.push_back(std::move(gen));
+      p.kill.push_back(std::move(kill));
+    }
+    FlowSolution flow = solveFlow(blocks, p);
+    t.s.visits = flow.visits;
+
+    // walking back from the block's out set, a definition nobody reads
+    // is dropped and its operands don't become live
+    std::vector<char> dead(prog.code.size(), 0);
+    for (size_t bi = 0; bi < blocks.size(); ++bi) {
+      BitSet live = flow.out[bi];
+      for (uint32_t i = blocks[bi].end; i-- > blocks[bi].begin;) {
+        const TacInstr& in = prog.code[i];
+        if (defines(in)) {
+          uint32_t d = valueId(in.dst);
+          if (!live.test(d) || (in.op == TacOp::COPY && in.a == in.dst)) {
+            dead[i] = 1;
+            t.s.rewrites++;
+            continue;
+          }
+          live.reset(d);
+        }
+        forEachUse(in, [&](uint32_t v) { live.set(v); });
+      }
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < prog.code.size(); ++i) {
+      if (!dead[i]) prog.code[kept++] = prog.code[i];
+    }
+    prog.code.resize(kept);
+    return t.done(prog);
+  }
+
+private:
+  TacProgram& prog;
+  std::unordered_map<uint64_t, uint32_t> constIds;
+
+  struct Timer {
+    PassStats s;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    explicit Timer(PassStats st) : s(std::move(st)) {}
+    PassStats done(const TacProgram& p) {
+      s.after = p.code.size();
+      s.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      return s;
+    }
+  };
+
+  PassStats stats(const char* name) const {
+    PassStats s;
+    s.name = name;
+    s.before = prog.code.size();
+    return s;
+  }
+
+  size_t valueCount() const { return prog.variables.size() + prog.registers; }
+
+  // variables first, then registers
+  uint32_t valueId(TacOperand o) const {
+    return o.kind() == TacOperand::VAR ? o.index() : (uint32_t)prog.variables.size() + o.index();
+  }
+
+  static bool isValue(TacOperand o) { return o.kind() == TacOperand::VAR || o.kind() == TacOperand::REG; }
+  static bool isArith(TacOp op) { return op >= TacOp::ADD && op <= TacOp::DIV; }
+  static bool defines(const TacInstr& in) { return in.op == TacOp::COPY || isArith(in.op); }
+  static bool isCopy(const TacInstr& in) { return in.op == TacOp::COPY && isValue(in.a) && in.a != in.dst; }
+
+  static TacOperand constCopy(const TacInstr& in) {
+    return in.op == TacOp::COPY && in.a.kind() == TacOperand::CONST ? in.a : TacOperand();
+  }
+
+  template <class F>
+  void forEachUse(const TacInstr& in, F f) const {
+    if (in.op == TacOp::DECL) return;
+    if (isValue(in.a)) f(valueId(in.a));
+    if (isValue(in.b)) f(valueId(in.b));
+  }
+
+  // the same double arithmetic the program would do at run time
+  double fold(const TacInstr& in) const {
+    double a = prog.constants[in.a.index()], b = prog.constants[in.b.index()];
+    switch (in.op) {
+      case TacOp::ADD: return a + b;
+      case TacOp::SUB: return a - b;
+      case TacOp::MUL: return a * b;
+      default: return a / b;
+    }
+  }
+
+  static uint64_t bitsOf(double d) {
+    uint64_t b;
+    std::memcpy(&b, &d, 8);
+    return b;
+  }
+
+  TacOperand constant(double d) {
+    auto it = constIds.emplace(bitsOf(d), (uint32_t)prog.constants.size());
+    if (it.second) prog.constants.push_back(d);
+    return TacOperand::constant(it.first->second);
+  }
+};
+
+// runs all passes on prog, returns one PassStats per pass run
+inline std::vector<PassStats> optimizeTac(TacProgram& prog) {
+  return TacOptimizer(prog).run();
+}
+
+#endif // TAC_OPTIMIZE_H
@@ -0,0 +1,128 @@
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// Fixed set of worker threads, each with its own task deque.
+// parallelFor() hands out task indices in contiguous blocks (one block per worker),
+// a worker takes from the front of its own deque and, once empty, steals from
+// the back of the others, so uneven tasks still keep every core busy.
+class WorkStealingPool {
+private:
+  struct TaskQueue {
+    std::mutex m;
+    std::deque<size_t> tasks;
+  };
+
+  std::vector<std::thread> workers;
+  std::vector<std::unique_ptr<TaskQueue>> queues;
+
+  std::mutex jobMutex;
+  std::condition_variable jobCv;   // workers wait here for a new job
+  std::condition_variable doneCv;  // parallelFor waits here for the job to end
+  const std::function<void(size_t)>* job;
+  size_t generation;               // bumped for every parallelFor call
+  size_t active;                   // workers still inside the current job
+  std::atomic<size_t> remaining;   // tasks not finished yet
+  bool stopping;
+
+  bool takeTask(size_t id, size_t& task) {
+    {
+      TaskQueue& own = *queues[id];
+      std::lock_guard<std::mutex> lock(own.m);
+      if (!own.tasks.empty()) {
+        task = own.tasks.front();
+        own.tasks.pop_front();
+        return true;
+      }
+    }
+    for (size_t k = 1; k < queues.size(); ++k) {
+      TaskQueue& victim = *queues[(id + k) % queues.size()];
+      std::lock_guard<std::mutex> lock(victim.m);
+      if (!victim.tasks.empty()) {
+        task = victim.tasks.back();
+        victim.tasks.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void workerLoop(size_t id) {
+    size_t seen = 0;
+    while (true) {
+      const std::function<void(size_t)>* fn;
+      {
+        std::unique_lock<std::mutex> lock(jobMutex);
+        jobCv.wait(lock, [&]() { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        fn = job;
+        if (!fn) continue; // woke up after that job already finished
+        active++;
+      }
+
+      size_t task;
+      while (takeTask(id, task)) {
+        (*fn)(task);
+        remaining.fetch_sub(1, std::memory_order_acq_rel);
+      }
+
+      std::lock_guard<std::mutex> lock(jobMutex);
+      if (--active == 0) doneCv.notify_all();
+    }
+  }
+
+public:
+  explicit WorkStealingPool(size_t threads = std::thread::hardware_concurrency())
+    : job(nullptr), generation(0), active(0), remaining(0), stopping(false)
+  {
+    if (threads == 0) threads = 1;
+    for (size_t i = 0; i < threads; ++i) queues.emplace_back(new TaskQueue());
+    for (size_t i = 0; i < threads; ++i) workers.emplace_back(&WorkStealingPool::workerLoop, this, i);
+  }
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard<std::mutex> lock(jobMutex);
+      stopping = true;
+    }
+    jobCv.notify_all();
+    for (auto& w : workers) w.join();
+  }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  size_t size() const { return workers.size(); }
+
+  // Run fn(0) .. fn(count - 1) on the workers and wait for all of them.
+  // fn must not throw, catch inside and record the error instead.
+  void parallelFor(size_t count, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+
+    std::unique_lock<std::mutex> lock(jobMutex);
+    size_t n = queues.size();
+    for (size_t w = 0; w < n; ++w) {
+      std::lock_guard<std::mutex> qlock(queues[w]->m);
+      for (size_t i = count * w / n; i < count * (w + 1) / n; ++i) queues[w]->tasks.push_back(i);
+    }
+    job = &fn;
+    remaining.store(count);
+    generation++;
+    jobCv.notify_all();
+
+    // done when every task ran and no worker still holds a pointer to fn
+    doneCv.wait(lock, [&]() { return remaining.load() == 0 && active == 0; });
+    job = nullptr;
+  }
+};
+
+#endif // WORK_STEALING_POOL_H
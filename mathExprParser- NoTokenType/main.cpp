@@ -4,10 +4,26 @@
 #include <sstream>
 #include <vector>
 #include <stdexcept>
+#include <chrono>
+#include <thread>
 
 #include "include/lexer.h"
 #include "include/LL1_parser_ET.h"
 #include "include/parse_table_gen.h"
+#include "include/LL1_push_parser.h"
+#include "include/stream_pipeline.h"
+#include "include/program_parser.h"
+#include "include/batch_driver.h"
+#ifdef __linux__
+#include "include/parse_server.h" // epoll + eventfd, Linux only
+#endif
+#include "include/semantic_check.h"
+#include "include/tac_ir.h"
+#include "include/tac_optimize.h"
+#include "include/lr_engine.h"
+#include "include/glr_engine.h"
+#include "include/peg_engine.h"
+#include <csignal>
 
 std::string readInputFile(const std::string& filename = "ex_input/input.txt") {
   std::ifstream file(filename);
@@ -28,28 +44,600 @@ void writeTokens(const std::vector<Token>& tokens, const std::string& filename =
   }
 }
 
-int main() {
+// Single pass mode: lexer feeds the push parser directly, no token vector.
+// --stream runs both on this thread, --threaded puts the lexer on its own thread
+int runStreaming(bool threaded, const std::string& filename = "ex_input/input.txt") {
+  std::ifstream in(filename, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Could not open input file: " + filename);
+  }
+
+  ParseTableGenerator gen;
+  PhaseTimer loadTimer("load_grammar");
+  if (!gen.loadGrammar("ex_input/grammar.txt")) {
+    std::cerr << "Failed to load grammar.\n";
+    return 1;
+  }
+  loadTimer.stop();
+  {
+    METRIC_PHASE("generate_table");
+    gen.generateTable();
+  }
+
+  // the push parser keeps references, so hold on to the tables here
+  ParseTable table = gen.getParseTable();
+  std::set<std::string> terms = gen.getTerminals();
+  std::set<std::string> nonterms = gen.getNonTerminals();
+  LL1PushParser parser(table, terms, nonterms, gen.getStartSymbol());
+
+  std::ofstream tokenOut("Outputs/tokens.txt");
+  PhaseTimer parseTimer(threaded ? "stream_parse_threaded" : "stream_parse");
+  bool ok = threaded ? parseStreamThreaded(in, parser, tokenOut ? &tokenOut : nullptr)
+                     : parseStream(in, parser, tokenOut ? &tokenOut : nullptr);
+  parseTimer.stop();
+  if (!ok) {
+    std::cerr << "\nParsing failed.\n";
+    return 1;
+  }
+  std::cout << "\nParsing completed successfully (" << parser.tokensConsumed() << " tokens).\n";
+  return 0;
+}
+
+// Check mode: parse + semantic checks (declarations, undeclared ids, float
+// assigned to int / char) in one streaming pass, see include/semantic_check.h
+int runCheck(const std::string& inputFile, const std::string& grammarFile) {
+  std::ifstream in(inputFile, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Could not open input file: " + inputFile);
+  }
+
+  ParseTableGenerator gen;
+  std::streambuf* coutBuf = std::cout.rdbuf(nullptr); // the generator prints its tables
+  PhaseTimer tableTimer("load_grammar+generate_table");
+  bool loaded = gen.loadGrammar(grammarFile);
+  if (loaded) gen.generateTable();
+  tableTimer.stop();
+  std::cout.rdbuf(coutBuf);
+  if (!loaded) {
+    std::cerr << "Failed to load grammar.\n";
+    return 1;
+  }
+  ParseTable table = gen.getParseTable();
+  std::set<std::string> terms = gen.getTerminals();
+  std::set<std::string> nonterms = gen.getNonTerminals();
+  LL1PushParser parser(table, terms, nonterms, gen.getStartSymbol());
+
+  SymbolTable symbols;
+  SemanticChecker checker(symbols);
+  auto start = std::chrono::steady_clock::now();
+  PhaseTimer checkTimer("parse+check");
+  StreamLexer lexer(in);
+  Token token;
+  bool parsed = true;
+  while (lexer.next(token)) {
+    if (!parser.feed(token)) {
+      parsed = false;
+      break;
+    }
+    checker.feed(token);
+  }
+  parsed = parsed && parser.finish();
+  checkTimer.stop();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  for (const std::string& msg : checker.messages()) std::cerr << inputFile << ": " << msg << "\n";
+  if (checker.errors() > checker.messages().size()) {
+    std::cerr << "... " << (checker.errors() - checker.messages().size()) << " more\n";
+  }
+  const SemanticChecker::Counts& c = checker.getCounts();
+  std::cout << "\n" << c.statements << " statements, " << c.declarations << " declarations, "
+            << symbols.size() << " symbols, " << c.redeclarations << " redeclared, "
+            << c.undeclared << " undeclared uses, " << c.narrowing << " narrowing assignments in "
+            << ms << " ms\n";
+  std::cout << "symbol table: " << symbols.memoryBytes() << " bytes for "
+            << symbols.identifierBytes() << " identifier bytes\n";
+  if (!parsed) {
+    std::cerr << "\nParsing failed.\n";
+    return 1;
+  }
+  return checker.ok() ? 0 : 1;
+}
+
+// IR mode: three address code emitted by the parser's actions in one
+// streaming pass (include/tac_ir.h), written to Outputs/ir.txt.
+// optimize (--opt) also runs the passes of include/tac_optimize.h
+// and writes the result to Outputs/ir_opt.txt
+int runIR(const std::string& inputFile, const std::string& grammarFile, bool optimize) {
+  std::ifstream in(inputFile, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Could not open input file: " + inputFile);
+  }
+
+  ParseTableGenerator gen;
+  std::streambuf* coutBuf = std::cout.rdbuf(nullptr); // the generator prints its tables
+  PhaseTimer tableTimer("load_grammar+generate_table");
+  bool loaded = gen.loadGrammar(grammarFile);
+  if (loaded) gen.generateTable();
+  tableTimer.stop();
+  std::cout.rdbuf(coutBuf);
+  if (!loaded) {
+    std::cerr << "Failed to load grammar.\n";
+    return 1;
+  }
+  ParseTable table = gen.getParseTable();
+  std::set<std::string> terms = gen.getTerminals();
+  std::set<std::string> nonterms = gen.getNonTerminals();
+  LL1PushParser parser(table, terms, nonterms, gen.getStartSymbol());
+
+  TacEmitter emitter;
+  parser.setActions(&emitter);
+  auto start = std::chrono::steady_clock::now();
+  PhaseTimer irTimer("parse+ir");
+  StreamLexer lexer(in);
+  Token token;
+  bool parsed = true;
+  while (lexer.next(token)) {
+    if (!parser.feed(token)) {
+      parsed = false;
+      break;
+    }
+  }
+  parsed = parsed && parser.finish();
+  irTimer.stop();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if (!parsed) {
+    std::cerr << "\nParsing failed.\n";
+    return 1;
+  }
+
+  const TacProgram& ir = emitter.finish();
+  std::ofstream out("Outputs/ir.txt");
+  if (!out) {
+    throw std::runtime_error("Could not open IR output file: Outputs/ir.txt");
+  }
+  out << ir.dump();
+  std::cout << "\n" << ir.code.size() << " instructions, " << ir.registers << " registers, "
+            << ir.variables.size() << " variables, " << ir.constants.size() << " constants in "
+            << ms << " ms, saved to Outputs/ir.txt\n";
+  if (!optimize) return 0;
+
+  TacProgram opt = ir;
+  PhaseTimer optTimer("optimize_ir");
+  std::vector<PassStats> passes = optimizeTac(opt);
+  optTimer.stop();
+  for (const PassStats& s : passes) {
+    std::cout << s.name << ": " << s.before << " -> " << s.after << " instructions, "
+              << s.rewrites << " rewrites in " << s.ms << " ms\n";
+  }
+  std::ofstream optOut("Outputs/ir_opt.txt");
+  if (!optOut) {
+    throw std::runtime_error("Could not open IR output file: Outputs/ir_opt.txt");
+  }
+  optOut << opt.dump();
+  std::cout << opt.code.size() << " instructions left, saved to Outputs/ir_opt.txt\n";
+  return 0;
+}
+
+// LR mode: LALR(1) tables from the same grammar format (include/lr_table_gen.h)
+// and the shift-reduce driver, so left recursive grammars parse as written
+int runLR(const std::string& inputFile, const std::string& grammarFile) {
+  std::string input = readInputFile(inputFile);
+
+  LRTableGenerator gen;
+  PhaseTimer tableTimer("lr_table");
+  if (!gen.loadGrammar(grammarFile)) {
+    std::cerr << "Failed to load grammar.\n";
+    return 1;
+  }
+  gen.generateTable();
+  tableTimer.stop();
+  const LRTable& table = gen.getTable();
+  std::cout << table.states << " states, " << gen.conflicts() << " conflicts, " << table.bytes()
+            << " table bytes (" << table.denseBytes() << " dense)\n";
+
+  std::vector<Token> tokens = Lexer(input).tokenize();
+  StringLREngine parser(table, RuntimeTokenPolicy::defaults());
+  auto start = std::chrono::steady_clock::now();
+  PhaseTimer parseTimer("lr_parse");
+  bool parsed = parser.parse(tokens);
+  parseTimer.stop();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if (!parsed) {
+    std::cerr << "\nParsing failed.\n";
+    return 1;
+  }
+  std::cout << tokens.size() << " tokens, " << parser.shiftCount() << " shifts, " << parser.reductionCount()
+            << " reductions in " << ms << " ms\nParsing successful!\n";
+  return 0;
+}
+
+// GLR mode: the same tables with their conflicts kept (include/glr_engine.h),
+// every parse of an ambiguous grammar in one forest, written to Outputs/forest.txt
+int runGLR(const std::string& inputFile, const std::string& grammarFile) {
+  std::string input = readInputFile(inputFile);
+
+  LRTableGenerator gen;
+  PhaseTimer tableTimer("lr_table");
+  if (!gen.loadGrammar(grammarFile)) {
+    std::cerr << "Failed to load grammar.\n";
+    return 1;
+  }
+  gen.generateTable();
+  tableTimer.stop();
+
+  std::vector<Token> tokens = Lexer(input).tokenize();
+  StringGLREngine parser(gen.getTable(), RuntimeTokenPolicy::defaults());
+  auto start = std::chrono::steady_clock::now();
+  PhaseTimer parseTimer("glr_parse");
+  bool parsed = parser.parse(tokens);
+  parseTimer.stop();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if (!parsed) {
+    std::cerr << "\nParsing failed.\n";
+    return 1;
+  }
+
+  const ParseForest& forest = parser.getForest();
+  std::ofstream out("Outputs/forest.txt");
+  if (!out) {
+    throw std::runtime_error("Could not open forest output file: Outputs/forest.txt");
+  }
+  out << forest.dump();
+  std::vector<std::string> lexemes;
+  for (const Token& t : tokens) lexemes.push_back(t.lexeme);
+  std::cout << tokens.size() << " tokens, " << gen.conflicts() << " conflicts, " << parser.shiftCount()
+            << " shifts, " << parser.reductionCount() << " reductions (" << parser.deterministicReductions()
+            << " deterministic), " << parser.maxStackTops() << " stack tops at most in " << ms << " ms\n";
+  std::cout << forest.countTrees(forest.root) << " parse trees, " << forest.ambiguousNodes() << " ambiguous nodes, "
+            << forest.nodes.size() << " forest nodes, saved to Outputs/forest.txt\n";
+  if (tokens.size() <= 64) std::cout << forest.tree(forest.root, lexemes) << "\n";
+  std::cout << "Parsing successful!\n";
+  return 0;
+}
+
+// PEG mode: ordered choice + predicates on a packrat driver (include/peg_engine.h).
+// a first parse profiles the rules, the second memoizes only the reentered ones
+int runPEG(const std::string& inputFile, const std::string& grammarFile) {
+  std::string input = readInputFile(inputFile);
+
+  PEGGrammar grammar;
+  if (!grammar.loadGrammar(grammarFile)) {
+    std::cerr << "Failed to load grammar.\n";
+    return 1;
+  }
+  std::vector<Token> tokens = Lexer(input).tokenize();
+  StringPEGEngine parser(grammar, RuntimeTokenPolicy::defaults());
+  if (!parser.profile(tokens)) {
+    std::cerr << "\nParsing failed.\n";
+    return 1;
+  }
+  uint64_t allCalls = parser.callCount();
+  size_t kept = parser.memoizeReentered();
+  for (size_t r = 0; r < grammar.ruleCount(); ++r) {
+    const auto& p = parser.getProfile()[r];
+    std::cout << grammar.ruleName(r) << ": " << p.calls << " calls, " << p.reentries << " reentries"
+              << (parser.isMemoized(r) ? ", memoized" : "") << "\n";
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  PhaseTimer parseTimer("peg_parse");
+  bool parsed = parser.parse(tokens);
+  parseTimer.stop();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if (!parsed) {
+    std::cerr << "\nParsing failed.\n";
+    return 1;
+  }
+  std::cout << tokens.size() << " tokens, " << kept << " of " << grammar.ruleCount() << " rules memoized, "
+            << parser.callCount() << " calls (" << allCalls << " with all memoized), " << parser.memoHits()
+            << " memo hits, " << parser.memoBytes() << " memo bytes in " << ms << " ms\nParsing successful!\n";
+  return 0;
+}
+
+// Regen mode: the table of one grammar, then the edited grammar's through
+// reloadGrammar (only the sets and rows the changed productions reach)
+int runRegen(const std::string& grammarFile, const std::string& editedFile) {
+  ParseTableGenerator gen;
+  gen.setVerbose(false);
+  auto start = std::chrono::steady_clock::now();
+  if (!gen.loadGrammar(grammarFile)) {
+    std::cerr << "Failed to load grammar.\n";
+    return 1;
+  }
+  gen.generateTable();
+  double fullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  TableUpdate report;
+  start = std::chrono::steady_clock::now();
+  PhaseTimer regenTimer("regen");
+  bool ok = gen.reloadGrammar(editedFile, report);
+  regenTimer.stop();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  if (!ok) {
+    std::cerr << "Failed to load edited grammar.\n";
+    return 1;
+  }
+  for (const auto& c : report.conflictsAdded) std::cout << "new conflict: " << c.first << "-" << c.second << "\n";
+  for (const auto& c : report.conflictsRemoved) std::cout << "conflict gone: " << c.first << "-" << c.second << "\n";
+  std::cout << report.firstChanged << " FIRST and " << report.followChanged << " FOLLOW sets changed, "
+            << report.rowsRebuilt << " rows rebuilt" << (report.fullRebuild ? " (full rebuild)" : "") << " in " << ms
+            << " ms (generating " << fullMs << " ms)\n";
+  return 0;
+}
+
+// Program mode: many statements per file, each parsed on its own on a thread pool.
+// statements end with ';' if the grammar has that terminal, otherwise one per line
+int runProgram(const std::string& inputFile, const std::string& grammarFile, size_t threads) {
+  PhaseTimer readTimer("read");
+  std::string input = readInputFile(inputFile);
+  readTimer.stop();
+
+  ParseTableGenerator gen;
+  PhaseTimer loadTimer("load_grammar");
+  if (!gen.loadGrammar(grammarFile)) {
+    std::cerr << "Failed to load grammar.\n";
+    return 1;
+  }
+  loadTimer.stop();
+  {
+    METRIC_PHASE("generate_table");
+    gen.generateTable();
+  }
+  ParseTable table = gen.getParseTable();
+  std::set<std::string> terms = gen.getTerminals();
+  std::set<std::string> nonterms = gen.getNonTerminals();
+  char terminator = terms.count(";") ? ';' : '\n';
+
+  WorkStealingPool pool(threads);
+  ProgramParser program(table, terms, nonterms, gen.getStartSymbol());
+
+  auto start = std::chrono::steady_clock::now();
+  PhaseTimer parseTimer("parse");
+  std::vector<StatementResult> results = program.parse(input, terminator, pool);
+  parseTimer.stop();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  size_t failed = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const StatementResult& r = results[i];
+    if (r.ok) continue;
+    failed++;
+    std::cerr << inputFile << ":" << r.line << ":" << r.column
+              << ": statement " << (i + 1) << ": " << r.error;
+  }
+  std::cout << "\n" << results.size() << " statements, " << failed << " failed, "
+            << ms << " ms on " << pool.size() << " threads\n";
+  return failed ? 1 : 0;
+}
+
+// Batch mode: load the grammar once, then lex + parse every input on a thread pool
+//   parser --batch [--grammar FILE] [--threads N] [--dump-tokens DIR] [--io MODE] [--quiet] inputs...
+// inputs are files, directories (all files below) or - for one record per stdin line.
+// MODE: auto (io_uring if the kernel has it, else pread, else std::ifstream),
+// uring, pread, stream (std::ifstream) or workers (every worker reads its own
+// files, no separate reader)
+int runBatch(int argc, char* argv[]) {
+  std::string grammarFile = "ex_input/grammar.txt";
+  std::string dumpDir;
+  size_t threads = std::thread::hardware_concurrency();
+  bool quiet = false;
+  std::string ioMode = "auto";
+  std::vector<std::string> args;
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--grammar" && i + 1 < argc) grammarFile = argv[++i];
+    else if (arg == "--threads" && i + 1 < argc) threads = std::stoul(argv[++i]);
+    else if (arg == "--dump-tokens" && i + 1 < argc) dumpDir = argv[++i];
+    else if (arg == "--io" && i + 1 < argc) ioMode = argv[++i];
+    else if (arg == "--quiet") quiet = true;
+    else args.push_back(arg);
+  }
+  if (args.empty()) {
+    std::cerr << "No inputs given.\n";
+    return 1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  ParseTableGenerator gen;
+  std::streambuf* coutBuf = std::cout.rdbuf(nullptr); // the generator prints its tables
+  PhaseTimer tableTimer("load_grammar+generate_table");
+  bool loaded = gen.loadGrammar(grammarFile);
+  if (loaded) gen.generateTable();
+  tableTimer.stop();
+  std::cout.rdbuf(coutBuf);
+  if (!loaded) {
+    std::cerr << "Failed to load grammar.\n";
+    return 1;
+  }
+  ParseTable table = gen.getParseTable();
+  std::set<std::string> terms = gen.getTerminals();
+  std::set<std::string> nonterms = gen.getNonTerminals();
+
+  PhaseTimer collectTimer("collect_inputs");
+  std::vector<BatchInput> inputs = collectBatchInputs(args);
+  collectTimer.stop();
+  WorkStealingPool pool(threads);
+  PhaseTimer runTimer("read+parse");
+  BatchDriver driver(table, terms, nonterms, gen.getStartSymbol());
+  std::vector<BatchResult> results;
+  if (ioMode == "workers") {
+    results = driver.run(inputs, pool, dumpDir);
+  } else {
+    ReadMode mode = ioMode == "uring" ? ReadMode::URING : ioMode == "pread" ? ReadMode::PREAD
+                  : ioMode == "stream" ? ReadMode::STREAM : ReadMode::AUTO;
+    ReadMode used = mode;
+    results = driver.runOverlapped(inputs, pool, dumpDir, mode, &used);
+    const char* names[] = {"auto", "uring", "pread", "stream"};
+    if (mode != ReadMode::AUTO && used != mode) {
+      std::cerr << ioMode << " reads not available here, read with " << names[(int)used] << " instead.\n";
+    }
+    ioMode = names[(int)used];
+  }
+  runTimer.stop();
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+  // one line per input, in input order
+  size_t failed = 0, bytes = 0, tokens = 0;
+  std::string report;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const BatchResult& r = results[i];
+    bytes += r.bytes;
+    tokens += r.tokens;
+    if (!r.ok) failed++;
+    if (r.ok && quiet) continue;
+    report += (r.ok ? "OK\t" : "FAIL\t") + inputs[i].name;
+    report += r.ok ? "\t" + std::to_string(r.tokens) + " tokens\n" : "\t" + r.error + "\n";
+  }
+  std::cout << report;
+  std::cout << results.size() << " inputs, " << (results.size() - failed) << " ok, " << failed << " failed, "
+            << bytes << " bytes, " << tokens << " tokens in " << ms << " ms ("
+            << (ms > 0 ? results.size() / (ms / 1000) : 0) << " inputs/s, " << pool.size() << " threads, " << ioMode << " reads)\n";
+  return failed ? 1 : 0;
+}
+
+// Server mode: grammars loaded once, requests over a Unix socket until SIGINT / SIGTERM
+//   parser --serve SOCKET [--threads N] [NAME=GRAMMAR_FILE ...]
+// without grammars, ex_input/grammar.txt is served as "decl"
+#ifdef __linux__
+ParseServer* g_server = nullptr;
+
+void stopServer(int) {
+  if (g_server) g_server->stop();
+}
+
+int runServer(int argc, char* argv[]) {
+  if (argc < 3) {
+    std::cerr << "No socket path given.\n";
+    return 1;
+  }
+  size_t threads = std::thread::hardware_concurrency();
+  std::vector<std::pair<std::string, std::string>> grammarFiles;
+  for (int i = 3; i < argc; ++i) {
+    std::string arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg == "--threads" && i + 1 < argc) threads = std::stoul(argv[++i]);
+    else if (eq != std::string::npos && eq > 0) grammarFiles.push_back({arg.substr(0, eq), arg.substr(eq + 1)});
+    else {
+      std::cerr << "Expected NAME=GRAMMAR_FILE, got " << arg << "\n";
+      return 1;
+    }
+  }
+  if (grammarFiles.empty()) grammarFiles.push_back({"decl", "ex_input/grammar.txt"});
+
+  ParseServer server(argv[2], threads);
+  PhaseTimer tableTimer("load_grammar+generate_table");
+  for (const auto& g : grammarFiles) {
+    if (!server.addGrammar(g.first, g.second)) return 1;
+  }
+  tableTimer.stop();
+  if (!server.start()) return 1;
+
+  g_server = &server;
+  std::signal(SIGINT, stopServer);
+  std::signal(SIGTERM, stopServer);
+  std::cout << "Serving";
+  for (const auto& g : grammarFiles) std::cout << " " << g.first;
+  std::cout << " on " << argv[2] << " with " << server.workerThreads() << " workers\n";
+  server.run();
+  g_server = nullptr;
+  std::cout << "Stopped after " << server.requestsServed() << " requests.\n";
+  return 0;
+}
+#else
+int runServer(int, char*[]) {
+  std::cerr << "--serve is not supported on this platform (needs epoll).\n";
+  return 1;
+}
+#endif
+
+int runMode(int argc, char* argv[]) {
   try {
+    if (argc > 1) {
+      std::string mode = argv[1];
+      if (mode == "--stream" || mode == "--threaded") {
+        return argc > 2 ? runStreaming(mode == "--threaded", argv[2])
+                        : runStreaming(mode == "--threaded");
+      }
+      if (mode == "--check") {
+        std::string inputFile = argc > 2 ? argv[2] : "ex_input/input.txt";
+        std::string grammarFile = argc > 3 ? argv[3] : "ex_input/program_grammar.txt";
+        return runCheck(inputFile, grammarFile);
+      }
+      if (mode == "--ir" || mode == "--opt") {
+        std::string inputFile = argc > 2 ? argv[2] : "ex_input/input.txt";
+        std::string grammarFile = argc > 3 ? argv[3] : "ex_input/program_grammar.txt";
+        return runIR(inputFile, grammarFile, mode == "--opt");
+      }
+      if (mode == "--lr") {
+        std::string inputFile = argc > 2 ? argv[2] : "ex_input/input.txt";
+        std::string grammarFile = argc > 3 ? argv[3] : "ex_input/program_grammar.txt";
+        return runLR(inputFile, grammarFile);
+      }
+      if (mode == "--glr") {
+        std::string inputFile = argc > 2 ? argv[2] : "ex_input/input.txt";
+        std::string grammarFile = argc > 3 ? argv[3] : "ex_input/program_grammar.txt";
+        return runGLR(inputFile, grammarFile);
+      }
+      if (mode == "--peg") {
+        std::string inputFile = argc > 2 ? argv[2] : "ex_input/input.txt";
+        std::string grammarFile = argc > 3 ? argv[3] : "ex_input/peg_expr_grammar.txt";
+        return runPEG(inputFile, grammarFile);
+      }
+      if (mode == "--regen" && argc > 3) {
+        return runRegen(argv[2], argv[3]);
+      }
+      if (mode == "--program") {
+        std::string inputFile = argc > 2 ? argv[2] : "ex_input/input.txt";
+        std::string grammarFile = argc > 3 ? argv[3] : "ex_input/grammar.txt";
+        size_t threads = argc > 4 ? std::stoul(argv[4]) : std::thread::hardware_concurrency();
+        return runProgram(inputFile, grammarFile, threads);
+      }
+      if (mode == "--batch") {
+        return runBatch(argc, argv);
+      }
+      if (mode == "--serve") {
+        return runServer(argc, argv);
+      }
+      std::cerr << "Unknown option: " << mode << "\n";
+      std::cerr << "Usage: parser [--stream | --threaded] [input file]\n";
+      std::cerr << "       parser --check [input file] [grammar file]\n";
+      std::cerr << "       parser --ir | --opt [input file] [grammar file]\n";
+      std::cerr << "       parser --lr | --glr | --peg [input file] [grammar file]\n";
+      std::cerr << "       parser --regen GRAMMAR_FILE EDITED_GRAMMAR_FILE\n";
+      std::cerr << "       parser --program [input file] [grammar file] [threads]\n";
+      std::cerr << "       parser --batch [--grammar FILE] [--threads N] [--dump-tokens DIR] [--io MODE] [--quiet] inputs...\n";
+      std::cerr << "       parser --serve SOCKET [--threads N] [NAME=GRAMMAR_FILE ...]\n";
+      std::cerr << "       any mode: --metrics json|prom  (written to Outputs/metrics.json / .prom)\n";
+      return 1;
+    }
+
+    // each step is a metrics phase (wall + cpu time), see --metrics
+    PhaseTimer readTimer("read");
     std::string input = readInputFile();
-    std::cout << "Read input from file.\n";
+    readTimer.stop();
 
+    PhaseTimer lexTimer("lex");
     Lexer lexer(input);
     std::vector<Token> tokens = lexer.tokenize();
-    std::cout << "Lexing complete.\n";
+    lexTimer.stop();
+
+    PhaseTimer writeTimer("write_tokens");
     writeTokens(tokens);
+    writeTimer.stop();
     std::cout << "Tokens saved to Outputs/tokens.txt\n";
 
     ParseTableGenerator gen;
+    PhaseTimer loadTimer("load_grammar");
     if (!gen.loadGrammar("ex_input/grammar.txt")) {
       std::cerr << "Failed to load grammar.\n";
       return 1;
     }
-    std::cout << "Grammar loaded \n";
+    loadTimer.stop();
 
-    std::cout << "Generating First/Follow sets and Parse Table...\n";
+    PhaseTimer tableTimer("generate_table");
     gen.generateTable(); 
     // i should add a check here / make the gentable function return bool for an easy check w / cond
-    std::cout << "Parse Table generation process completed.\n";
+    tableTimer.stop();
 
     LL1Parser ll1Parser(
       tokens,
@@ -59,14 +647,17 @@ int main() {
       gen.getStartSymbol() // Get start symbol from gen
     );
 
-    std::cout << "Starting LL1 Parsing process...\n";
-    if (!ll1Parser.parse()) {
+    PhaseTimer parseTimer("parse");
+    bool parsed = ll1Parser.parse();
+    parseTimer.stop();
+    if (!parsed) {
       std::cerr << "\nParsing failed.\n";
       return 1;
     }
 
     // Success
     std::cout << "\nParsing completed successfully.\n";
+    if (PARSER_METRICS_ENABLED) std::cout << "Phases: " << ParserMetrics::global().phaseSummary() << "\n";
 
     return 0;
 
@@ -77,4 +668,42 @@ int main() {
     std::cerr << "\nAn unknown error occurred." << std::endl;
     return 1;
   }
-}
\ No newline at end of file
+}
+
+// Writes the counters + phase times to Outputs/metrics.json or Outputs/metrics.prom
+bool writeMetrics(const std::string& format) {
+  if (!PARSER_METRICS_ENABLED) {
+    std::cerr << "Built with PARSER_NO_METRICS, no metrics to write.\n";
+    return false;
+  }
+  bool prom = format == "prom" || format == "prometheus";
+  if (!prom && format != "json") {
+    std::cerr << "Unknown metrics format: " << format << " (json or prom)\n";
+    return false;
+  }
+  std::string filename = prom ? "Outputs/metrics.prom" : "Outputs/metrics.json";
+  std::ofstream out(filename);
+  if (!out) {
+    std::cerr << "Could not open metrics output file: " << filename << "\n";
+    return false;
+  }
+  out << (prom ? ParserMetrics::global().toPrometheus() : ParserMetrics::global().toJson() + "\n");
+  std::cout << "Metrics saved to " << filename << "\n";
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  // --metrics FORMAT works with every mode, the mode never sees it
+  std::string metricsFormat;
+  std::vector<char*> args;
+  for (int i = 0; i < argc; ++i) {
+    if (std::string(argv[i]) == "--metrics" && i + 1 < argc) metricsFormat = argv[++i];
+    else args.push_back(argv[i]);
+  }
+  int argCount = (int)args.size();
+  args.push_back(nullptr);
+
+  int rc = runMode(argCount, args.data());
+  if (!metricsFormat.empty() && !writeMetrics(metricsFormat)) rc = rc ? rc : 1;
+  return rc;
+}
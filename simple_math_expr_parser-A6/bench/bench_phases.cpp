@@ -0,0 +1,170 @@
+// Phase benchmarks for the enum-typed pipeline: Lexer::tokenize,
+// ParseTableGenerator (loadGrammar + generateTable), LL1Parser::parse, the
+// shared LL1Engine with the TokenType policy, the same loop written out by
+// hand for TokenType (the engine should match it) and the recursive descent
+// Parser, on small / medium / huge inputs and small / large grammars.
+// Timing, allocation counting and the JSON / baseline handling are shared
+// with the string-typed bench (mathExprParser- NoTokenType/bench).
+//
+// g++ -O2 -pthread bench/bench_phases.cpp -o bench_phases
+// ./bench_phases [--sizes small,medium,huge] [--huge BYTES] [--json results.json]
+//                [--baseline baseline.json] [--threshold PCT]
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../../mathExprParser- NoTokenType/bench/bench_util.h"
+#include "../include/lexer.h"
+#include "../include/LL1_parser_ET.h"
+#include "../../mathExprParser- NoTokenType/include/parse_table_gen.h"
+#include "../include/RD_parser.h"
+#include "../include/token_policy.h"
+
+// LL1Engine's parse loop written directly against TokenType, no policy, no
+// templates: the overhead baseline for the enum instantiation
+class HandLL1 {
+  static constexpr size_t COLS = (size_t)TokenType::INVALID + 1;
+  int terminalCount = 0, start = -1, end = -1;
+  int kindTerminal[COLS];
+  std::vector<int32_t> table;
+  std::vector<int> rhs;
+  std::vector<uint32_t> rhsStart;
+  std::vector<int> stack;
+
+public:
+  HandLL1(const ParseTable& pt, const std::set<std::string>& terms,
+          const std::set<std::string>& nonterms, const std::string& startSym) {
+    std::map<std::string, int> ids;
+    for (const auto& t : terms) if (t != "epsilon") ids.emplace(t, (int)ids.size());
+    ids.emplace("$", (int)ids.size());
+    terminalCount = (int)ids.size();
+    for (const auto& nt : nonterms) ids.emplace(nt, (int)ids.size());
+    start = ids.at(startSym);
+    end = ids.at("$");
+    for (size_t k = 0; k < COLS; ++k) {
+      auto it = ids.find(TokenTypeTraits::terminal((TokenType)k));
+      kindTerminal[k] = it != ids.end() && it->second < terminalCount ? it->second : -1;
+    }
+    table.assign(nonterms.size() * COLS, -1);
+    rhsStart.push_back(0);
+    for (const auto& row : pt) {
+      int nt = ids.at(row.first) - terminalCount;
+      for (const auto& cell : row.second) {
+        for (size_t i = cell.second.size(); i-- > 0;) {
+          if (cell.second[i] != "epsilon") rhs.push_back(ids.at(cell.second[i]));
+        }
+        rhsStart.push_back((uint32_t)rhs.size());
+        for (size_t k = 0; k < COLS; ++k) {
+          if (kindTerminal[k] >= 0 && cell.first == TokenTypeTraits::terminal((TokenType)k)) {
+            table[nt * COLS + k] = (int32_t)rhsStart.size() - 2;
+          }
+        }
+      }
+    }
+  }
+
+  bool parse(const std::vector<Token>& tokens) {
+    stack.clear();
+    stack.push_back(end);
+    stack.push_back(start);
+    size_t i = 0;
+    while (!stack.empty()) {
+      int top = stack.back();
+      size_t k = (size_t)tokens[i].type;
+      if (top < terminalCount) {
+        if (kindTerminal[k] != top) return false;
+        stack.pop_back();
+        if (top == end) return true;
+        i++;
+        continue;
+      }
+      int32_t p = table[(top - terminalCount) * COLS + k];
+      if (p < 0) return false;
+      stack.pop_back();
+      stack.insert(stack.end(), rhs.begin() + rhsStart[p], rhs.begin() + rhsStart[p + 1]);
+    }
+    return false;
+  }
+};
+
+struct GrammarCase {
+  std::string name;
+  std::string file;
+  std::string (*makeInput)(size_t);
+};
+
+int main(int argc, char* argv[]) {
+  BenchArgs args = parseBenchArgs(argc, argv);
+
+  // datatype stays a terminal here, the enum lexer hands out DATATYPE -> "datatype"
+  std::vector<GrammarCase> grammars = {
+    {"decl", "Outputs/bench_decl_grammar.txt", makeDeclInput},
+    {"expr", "Outputs/bench_expr_grammar.txt", makeExprInput},
+  };
+  writeFile(grammars[0].file, "Decl : datatype id L ;\nL : , id L\nL : epsilon\n");
+  writeFile(grammars[1].file, exprGrammarText());
+
+  // ---- table generation ----
+  std::vector<std::pair<std::string, std::string>> tableCases = {
+    {"table/decl", grammars[0].file},
+    {"table/expr", grammars[1].file},
+    {"table/large-300", "Outputs/bench_large_grammar.txt"},
+  };
+  writeFile(tableCases[2].second, largeGrammarText(300));
+  for (const auto& tc : tableCases) {
+    runBench(tc.first + "/enum", 1, 0, [&]() {
+      ParseTableGenerator gen;
+      gen.loadGrammar(tc.second);
+      gen.generateTable();
+    });
+  }
+
+  // ---- lexing and parsing ----
+  for (const auto& g : grammars) {
+    ParseTableGenerator gen;
+    {
+      QuietCout quiet;
+      gen.loadGrammar(g.file);
+      gen.generateTable();
+    }
+    ParseTable table = gen.getParseTable();
+    std::set<std::string> terms = gen.getTerminals();
+    std::set<std::string> nonterms = gen.getNonTerminals();
+
+    for (const auto& sz : args.sizes) {
+      std::string input = g.makeInput(sz.second);
+      std::vector<Token> tokens = Lexer(input).tokenize();
+      std::string tag = g.name + "/" + sz.first + "/enum";
+
+      runBench("lex/" + tag, tokens.size(), input.size(), [&]() {
+        Lexer lexer(input);
+        std::vector<Token> t = lexer.tokenize();
+      });
+
+      std::string start = gen.getStartSymbol();
+      runBench("ll1/" + tag, tokens.size(), input.size(), [&]() {
+        LL1Parser parser(tokens, table, terms, nonterms, start);
+        if (!parser.parse()) std::cerr << "ll1 parse failed on " << tag << "\n";
+      });
+
+      EnumLL1Engine engine(table, terms, nonterms, start);
+      runBench("engine/" + tag, tokens.size(), input.size(), [&]() {
+        if (!engine.parse(tokens)) std::cerr << "engine parse failed on " << tag << "\n";
+      });
+
+      HandLL1 hand(table, terms, nonterms, start);
+      runBench("hand/" + tag, tokens.size(), input.size(), [&]() {
+        if (!hand.parse(tokens)) std::cerr << "hand parse failed on " << tag << "\n";
+      });
+
+      if (g.name != "expr") continue;
+      runBench("rd/" + tag, tokens.size(), input.size(), [&]() {
+        Parser parser(tokens);
+        parser.parse();
+      });
+    }
+  }
+
+  return finishBench(args);
+}
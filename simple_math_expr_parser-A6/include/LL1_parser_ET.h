@@ -10,7 +10,9 @@
 #include <map>
 #include <set>
 #include <stdexcept>
+#include <memory>
 #include "lexer.h"
+#include "token_policy.h" // EnumLL1Engine, the shared LL(1) driver
 
 using ParseTable = std::map<std::string, std::map<std::string, std::vector<std::string>>>;
 
@@ -32,7 +34,9 @@ std::string tokenTypeToStringParser(TokenType type) {
   }
 }
 
-class LL1Parser {
+// Tracing front end over the shared LL(1) engine (EnumLL1Engine): the engine
+// parses, this prints every step and the errors.
+class LL1Parser : private LL1Trace {
 public:
   ParseTable table;
   std::set<std::string> terminals;
@@ -41,10 +45,11 @@ public:
   std::vector<Token> tokens;
 
   LL1Parser(const std::vector<Token>& t, const ParseTable& parseTable,
-            const std::set<std::string>& terms, const std::set<std::string>& nonTerms)
-      : tokens(t), table(parseTable), terminals(terms), nonTerminals(nonTerms), startSymbol("") {
-    // set start symbol to the first non-terminal in the parse table
-    if (!nonTerminals.empty()) {
+            const std::set<std::string>& terms, const std::set<std::string>& nonTerms,
+            const std::string& start = "")
+      : table(parseTable), terminals(terms), nonTerminals(nonTerms), startSymbol(start), tokens(t) {
+    // no start symbol given: the first non-terminal in the parse table
+    if (startSymbol.empty() && !nonTerminals.empty()) {
       startSymbol = *nonTerminals.begin();
     }
     // Log grammar symbols for debugging
@@ -129,6 +134,7 @@ public:
 */
 
   bool loadParseTable(const std::string& filename) {
+    engine.reset(); // rebuilt from the new table by parse()
     std::ifstream file(filename);
     if (!file.is_open()) {
       std::cerr << "Error: Could not open parse table file.\n";
@@ -175,68 +181,55 @@ public:
   }
 
   bool parse() {
-    int tokenIndex = 0;
-    std::stack<std::string> parseStack;
-    parseStack.push("$");
-    parseStack.push(startSymbol);
-
-    while (!parseStack.empty()) {
-      std::string top = parseStack.top();
-
-      std::string currentTokenStr = (tokenIndex < tokens.size()) ?
-          tokenTypeToStringParser(tokens[tokenIndex].type) : "$";
-      std::string currentLexeme = (tokenIndex < tokens.size()) ?
-          tokens[tokenIndex].lexeme : "EOF";
-
-      std::cout << "Stack top: '" << top << "', Current token: '" << currentTokenStr
-                << "' (lexeme: '" << currentLexeme << "')\n";
-
-      if (terminals.count(top)) {
-        if (top == currentTokenStr) {
-          std::cout << "Matched terminal: '" << currentLexeme << "'\n";
-          parseStack.pop();
-          if (top == "$") {
-            std::cout << "Parse successful!\n";
-            return true;
-          }
-          tokenIndex++;
-        } else {
-          std::cerr << "Syntax Error: Unexpected token '" << currentLexeme
-                    << "'. Expected: '" << top << "'.\n";
-          return false;
-        }
-      } else if (nonTerminals.count(top)) {
-        if (table.count(top) && table[top].count(currentTokenStr)) {
-          const std::vector<std::string>& production = table[top][currentTokenStr];
-          std::cout << "Applying rule: " << top << " -> ";
-          for (const auto& sym : production) {
-            std::cout << "'" << sym << "' ";
-          }
-          std::cout << "\n";
-          parseStack.pop();
-          if (!(production.size() == 1 && production[0] == "epsilon")) {
-            for (int i = production.size() - 1; i >= 0; --i) {
-              parseStack.push(production[i]);
-            }
-          }
-        } else {
-          std::cerr << "Syntax Error: No production for '" << top
-                    << "' with token '" << currentTokenStr << "'.\n";
-          return false;
-        }
-      } else {
-        std::cerr << "Internal Error: Unknown symbol on stack: '" << top << "'.\n";
-        return false;
-      }
+    if (!engine) {
+      engine.reset(new EnumLL1Engine(table, terminals, nonTerminals, startSymbol));
+      engine->setErrorStream(nullptr); // errors are printed by the trace below
+      engine->setTrace(this);
     }
-
-    if (tokenIndex == tokens.size()) {
+    reported = false;
+    if (engine->parse(tokens)) {
       std::cout << "Parse successful!\n";
       return true;
-    } else {
-      std::cerr << "Syntax Error: Parsing did not complete correctly.\n";
-      return false;
     }
+    if (!reported) std::cerr << engine->getError(); // no start symbol, no EOF token at the end
+    return false;
+  }
+
+private:
+  std::unique_ptr<EnumLL1Engine> engine;
+  bool reported = false;
+
+  void step(const std::string& top, size_t i) override {
+    std::cout << "Stack top: '" << top << "', Current token: '" << tokenTypeToStringParser(tokens[i].type)
+              << "' (lexeme: '" << tokens[i].lexeme << "')\n";
+  }
+
+  void match(const std::string&, size_t i) override {
+    std::cout << "Matched terminal: '" << tokens[i].lexeme << "'\n";
+  }
+
+  void expand(const std::string& nonTerminal, const std::vector<std::string>& body, size_t) override {
+    std::cout << "Applying rule: " << nonTerminal << " -> ";
+    for (const auto& sym : body) {
+      std::cout << "'" << sym << "' ";
+    }
+    std::cout << "\n";
+  }
+
+  void mismatch(const std::string& expected, size_t i) override {
+    reported = true;
+    if (expected != "$" && !terminals.count(expected)) {
+      std::cerr << "Internal Error: Unknown symbol on stack: '" << expected << "'.\n";
+      return;
+    }
+    std::cerr << "Syntax Error: Unexpected token '" << tokens[i].lexeme
+              << "'. Expected: '" << expected << "'.\n";
+  }
+
+  void noProduction(const std::string& nonTerminal, size_t i) override {
+    reported = true;
+    std::cerr << "Syntax Error: No production for '" << nonTerminal
+              << "' with token '" << tokenTypeToStringParser(tokens[i].type) << "'.\n";
   }
 };
 
@@ -6,29 +6,127 @@
 #include <stdexcept>
 #include <fstream>
 
+// Expression parser for
+//   Exp -> Term Expr     Expr  -> + Term Expr | - Term Expr | e
+//   Term -> Factor Termp Termp -> * Factor Termp | / Factor Termp | e
+//   Factor -> ( Exp ) | ID | NUMBER
+// done as iterative precedence climbing (shunting yard) instead of one C++
+// call per grammar rule: operators and open parens wait on an explicit stack,
+// so long flat sums use O(1) stack and deep nesting uses O(depth) heap
+// memory instead of overflowing the call stack.
+// binary operators come from a precedence table that can be changed at runtime.
 class Parser {
 public:
-    Parser(const std::vector<Token>& tokens) : tokens(tokens), current(0) {}
+    struct OpInfo {
+        int precedence;   // 0 = not a binary operator
+        bool rightAssoc;
+    };
 
-    void parse() {
-        parseExp();
+    Parser(const std::vector<Token>& tokens) : tokens(tokens), current(0),
+        ops((size_t)TokenType::INVALID + 1, OpInfo{0, false}) {
+        // default table, * and / bind tighter than + and -
+        setOperator(TokenType::PLUS, 10);
+        setOperator(TokenType::MINUS, 10);
+        setOperator(TokenType::TIMES, 20);
+        setOperator(TokenType::DIVIDE, 20);
+    }
+
+    // Add / change a binary operator (precedence > 0), or remove it (precedence 0)
+    void setOperator(TokenType type, int precedence, bool rightAssoc = false) {
+        if (type == TokenType::LPAREN || type == TokenType::RPAREN || type == TokenType::END_OF_FILE) {
+            throw std::runtime_error("Cannot use " + tokenTypeToString(type) + " as a binary operator");
+        }
+        ops[(size_t)type] = OpInfo{precedence, rightAssoc};
+    }
+
+    const OpInfo& getOperator(TokenType type) const {
+        return ops[(size_t)type];
+    }
+
+    // Validates the expression, throws std::runtime_error on a syntax error.
+    // if postfix is given it receives the operand / operator tokens in
+    // postfix (RPN) order, ready for evaluation or tree building.
+    void parse(std::vector<const Token*>* postfix = nullptr) {
+        current = 0;
+        pending.clear();
+        openParens = 0;
+        maxDepth = 0;
+        out = postfix;
+        if (out) out->clear();
+
+        bool expectOperand = true;
+        while (true) {
+            const Token& tok = currentToken();
+            if (expectOperand) {
+                if (tok.type == TokenType::LPAREN) {
+                    push(nullptr); // open paren marker
+                    openParens++;
+                    current++;
+                } else if (tok.type == TokenType::ID || tok.type == TokenType::NUMBER) {
+                    if (out) out->push_back(&tok);
+                    current++;
+                    expectOperand = false;
+                } else {
+                    throw std::runtime_error("Expected ID, NUMBER, or '('");
+                }
+                continue;
+            }
+
+            const OpInfo& info = ops[(size_t)tok.type];
+            if (info.precedence > 0) {
+                // reduce everything that binds at least as tight (left assoc)
+                while (!pending.empty() && pending.back() != nullptr) {
+                    const OpInfo& top = ops[(size_t)pending.back()->type];
+                    if (top.precedence > info.precedence ||
+                        (top.precedence == info.precedence && !info.rightAssoc)) {
+                        reduce();
+                    } else {
+                        break;
+                    }
+                }
+                push(&tok);
+                current++;
+                expectOperand = true;
+            } else if (tok.type == TokenType::RPAREN && openParens > 0) {
+                while (pending.back() != nullptr) reduce();
+                pending.pop_back(); // the '('
+                openParens--;
+                current++;
+            } else {
+                break; // end of the expression
+            }
+        }
+
+        while (!pending.empty()) {
+            if (pending.back() == nullptr) {
+                throw std::runtime_error("Expected " + tokenTypeToString(TokenType::RPAREN) +
+                                         " but got " + currentToken().typeToString());
+            }
+            reduce();
+        }
         if (currentToken().type != TokenType::END_OF_FILE) {
             throw std::runtime_error("Unexpected token at end of input");
         }
     }
 
+    // deepest the operator / paren stack got in the last parse
+    size_t maxStackDepth() const {
+        return maxDepth;
+    }
+
 private:
     const Token& currentToken() const {
         return tokens[current];
     }
 
-    void consume(TokenType expected) {
-        if (currentToken().type == expected) {
-            current++;
-        } else {
-            throw std::runtime_error("Expected " + tokenTypeToString(expected) +
-                                   " but got " + currentToken().typeToString());
-        }
+    void push(const Token* t) {
+        pending.push_back(t);
+        if (pending.size() > maxDepth) maxDepth = pending.size();
+    }
+
+    void reduce() {
+        if (out) out->push_back(pending.back());
+        pending.pop_back();
     }
 
     std::string tokenTypeToString(TokenType type) const {
@@ -46,51 +144,13 @@ private:
         }
     }
 
-    void parseExp() {
-        parseTerm();
-        parseExpr();
-    }
-
-    void parseExpr() {
-        if (currentToken().type == TokenType::PLUS ||
-            currentToken().type == TokenType::MINUS) {
-            consume(currentToken().type);
-            parseTerm();
-            parseExpr();
-        }
-    }
-
-    void parseTerm() {
-        parseFactor();
-        parseTermP();
-    }
-
-    void parseTermP() {
-        if (currentToken().type == TokenType::TIMES ||
-            currentToken().type == TokenType::DIVIDE) {
-            consume(currentToken().type);
-            parseFactor();
-            parseTermP();
-        }
-    }
-
-    void parseFactor() {
-        if (currentToken().type == TokenType::LPAREN) {
-            consume(TokenType::LPAREN);
-            parseExp();
-            consume(TokenType::RPAREN);
-        }
-        else if (currentToken().type == TokenType::ID ||
-                 currentToken().type == TokenType::NUMBER) {
-            consume(currentToken().type);
-        }
-        else {
-            throw std::runtime_error("Expected ID, NUMBER, or '('");
-        }
-    }
-
-    std::vector<Token> tokens;
+    const std::vector<Token>& tokens; // not copied
     size_t current;
+    std::vector<OpInfo> ops;              // precedence table, indexed by TokenType
+    std::vector<const Token*> pending;    // waiting operators, nullptr = open paren
+    size_t openParens = 0;
+    size_t maxDepth = 0;
+    std::vector<const Token*>* out = nullptr;
 };
 
 #endif // PARSER_H
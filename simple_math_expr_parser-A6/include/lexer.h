@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <cctype>
+#include "../../mathExprParser- NoTokenType/include/number_literal.h" // shared with the string-typed tree
 
 enum class TokenType {
     ID, NUMBER, DATATYPE,
@@ -16,6 +17,7 @@ enum class TokenType {
 struct Token {
     TokenType type;
     std::string lexeme;
+    NumberValue number; // NUMBER tokens: the value, decoded while scanning
 
     Token(TokenType t, const std::string& l) : type(t), lexeme(l) {}
 
@@ -92,10 +94,13 @@ private:
         return Token(TokenType::ID, res);
     }
 
-    Token scanNumber() { // same as the above code really but just digits.
+    Token scanNumber() { // same as the above code really but just digits, value decoded on the way
         size_t start = pos;
-        while (pos < input.size() && isdigit(input[pos])) pos++;
-        return Token(TokenType::NUMBER, input.substr(start, pos - start));
+        NumberValue value;
+        pos += scanIntegerLiteral(input.data() + pos, input.data() + input.size(), value);
+        Token token(TokenType::NUMBER, input.substr(start, pos - start));
+        token.number = value;
+        return token;
     }
 
     std::string input;
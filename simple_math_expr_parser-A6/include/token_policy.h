@@ -0,0 +1,35 @@
+#ifndef TOKEN_POLICY_H
+#define TOKEN_POLICY_H
+
+#include "lexer.h"
+#include "../../mathExprParser- NoTokenType/include/ll1_engine.h"
+
+// TokenType as a compile time token policy for the shared LL1Engine:
+// kindOf() is a cast and the table stride is a constant.
+// grammar terminals are the same as tokenTypeToStringParser()
+struct TokenTypeTraits {
+    using Kind = TokenType;
+    static constexpr size_t count = (size_t)TokenType::INVALID + 1;
+
+    static const char* terminal(TokenType type) {
+        switch (type) {
+            case TokenType::ID: return "id";
+            case TokenType::NUMBER: return "id";
+            case TokenType::DATATYPE: return "datatype";
+            case TokenType::PLUS: return "+";
+            case TokenType::MINUS: return "-";
+            case TokenType::TIMES: return "*";
+            case TokenType::DIVIDE: return "/";
+            case TokenType::LPAREN: return "(";
+            case TokenType::RPAREN: return ")";
+            case TokenType::COMMA: return ",";
+            case TokenType::SEMICOLON: return ";";
+            case TokenType::END_OF_FILE: return "$";
+            default: return "";
+        }
+    }
+};
+
+using EnumLL1Engine = LL1Engine<EnumTokenPolicy<TokenTypeTraits>>;
+
+#endif // TOKEN_POLICY_H
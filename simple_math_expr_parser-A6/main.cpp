@@ -6,7 +6,7 @@
 // #include "include/RD_parser.h" // Unused, kept for reference
 #include "include/lexer.h"
 #include "include/LL1_parser_ET.h"
-#include "include/parse_table_gen.h"
+#include "../mathExprParser- NoTokenType/include/parse_table_gen.h" // shared with the string-typed tree
 
 std::string readInputFile() {
   std::ifstream file("ex_input/input.txt");
@@ -41,7 +41,8 @@ int main() {
     }
     gen.generateTable();
 
-    LL1Parser ll1Parser(tokens, gen.getParseTable(), gen.getTerminals(), gen.getNonTerminals());
+    LL1Parser ll1Parser(tokens, gen.getParseTable(), gen.getTerminals(), gen.getNonTerminals(),
+                        gen.getStartSymbol());
 
     if (!ll1Parser.parse()) {
       std::cerr << "Parsing failed due to syntax errors.\n";